@@ -71,7 +71,8 @@ update_plugin (PeasGtkPluginManagerStore *store,
   const gchar *icon_name;
   GdkPixbuf *icon_pixbuf = NULL;
 
-  loaded = peas_plugin_info_is_loaded (info);
+  loaded = peas_plugin_info_is_loaded (info) ||
+           peas_engine_is_plugin_deferred (store->priv->engine, info);
   available = peas_plugin_info_is_available (info, NULL);
   builtin = peas_plugin_info_is_builtin (info);
 
@@ -126,16 +126,14 @@ static GList *
 get_dependant_plugins (PeasGtkPluginManagerView *view,
                        PeasPluginInfo           *info)
 {
-  const gchar *module_name;
-  const GList *plugins;
+  GList *plugins, *item;
   GList *dep_plugins = NULL;
 
-  module_name = peas_plugin_info_get_module_name (info);
-  plugins = peas_engine_get_plugin_list (view->priv->engine);
+  plugins = peas_engine_get_dependants (view->priv->engine, info);
 
-  for (; plugins != NULL; plugins = plugins->next)
+  for (item = plugins; item != NULL; item = item->next)
     {
-      PeasPluginInfo *plugin = (PeasPluginInfo *) plugins->data;
+      PeasPluginInfo *plugin = (PeasPluginInfo *) item->data;
 
       if (peas_plugin_info_is_hidden (plugin) ||
           !peas_plugin_info_is_loaded (plugin))
@@ -145,10 +143,11 @@ get_dependant_plugins (PeasGtkPluginManagerView *view,
       if (!view->priv->show_builtin && peas_plugin_info_is_builtin (plugin))
         continue;
 
-      if (peas_plugin_info_has_dependency (plugin, module_name))
-        dep_plugins = g_list_prepend (dep_plugins, plugin);
+      dep_plugins = g_list_prepend (dep_plugins, plugin);
     }
 
+  g_list_free (plugins);
+
   return dep_plugins;
 }
 
@@ -160,7 +159,7 @@ toggle_enabled (PeasGtkPluginManagerView *view,
 
   info = peas_gtk_plugin_manager_store_get_plugin (view->priv->store, iter);
 
-  if (peas_plugin_info_is_loaded (info))
+  if (peas_gtk_plugin_manager_store_get_enabled (view->priv->store, iter))
     {
       GList *dep_plugins;
 
@@ -333,7 +332,9 @@ create_popup_menu (PeasGtkPluginManagerView *view)
 
   item = gtk_check_menu_item_new_with_mnemonic (_("_Enabled"));
   gtk_check_menu_item_set_active (GTK_CHECK_MENU_ITEM (item),
-                                  peas_plugin_info_is_loaded (info));
+                                  peas_plugin_info_is_loaded (info) ||
+                                  peas_engine_is_plugin_deferred (view->priv->engine,
+                                                                  info));
   g_signal_connect (item, "toggled", G_CALLBACK (enabled_menu_cb), view);
   gtk_widget_set_sensitive (item, peas_plugin_info_is_available (info, NULL) &&
                                   !peas_plugin_info_is_builtin (info));
@@ -25,6 +25,7 @@
 
 #include "peas-debug.h"
 
+gboolean _peas_debug_enabled = FALSE;
 
 static void
 debug_log_handler (const gchar    *log_domain,
@@ -48,6 +49,8 @@ peas_debug_init (void)
     {
       const gchar *g_messages_debug;
 
+      _peas_debug_enabled = TRUE;
+
       g_messages_debug = g_getenv ("G_MESSAGES_DEBUG");
 
       if (g_messages_debug == NULL)
@@ -27,8 +27,24 @@
 
 G_BEGIN_DECLS
 
+/* Only read, set once by peas_debug_init() */
+extern gboolean _peas_debug_enabled;
+
 void  peas_debug_init (void);
 
+/* Unlike g_debug() the arguments are not even evaluated unless
+ * PEAS_DEBUG is set, use it for the code that runs on every call
+ */
+#ifdef PEAS_DISABLE_DEBUG
+#define peas_debug(...) G_STMT_START { } G_STMT_END
+#else
+#define peas_debug(...) \
+  G_STMT_START { \
+    if (G_UNLIKELY (_peas_debug_enabled)) \
+      g_debug (__VA_ARGS__); \
+  } G_STMT_END
+#endif
+
 G_END_DECLS
 
 #endif /* __PEAS_DEBUG_H__ */
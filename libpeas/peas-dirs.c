@@ -143,3 +143,15 @@ peas_dirs_get_locale_dir (void)
   return locale_dir;
 }
 
+gchar *
+peas_dirs_get_plugin_cache_dir (void)
+{
+  const gchar *env_var;
+
+  env_var = g_getenv ("PEAS_PLUGIN_CACHE_DIR");
+  if (env_var != NULL)
+    return g_strdup (env_var);
+
+  return g_build_filename (g_get_user_cache_dir (), "libpeas-1.0",
+                           "plugins", NULL);
+}
@@ -31,6 +31,7 @@ gchar  *peas_dirs_get_data_dir           (void);
 gchar  *peas_dirs_get_lib_dir            (void);
 gchar  *peas_dirs_get_plugin_loaders_dir (void);
 gchar  *peas_dirs_get_locale_dir         (void);
+gchar  *peas_dirs_get_plugin_cache_dir   (void);
 
 G_END_DECLS
 
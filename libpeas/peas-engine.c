@@ -30,13 +30,17 @@
 #include "peas-engine.h"
 #include "peas-engine-priv.h"
 #include "peas-plugin-info-priv.h"
+#include "peas-plugin-cache.h"
 #include "peas-plugin-loader.h"
 #include "peas-plugin-loader-c.h"
 #include "peas-object-module.h"
 #include "peas-extension.h"
 #include "peas-dirs.h"
 #include "peas-debug.h"
+#include "peas-profile.h"
+#include "peas-trace.h"
 #include "peas-helpers.h"
+#include "peas-introspection.h"
 
 /**
  * SECTION:peas-engine
@@ -75,6 +79,10 @@ enum {
   PROP_0,
   PROP_PLUGIN_LIST,
   PROP_LOADED_PLUGINS,
+  PROP_PARALLEL_SCAN,
+  PROP_MONITOR_SEARCH_PATHS,
+  PROP_PARALLEL_LOAD,
+  PROP_LAZY_LOAD,
   N_PROPERTIES
 };
 
@@ -89,16 +97,45 @@ struct _LoaderInfo {
 };
 
 typedef struct _SearchPath {
+  PeasEngine *engine;
   gchar *module_dir;
   gchar *data_dir;
+
+  /* Maps the monitored directories to their GFileMonitor,
+   * NULL unless PeasEngine:monitor-search-paths is set
+   */
+  GHashTable *monitors;
 } SearchPath;
 
 struct _PeasEnginePrivate {
   GList *search_paths;
 
+  /* The list is kept for peas_engine_get_plugin_list(),
+   * lookups by module name go through the index
+   */
   GList *plugin_list;
+  GHashTable *plugin_index;
+
+  /* Maps a module name to the PeasPluginInfos that depend on it,
+   * the forward edges are the dependencies of the PeasPluginInfos
+   */
+  GHashTable *dependants;
+
+  /* Maps an extension type name to the PeasPluginInfos
+   * that declare it in their Extensions key
+   */
+  GHashTable *providers;
+
+  /* The PeasPluginInfos that were enabled with
+   * PeasEngine:lazy-load set but are not loaded yet
+   */
+  GHashTable *deferred;
 
   guint in_dispose : 1;
+  guint parallel_scan : 1;
+  guint monitor_search_paths : 1;
+  guint parallel_load : 1;
+  guint lazy_load : 1;
 };
 
 static void peas_engine_load_plugin_real   (PeasEngine     *engine,
@@ -106,79 +143,525 @@ static void peas_engine_load_plugin_real   (PeasEngine     *engine,
 static void peas_engine_unload_plugin_real (PeasEngine     *engine,
                                             PeasPluginInfo *info);
 
+/* A Scan finds the plugin infos of a batch of search paths. The
+ * directories are enumerated and the .plugin files are parsed on a
+ * GThreadPool when the PeasEngine:parallel-scan property is set, the
+ * results are then merged into the engine on the calling thread in
+ * the order of the search paths.
+ */
+typedef struct _Scan Scan;
+typedef struct _ScanJob ScanJob;
+typedef struct _ScanItem ScanItem;
+
+struct _Scan {
+  /* Both are NULL when scanning serially */
+  GThreadPool *dir_pool;
+  GThreadPool *parse_pool;
+
+  GMutex lock;
+  GCond cond;
+  guint n_pending;
+
+  GPtrArray *jobs;
+};
+
+/* One per search path */
+struct _ScanJob {
+  Scan *scan;
+  SearchPath *sp;
+  PeasPluginCache *cache;
+
+  /* The ScanItems in the order they were found */
+  GPtrArray *items;
+};
+
+struct _ScanItem {
+  ScanJob *job;
+  gchar *filename;
+  gchar *module_dir;
+  PeasPluginInfo *info;
+
+  /* Reported when merging, not on the thread that parsed the file */
+  GError *error;
+};
+
 static void
-load_plugin_info (PeasEngine  *engine,
-                  const gchar *filename,
-                  const gchar *module_dir,
-                  const gchar *data_dir)
+scan_item_free (ScanItem *item)
 {
-  PeasPluginInfo *info;
-  const gchar *module_name;
+  if (item->info != NULL)
+    _peas_plugin_info_unref (item->info);
 
-  info = _peas_plugin_info_new (filename,
-                                module_dir,
-                                data_dir);
+  g_clear_error (&item->error);
+  g_free (item->filename);
+  g_free (item->module_dir);
+  g_slice_free (ScanItem, item);
+}
 
-  if (info == NULL)
-    {
-      g_warning ("Error loading '%s'", filename);
-      return;
-    }
+static void
+scan_job_free (ScanJob *job)
+{
+  if (job->cache != NULL)
+    peas_plugin_cache_close (job->cache);
+  g_ptr_array_unref (job->items);
+  g_slice_free (ScanJob, job);
+}
 
-  /* If a plugin with this name has already been loaded
-   * drop this one (user plugins override system plugins) */
-  module_name = peas_plugin_info_get_module_name (info);
-  if (peas_engine_get_plugin_info (engine, module_name) != NULL)
-    _peas_plugin_info_unref (info);
-  else
-    {
-      engine->priv->plugin_list = g_list_prepend (engine->priv->plugin_list,
-                                                  info);
+static void
+scan_push (Scan        *scan,
+           GThreadPool *pool,
+           gpointer     data)
+{
+  g_mutex_lock (&scan->lock);
+  scan->n_pending++;
+  g_mutex_unlock (&scan->lock);
 
-      g_object_notify_by_pspec (G_OBJECT (engine),
-                                properties[PROP_PLUGIN_LIST]);
-    }
+  g_thread_pool_push (pool, data, NULL);
 }
 
 static void
-load_dir_real (PeasEngine  *engine,
-               const gchar *module_dir,
-               const gchar *data_dir,
-               guint        recursions)
+scan_task_done (Scan *scan)
 {
+  g_mutex_lock (&scan->lock);
+
+  if (--scan->n_pending == 0)
+    g_cond_signal (&scan->cond);
+
+  g_mutex_unlock (&scan->lock);
+}
+
+static void
+scan_item_parse (ScanItem *item)
+{
+  gint64 begin_time = peas_trace_begin ();
+
+  item->info = peas_plugin_cache_load (item->job->cache,
+                                       item->filename,
+                                       item->module_dir,
+                                       item->job->sp->data_dir,
+                                       &item->error);
+
+  peas_trace_end ("parse", item->filename, begin_time);
+}
+
+static void
+scan_parse_thread (ScanItem *item,
+                   Scan     *scan)
+{
+  scan_item_parse (item);
+  scan_task_done (scan);
+}
+
+static void
+scan_dir (ScanJob     *job,
+          const gchar *module_dir,
+          guint        recursions)
+{
+  GFile *dir;
+  GFileEnumerator *enumerator;
+  GFileInfo *file_info;
   GError *error = NULL;
-  GDir *d;
-  const gchar *dirent;
+  gint64 begin_time = peas_trace_begin ();
 
   g_debug ("Loading %s/*.plugin...", module_dir);
 
-  d = g_dir_open (module_dir, 0, &error);
-
-  if (!d)
+  /* Only asking for the name and type lets the
+   * enumerator avoid a stat() for every entry
+   */
+  dir = g_file_new_for_path (module_dir);
+  enumerator = g_file_enumerate_children (dir,
+                                          G_FILE_ATTRIBUTE_STANDARD_NAME ","
+                                          G_FILE_ATTRIBUTE_STANDARD_TYPE,
+                                          G_FILE_QUERY_INFO_NONE,
+                                          NULL, &error);
+  g_object_unref (dir);
+
+  if (enumerator == NULL)
     {
       g_debug ("%s", error->message);
       g_error_free (error);
+      peas_trace_end ("scan", module_dir, begin_time);
       return;
     }
 
-  while ((dirent = g_dir_read_name (d)))
+  while ((file_info = g_file_enumerator_next_file (enumerator,
+                                                   NULL, &error)) != NULL)
     {
-      gchar *filename = g_build_filename (module_dir, dirent, NULL);
+      const gchar *name = g_file_info_get_name (file_info);
+      gchar *filename = g_build_filename (module_dir, name, NULL);
 
-      if (g_file_test (filename, G_FILE_TEST_IS_DIR))
+      if (g_file_info_get_file_type (file_info) == G_FILE_TYPE_DIRECTORY)
         {
           if (recursions > 0)
-            load_dir_real (engine, filename, data_dir, recursions - 1);
+            scan_dir (job, filename, recursions - 1);
         }
-      else if (g_str_has_suffix (dirent, ".plugin"))
+      else if (g_str_has_suffix (name, ".plugin"))
         {
-          load_plugin_info (engine, filename, module_dir, data_dir);
+          ScanItem *item = g_slice_new0 (ScanItem);
+
+          item->job = job;
+          item->filename = filename;
+          item->module_dir = g_strdup (module_dir);
+          g_ptr_array_add (job->items, item);
+
+          if (job->scan->parse_pool == NULL)
+            scan_item_parse (item);
+          else
+            scan_push (job->scan, job->scan->parse_pool, item);
+
+          filename = NULL;
         }
 
       g_free (filename);
+      g_object_unref (file_info);
     }
 
-  g_dir_close (d);
+  if (error != NULL)
+    {
+      g_debug ("%s", error->message);
+      g_error_free (error);
+    }
+
+  g_object_unref (enumerator);
+
+  peas_trace_end ("scan", module_dir, begin_time);
+}
+
+static void
+scan_dir_thread (ScanJob *job,
+                 Scan    *scan)
+{
+  scan_dir (job, job->sp->module_dir, 1);
+  scan_task_done (scan);
+}
+
+static Scan *
+scan_new (gboolean parallel)
+{
+  Scan *scan;
+
+  scan = g_slice_new0 (Scan);
+  g_mutex_init (&scan->lock);
+  g_cond_init (&scan->cond);
+  scan->jobs = g_ptr_array_new_with_free_func ((GDestroyNotify) scan_job_free);
+
+  if (parallel)
+    {
+      gint n_threads = g_get_num_processors ();
+
+      /* The pools share their threads with the other
+       * non-exclusive pools so creating them is cheap
+       */
+      scan->dir_pool = g_thread_pool_new ((GFunc) scan_dir_thread, scan,
+                                          n_threads, FALSE, NULL);
+      scan->parse_pool = g_thread_pool_new ((GFunc) scan_parse_thread, scan,
+                                            n_threads, FALSE, NULL);
+    }
+
+  return scan;
+}
+
+static void
+scan_add_search_path (Scan       *scan,
+                      SearchPath *sp)
+{
+  ScanJob *job;
+
+  job = g_slice_new (ScanJob);
+  job->scan = scan;
+  job->sp = sp;
+  job->cache = peas_plugin_cache_open (sp->module_dir);
+  job->items = g_ptr_array_new_with_free_func ((GDestroyNotify) scan_item_free);
+
+  g_ptr_array_add (scan->jobs, job);
+
+  if (scan->dir_pool == NULL)
+    scan_dir (job, sp->module_dir, 1);
+  else
+    scan_push (scan, scan->dir_pool, job);
+}
+
+static void
+scan_wait (Scan *scan)
+{
+  guint i;
+
+  g_mutex_lock (&scan->lock);
+
+  while (scan->n_pending != 0)
+    g_cond_wait (&scan->cond, &scan->lock);
+
+  g_mutex_unlock (&scan->lock);
+
+  /* The caches are not needed for merging, write
+   * them now in case this is not the main thread
+   */
+  for (i = 0; i < scan->jobs->len; ++i)
+    {
+      ScanJob *job = g_ptr_array_index (scan->jobs, i);
+
+      peas_plugin_cache_close (job->cache);
+      job->cache = NULL;
+    }
+}
+
+static void
+scan_free (Scan *scan)
+{
+  /* Nothing is left in the pools after scan_wait() */
+  if (scan->dir_pool != NULL)
+    g_thread_pool_free (scan->dir_pool, FALSE, TRUE);
+  if (scan->parse_pool != NULL)
+    g_thread_pool_free (scan->parse_pool, FALSE, TRUE);
+
+  g_ptr_array_unref (scan->jobs);
+
+  g_cond_clear (&scan->cond);
+  g_mutex_clear (&scan->lock);
+  g_slice_free (Scan, scan);
+}
+
+/* Returns a Scan that is ready to be merged */
+static Scan *
+scan_search_paths (GList    *search_paths,
+                   gboolean  parallel)
+{
+  Scan *scan;
+  GList *item;
+
+  scan = scan_new (parallel);
+
+  for (item = search_paths; item != NULL; item = item->next)
+    scan_add_search_path (scan, (SearchPath *) item->data);
+
+  scan_wait (scan);
+
+  return scan;
+}
+
+/* Adds @info to the array of @key in @index, which maps a
+ * string to a GPtrArray of PeasPluginInfos
+ */
+static void
+index_add (GHashTable     *index,
+           const gchar    *key,
+           PeasPluginInfo *info)
+{
+  GPtrArray *infos;
+
+  infos = g_hash_table_lookup (index, key);
+
+  if (infos == NULL)
+    {
+      infos = g_ptr_array_new ();
+      g_hash_table_insert (index, g_strdup (key), infos);
+    }
+
+  g_ptr_array_add (infos, info);
+}
+
+static void
+index_remove (GHashTable     *index,
+              const gchar    *key,
+              PeasPluginInfo *info)
+{
+  GPtrArray *infos;
+
+  infos = g_hash_table_lookup (index, key);
+
+  if (infos == NULL)
+    return;
+
+  g_ptr_array_remove (infos, info);
+
+  if (infos->len == 0)
+    g_hash_table_remove (index, key);
+}
+
+static void
+add_plugin_edges (PeasEngine     *engine,
+                  PeasPluginInfo *info)
+{
+  const gchar **dependencies;
+  const gchar **extensions;
+  guint i;
+
+  /* The dependency does not need to have been found */
+  dependencies = peas_plugin_info_get_dependencies (info);
+  for (i = 0; dependencies[i] != NULL; ++i)
+    index_add (engine->priv->dependants, dependencies[i], info);
+
+  extensions = peas_plugin_info_get_extensions (info);
+  for (i = 0; extensions != NULL && extensions[i] != NULL; ++i)
+    index_add (engine->priv->providers, extensions[i], info);
+}
+
+static void
+remove_plugin_edges (PeasEngine     *engine,
+                     PeasPluginInfo *info)
+{
+  const gchar **dependencies;
+  const gchar **extensions;
+  guint i;
+
+  dependencies = peas_plugin_info_get_dependencies (info);
+  for (i = 0; dependencies[i] != NULL; ++i)
+    index_remove (engine->priv->dependants, dependencies[i], info);
+
+  extensions = peas_plugin_info_get_extensions (info);
+  for (i = 0; extensions != NULL && extensions[i] != NULL; ++i)
+    index_remove (engine->priv->providers, extensions[i], info);
+}
+
+static gboolean
+add_plugin_info (PeasEngine     *engine,
+                 PeasPluginInfo *info)
+{
+  const gchar *module_name;
+
+  /* If a plugin with this name has already been loaded
+   * drop this one (user plugins override system plugins) */
+  module_name = peas_plugin_info_get_module_name (info);
+  if (peas_engine_get_plugin_info (engine, module_name) != NULL)
+    {
+      _peas_plugin_info_unref (info);
+      return FALSE;
+    }
+
+  engine->priv->plugin_list = g_list_prepend (engine->priv->plugin_list,
+                                              info);
+  g_hash_table_insert (engine->priv->plugin_index,
+                       (gpointer) module_name, info);
+  add_plugin_edges (engine, info);
+
+  return TRUE;
+}
+
+/* PeasEngine:plugin-list is only notified once per Scan */
+static void
+scan_merge (Scan       *scan,
+            PeasEngine *engine)
+{
+  gboolean plugin_list_changed = FALSE;
+  guint i, j;
+
+  for (i = 0; i < scan->jobs->len; ++i)
+    {
+      ScanJob *job = g_ptr_array_index (scan->jobs, i);
+
+      for (j = 0; j < job->items->len; ++j)
+        {
+          ScanItem *item = g_ptr_array_index (job->items, j);
+
+          if (item->info == NULL)
+            {
+              if (item->error != NULL)
+                g_warning ("%s", item->error->message);
+
+              g_warning ("Error loading '%s'", item->filename);
+              continue;
+            }
+
+          /* Steal the info, add_plugin_info() takes ownership */
+          if (add_plugin_info (engine, item->info))
+            plugin_list_changed = TRUE;
+
+          item->info = NULL;
+        }
+    }
+
+  if (plugin_list_changed)
+    g_object_notify_by_pspec (G_OBJECT (engine),
+                              properties[PROP_PLUGIN_LIST]);
+}
+
+static void
+load_search_paths (PeasEngine *engine,
+                   GList      *search_paths)
+{
+  Scan *scan;
+
+  scan = scan_search_paths (search_paths, engine->priv->parallel_scan);
+  scan_merge (scan, engine);
+  scan_free (scan);
+}
+
+typedef struct {
+  GList *search_paths;
+  gboolean parallel;
+  Scan *scan;
+} AsyncScan;
+
+static void
+async_scan_free (AsyncScan *async_scan)
+{
+  if (async_scan->scan != NULL)
+    scan_free (async_scan->scan);
+
+  g_list_free (async_scan->search_paths);
+  g_slice_free (AsyncScan, async_scan);
+}
+
+static void
+async_scan_thread (GTask        *scan_task,
+                   PeasEngine   *engine,
+                   AsyncScan    *async_scan,
+                   GCancellable *cancellable)
+{
+  async_scan->scan = scan_search_paths (async_scan->search_paths,
+                                        async_scan->parallel);
+
+  g_task_return_boolean (scan_task, TRUE);
+}
+
+static void
+async_scan_ready (PeasEngine   *engine,
+                  GAsyncResult *result,
+                  GTask        *task)
+{
+  AsyncScan *async_scan = g_task_get_task_data (G_TASK (result));
+  GError *error = NULL;
+
+  /* The plugins are added on the thread the scan was started from */
+  if (!g_task_propagate_boolean (G_TASK (result), &error))
+    {
+      g_task_return_error (task, error);
+    }
+  else if (!g_task_return_error_if_cancelled (task))
+    {
+      scan_merge (async_scan->scan, engine);
+      g_task_return_boolean (task, TRUE);
+    }
+
+  g_object_unref (task);
+}
+
+/* Takes ownership of search_paths */
+static void
+load_search_paths_async (PeasEngine          *engine,
+                         GList               *search_paths,
+                         GCancellable        *cancellable,
+                         GAsyncReadyCallback  callback,
+                         gpointer             user_data)
+{
+  GTask *task;
+  GTask *scan_task;
+  AsyncScan *async_scan;
+
+  task = g_task_new (engine, cancellable, callback, user_data);
+
+  async_scan = g_slice_new0 (AsyncScan);
+  async_scan->search_paths = search_paths;
+  async_scan->parallel = engine->priv->parallel_scan;
+
+  /* The inner task only does the scanning on a thread,
+   * the outer task returns once the plugins were added
+   */
+  scan_task = g_task_new (engine, cancellable,
+                          (GAsyncReadyCallback) async_scan_ready, task);
+  g_task_set_task_data (scan_task, async_scan,
+                        (GDestroyNotify) async_scan_free);
+  g_task_run_in_thread (scan_task, (GTaskThreadFunc) async_scan_thread);
+  g_object_unref (scan_task);
 }
 
 /**
@@ -194,8 +677,6 @@ load_dir_real (PeasEngine  *engine,
 void
 peas_engine_rescan_plugins (PeasEngine *engine)
 {
-  GList *item;
-
   g_return_if_fail (PEAS_IS_ENGINE (engine));
 
   if (engine->priv->search_paths == NULL)
@@ -204,16 +685,385 @@ peas_engine_rescan_plugins (PeasEngine *engine)
       return;
     }
 
-  g_object_freeze_notify (G_OBJECT (engine));
-
   /* Go and read everything from the provided search paths */
-  for (item = engine->priv->search_paths; item != NULL; item = item->next)
+  load_search_paths (engine, engine->priv->search_paths);
+}
+
+/**
+ * peas_engine_rescan_plugins_async:
+ * @engine: A #PeasEngine.
+ * @cancellable: (allow-none): optional #GCancellable object, %NULL to ignore.
+ * @callback: (scope async): a #GAsyncReadyCallback to call when the
+ *   plugins have been rescanned.
+ * @user_data: (closure): the data to pass to @callback.
+ *
+ * Asynchronously rescans all the registered directories to find new
+ * or updated plugins, see peas_engine_rescan_plugins().
+ *
+ * The directories are scanned on a worker thread, the new plugins are
+ * then added on the thread-default main context of the thread this
+ * function was called from and #PeasEngine:plugin-list is notified
+ * once for all of them.
+ *
+ * When the operation is finished, @callback will be called. You can
+ * then call peas_engine_rescan_plugins_finish() to get the result of
+ * the operation.
+ *
+ * Since: 1.6
+ */
+void
+peas_engine_rescan_plugins_async (PeasEngine          *engine,
+                                  GCancellable        *cancellable,
+                                  GAsyncReadyCallback  callback,
+                                  gpointer             user_data)
+{
+  g_return_if_fail (PEAS_IS_ENGINE (engine));
+  g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+  load_search_paths_async (engine,
+                           g_list_copy (engine->priv->search_paths),
+                           cancellable, callback, user_data);
+}
+
+/**
+ * peas_engine_rescan_plugins_finish:
+ * @engine: A #PeasEngine.
+ * @result: a #GAsyncResult.
+ * @error: return location for a #GError, or %NULL.
+ *
+ * Finishes an operation started with peas_engine_rescan_plugins_async().
+ *
+ * Returns: %TRUE if the plugins were rescanned, %FALSE if
+ * the operation was cancelled.
+ *
+ * Since: 1.6
+ */
+gboolean
+peas_engine_rescan_plugins_finish (PeasEngine    *engine,
+                                   GAsyncResult  *result,
+                                   GError       **error)
+{
+  g_return_val_if_fail (PEAS_IS_ENGINE (engine), FALSE);
+  g_return_val_if_fail (g_task_is_valid (result, engine), FALSE);
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+/* Returns the position of the search path @info was found in */
+static gint
+get_search_path_position (PeasEngine     *engine,
+                          PeasPluginInfo *info)
+{
+  const gchar *module_dir = peas_plugin_info_get_module_dir (info);
+  gchar *parent_dir;
+  GList *item;
+  gint position;
+
+  /* The .plugin files are either in the module
+   * directory of the search path or a subdirectory
+   */
+  parent_dir = g_path_get_dirname (module_dir);
+
+  for (item = engine->priv->search_paths, position = 0;
+       item != NULL; item = item->next, ++position)
     {
       SearchPath *sp = (SearchPath *) item->data;
-      load_dir_real (engine, sp->module_dir, sp->data_dir, 1);
+
+      if (g_strcmp0 (sp->module_dir, module_dir) == 0 ||
+          g_strcmp0 (sp->module_dir, parent_dir) == 0)
+        break;
     }
 
-  g_object_thaw_notify (G_OBJECT (engine));
+  g_free (parent_dir);
+
+  return item != NULL ? position : G_MAXINT;
+}
+
+static void
+remove_plugin_info (PeasEngine     *engine,
+                    PeasPluginInfo *info)
+{
+  g_hash_table_remove (engine->priv->deferred, info);
+  remove_plugin_edges (engine, info);
+  g_hash_table_remove (engine->priv->plugin_index,
+                       peas_plugin_info_get_module_name (info));
+  engine->priv->plugin_list = g_list_remove (engine->priv->plugin_list,
+                                             info);
+  _peas_plugin_info_unref (info);
+}
+
+static void
+search_path_update_file (SearchPath  *sp,
+                         const gchar *filename)
+{
+  PeasEngine *engine = sp->engine;
+  PeasPluginInfo *info, *old_info;
+  gchar *module_dir;
+  GError *error = NULL;
+
+  module_dir = g_path_get_dirname (filename);
+  info = peas_plugin_cache_load_file (sp->module_dir, filename, module_dir,
+                                      sp->data_dir, &error);
+  g_free (module_dir);
+
+  if (info == NULL)
+    {
+      g_warning ("%s", error->message);
+      g_error_free (error);
+
+      g_warning ("Error loading '%s'", filename);
+      return;
+    }
+
+  old_info = peas_engine_get_plugin_info (engine,
+                                          peas_plugin_info_get_module_name (info));
+
+  /* A loaded plugin cannot be replaced, and a plugin found in an
+   * earlier search path still overrides this one
+   */
+  if (old_info != NULL &&
+      (peas_plugin_info_is_loaded (old_info) ||
+       (g_strcmp0 (old_info->filename, filename) != 0 &&
+        get_search_path_position (engine, old_info) <=
+        g_list_index (engine->priv->search_paths, sp))))
+    {
+      _peas_plugin_info_unref (info);
+      return;
+    }
+
+  /* The new plugin info is still enabled */
+  if (old_info != NULL &&
+      g_hash_table_contains (engine->priv->deferred, old_info))
+    g_hash_table_add (engine->priv->deferred, info);
+
+  if (old_info != NULL)
+    remove_plugin_info (engine, old_info);
+
+  add_plugin_info (engine, info);
+
+  g_object_notify_by_pspec (G_OBJECT (engine),
+                            properties[PROP_PLUGIN_LIST]);
+}
+
+static void
+search_path_remove_file (SearchPath  *sp,
+                         const gchar *filename)
+{
+  PeasEngine *engine = sp->engine;
+  gboolean plugin_list_changed = FALSE;
+  GList *item, *next;
+  GList *search_paths;
+
+  /* The filename is either a .plugin file or a plugin directory */
+  for (item = engine->priv->plugin_list; item != NULL; item = next)
+    {
+      PeasPluginInfo *info = (PeasPluginInfo *) item->data;
+
+      next = item->next;
+
+      if (peas_plugin_info_is_loaded (info))
+        continue;
+
+      if (g_strcmp0 (info->filename, filename) == 0 ||
+          g_strcmp0 (info->module_dir, filename) == 0)
+        {
+          remove_plugin_info (engine, info);
+          plugin_list_changed = TRUE;
+        }
+    }
+
+  if (!plugin_list_changed)
+    return;
+
+  g_object_notify_by_pspec (G_OBJECT (engine),
+                            properties[PROP_PLUGIN_LIST]);
+
+  /* The removed plugins may have overridden a plugin with the same
+   * module name in this or a later search path, which is found again
+   * by rescanning them, the other plugins are already known
+   */
+  search_paths = g_list_find (engine->priv->search_paths, sp);
+  load_search_paths (engine, search_paths);
+}
+
+static void search_path_add_dir (SearchPath  *sp,
+                                 const gchar *dir);
+
+static void
+search_path_changed_cb (GFileMonitor      *monitor,
+                        GFile             *file,
+                        GFile             *other_file,
+                        GFileMonitorEvent  event_type,
+                        SearchPath        *sp)
+{
+  gchar *filename;
+  gchar *parent_dir;
+  gboolean in_module_dir;
+
+  filename = g_file_get_path (file);
+  if (filename == NULL)
+    return;
+
+  parent_dir = g_path_get_dirname (filename);
+  in_module_dir = g_strcmp0 (parent_dir, sp->module_dir) == 0;
+
+  switch (event_type)
+    {
+    case G_FILE_MONITOR_EVENT_CREATED:
+      /* Only the plugin directories directly in the module directory
+       * are scanned. A new file is only read once it is fully written,
+       * which is signalled by G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT.
+       */
+      if (in_module_dir && g_file_test (filename, G_FILE_TEST_IS_DIR))
+        search_path_add_dir (sp, filename);
+      break;
+    case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
+      if (g_str_has_suffix (filename, ".plugin"))
+        search_path_update_file (sp, filename);
+      break;
+    case G_FILE_MONITOR_EVENT_DELETED:
+      search_path_remove_file (sp, filename);
+
+      if (in_module_dir)
+        g_hash_table_remove (sp->monitors, filename);
+      break;
+    default:
+      break;
+    }
+
+  g_free (parent_dir);
+  g_free (filename);
+}
+
+static void
+monitor_free (GFileMonitor *monitor)
+{
+  g_signal_handlers_disconnect_matched (monitor, G_SIGNAL_MATCH_FUNC,
+                                        0, 0, NULL,
+                                        search_path_changed_cb, NULL);
+  g_file_monitor_cancel (monitor);
+  g_object_unref (monitor);
+}
+
+static void
+search_path_monitor_dir (SearchPath  *sp,
+                         const gchar *dir)
+{
+  GFile *file;
+  GFileMonitor *monitor;
+  GError *error = NULL;
+
+  file = g_file_new_for_path (dir);
+  monitor = g_file_monitor_directory (file, G_FILE_MONITOR_NONE,
+                                      NULL, &error);
+  g_object_unref (file);
+
+  if (monitor == NULL)
+    {
+      g_debug ("%s", error->message);
+      g_error_free (error);
+      return;
+    }
+
+  g_signal_connect (monitor, "changed",
+                    G_CALLBACK (search_path_changed_cb), sp);
+  g_hash_table_insert (sp->monitors, g_strdup (dir), monitor);
+}
+
+/* Called for a plugin directory created after the monitoring started */
+static void
+search_path_add_dir (SearchPath  *sp,
+                     const gchar *dir)
+{
+  GDir *d;
+  const gchar *dirent;
+
+  search_path_monitor_dir (sp, dir);
+
+  /* The .plugin file may have been
+   * created before the monitor was
+   */
+  d = g_dir_open (dir, 0, NULL);
+  if (d == NULL)
+    return;
+
+  while ((dirent = g_dir_read_name (d)))
+    {
+      if (g_str_has_suffix (dirent, ".plugin"))
+        {
+          gchar *filename = g_build_filename (dir, dirent, NULL);
+
+          search_path_update_file (sp, filename);
+          g_free (filename);
+        }
+    }
+
+  g_dir_close (d);
+}
+
+static void
+search_path_start_monitoring (SearchPath *sp)
+{
+  GDir *d;
+  const gchar *dirent;
+
+  if (sp->monitors != NULL)
+    return;
+
+  sp->monitors = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                        (GDestroyNotify) g_free,
+                                        (GDestroyNotify) monitor_free);
+
+  search_path_monitor_dir (sp, sp->module_dir);
+
+  d = g_dir_open (sp->module_dir, 0, NULL);
+  if (d == NULL)
+    return;
+
+  while ((dirent = g_dir_read_name (d)))
+    {
+      gchar *filename = g_build_filename (sp->module_dir, dirent, NULL);
+
+      if (g_file_test (filename, G_FILE_TEST_IS_DIR))
+        search_path_monitor_dir (sp, filename);
+
+      g_free (filename);
+    }
+
+  g_dir_close (d);
+}
+
+static void
+search_path_stop_monitoring (SearchPath *sp)
+{
+  if (sp->monitors == NULL)
+    return;
+
+  g_hash_table_destroy (sp->monitors);
+  sp->monitors = NULL;
+}
+
+static SearchPath *
+insert_search_path (PeasEngine  *engine,
+                    gint         position,
+                    const gchar *module_dir,
+                    const gchar *data_dir)
+{
+  SearchPath *sp;
+
+  sp = g_slice_new0 (SearchPath);
+  sp->engine = engine;
+  sp->module_dir = g_strdup (module_dir);
+  sp->data_dir = g_strdup (data_dir ? data_dir : module_dir);
+
+  engine->priv->search_paths = g_list_insert (engine->priv->search_paths,
+                                              sp,
+                                              position);
+
+  if (engine->priv->monitor_search_paths)
+    search_path_start_monitoring (sp);
+
+  return sp;
 }
 
 static void
@@ -223,21 +1073,16 @@ peas_engine_insert_search_path (PeasEngine  *engine,
                                 const gchar *data_dir)
 {
   SearchPath *sp;
+  GList *single;
 
   g_return_if_fail (PEAS_IS_ENGINE (engine));
   g_return_if_fail (module_dir != NULL);
 
-  sp = g_slice_new (SearchPath);
-  sp->module_dir = g_strdup (module_dir);
-  sp->data_dir = g_strdup (data_dir ? data_dir : module_dir);
-
-  engine->priv->search_paths = g_list_insert (engine->priv->search_paths,
-                                              sp,
-                                              position);
+  sp = insert_search_path (engine, position, module_dir, data_dir);
 
-  g_object_freeze_notify (G_OBJECT (engine));
-  load_dir_real (engine, sp->module_dir, sp->data_dir, 1);
-  g_object_thaw_notify (G_OBJECT (engine));
+  single = g_list_prepend (NULL, sp);
+  load_search_paths (engine, single);
+  g_list_free (single);
 }
 
 /**
@@ -290,6 +1135,72 @@ peas_engine_prepend_search_path (PeasEngine *engine,
   peas_engine_insert_search_path (engine, 0, module_dir, data_dir);
 }
 
+/**
+ * peas_engine_add_search_path_async:
+ * @engine: A #PeasEngine.
+ * @module_dir: the plugin module directory.
+ * @data_dir: (allow-none): the plugin data directory.
+ * @cancellable: (allow-none): optional #GCancellable object, %NULL to ignore.
+ * @callback: (scope async): a #GAsyncReadyCallback to call when the
+ *   plugins of the search path have been found.
+ * @user_data: (closure): the data to pass to @callback.
+ *
+ * Appends a search path like peas_engine_add_search_path() but finds
+ * its plugins asynchronously, see peas_engine_rescan_plugins_async().
+ *
+ * The search path is appended immediately, so the order of the search
+ * paths is the same as if peas_engine_add_search_path() was called.
+ *
+ * When the operation is finished, @callback will be called. You can
+ * then call peas_engine_add_search_path_finish() to get the result of
+ * the operation.
+ *
+ * Since: 1.6
+ */
+void
+peas_engine_add_search_path_async (PeasEngine          *engine,
+                                   const gchar         *module_dir,
+                                   const gchar         *data_dir,
+                                   GCancellable        *cancellable,
+                                   GAsyncReadyCallback  callback,
+                                   gpointer             user_data)
+{
+  SearchPath *sp;
+
+  g_return_if_fail (PEAS_IS_ENGINE (engine));
+  g_return_if_fail (module_dir != NULL);
+  g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+  sp = insert_search_path (engine, -1, module_dir, data_dir);
+
+  load_search_paths_async (engine, g_list_prepend (NULL, sp),
+                           cancellable, callback, user_data);
+}
+
+/**
+ * peas_engine_add_search_path_finish:
+ * @engine: A #PeasEngine.
+ * @result: a #GAsyncResult.
+ * @error: return location for a #GError, or %NULL.
+ *
+ * Finishes an operation started with peas_engine_add_search_path_async().
+ *
+ * Returns: %TRUE if the plugins of the search path were found,
+ * %FALSE if the operation was cancelled.
+ *
+ * Since: 1.6
+ */
+gboolean
+peas_engine_add_search_path_finish (PeasEngine    *engine,
+                                    GAsyncResult  *result,
+                                    GError       **error)
+{
+  g_return_val_if_fail (PEAS_IS_ENGINE (engine), FALSE);
+  g_return_val_if_fail (g_task_is_valid (result, engine), FALSE);
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
+
 static guint
 hash_lowercase (gconstpointer data)
 {
@@ -340,7 +1251,23 @@ peas_engine_init (PeasEngine *engine)
                                               PEAS_TYPE_ENGINE,
                                               PeasEnginePrivate);
 
+  /* Maps PeasPluginInfo:module-name to the PeasPluginInfo,
+   * the key is owned by the PeasPluginInfo in plugin_list
+   */
+  engine->priv->plugin_index = g_hash_table_new (g_str_hash, g_str_equal);
+  engine->priv->dependants = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                    (GDestroyNotify) g_free,
+                                                    (GDestroyNotify) g_ptr_array_unref);
+  engine->priv->providers = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                   (GDestroyNotify) g_free,
+                                                   (GDestroyNotify) g_ptr_array_unref);
+  engine->priv->deferred = g_hash_table_new (g_direct_hash, g_direct_equal);
+
   engine->priv->in_dispose = FALSE;
+  engine->priv->parallel_scan = FALSE;
+  engine->priv->monitor_search_paths = FALSE;
+  engine->priv->parallel_load = FALSE;
+  engine->priv->lazy_load = FALSE;
 }
 
 static void
@@ -407,6 +1334,19 @@ peas_engine_set_property (GObject      *object,
       peas_engine_set_loaded_plugins (engine,
                                       (const gchar **) g_value_get_boxed (value));
       break;
+    case PROP_PARALLEL_SCAN:
+      peas_engine_set_parallel_scan (engine, g_value_get_boolean (value));
+      break;
+    case PROP_MONITOR_SEARCH_PATHS:
+      peas_engine_set_monitor_search_paths (engine,
+                                            g_value_get_boolean (value));
+      break;
+    case PROP_PARALLEL_LOAD:
+      peas_engine_set_parallel_load (engine, g_value_get_boolean (value));
+      break;
+    case PROP_LAZY_LOAD:
+      peas_engine_set_lazy_load (engine, g_value_get_boolean (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -431,6 +1371,19 @@ peas_engine_get_property (GObject    *object,
       g_value_take_boxed (value,
                           (gconstpointer) peas_engine_get_loaded_plugins (engine));
       break;
+    case PROP_PARALLEL_SCAN:
+      g_value_set_boolean (value, peas_engine_get_parallel_scan (engine));
+      break;
+    case PROP_MONITOR_SEARCH_PATHS:
+      g_value_set_boolean (value,
+                           peas_engine_get_monitor_search_paths (engine));
+      break;
+    case PROP_PARALLEL_LOAD:
+      g_value_set_boolean (value, peas_engine_get_parallel_load (engine));
+      break;
+    case PROP_LAZY_LOAD:
+      g_value_set_boolean (value, peas_engine_get_lazy_load (engine));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -445,6 +1398,8 @@ peas_engine_dispose (GObject *object)
 
   engine->priv->in_dispose = TRUE;
 
+  g_hash_table_remove_all (engine->priv->deferred);
+
   /* First unload all the plugins */
   for (item = engine->priv->plugin_list; item; item = item->next)
     {
@@ -464,6 +1419,10 @@ peas_engine_finalize (GObject *object)
   GList *item;
 
   /* free the infos */
+  g_hash_table_destroy (engine->priv->deferred);
+  g_hash_table_destroy (engine->priv->providers);
+  g_hash_table_destroy (engine->priv->dependants);
+  g_hash_table_destroy (engine->priv->plugin_index);
   g_list_free_full (engine->priv->plugin_list,
                     (GDestroyNotify) _peas_plugin_info_unref);
 
@@ -472,6 +1431,7 @@ peas_engine_finalize (GObject *object)
     {
       SearchPath *sp = (SearchPath *) item->data;
 
+      search_path_stop_monitoring (sp);
       g_free (sp->module_dir);
       g_free (sp->data_dir);
       g_slice_free (SearchPath, sp);
@@ -542,6 +1502,104 @@ peas_engine_class_init (PeasEngineClass *klass)
                         G_PARAM_READWRITE |
                         G_PARAM_STATIC_STRINGS);
 
+  /**
+   * PeasEngine:parallel-scan:
+   *
+   * Whether the search paths are scanned on worker threads.
+   *
+   * When this is %TRUE, peas_engine_rescan_plugins() and adding a
+   * search path will enumerate the directories and parse the plugin
+   * info files on a #GThreadPool. The plugins are still added to
+   * #PeasEngine:plugin-list in the order of the search paths, so a
+   * plugin found in an earlier search path overrides one with the same
+   * module name in a later one, just like when scanning serially.
+   *
+   * Since: 1.6
+   */
+  properties[PROP_PARALLEL_SCAN] =
+    g_param_spec_boolean ("parallel-scan",
+                          "Parallel scan",
+                          "Whether the search paths are scanned on worker threads",
+                          FALSE,
+                          G_PARAM_READWRITE |
+                          G_PARAM_STATIC_STRINGS);
+
+  /**
+   * PeasEngine:monitor-search-paths:
+   *
+   * Whether the search paths are monitored for changes.
+   *
+   * When this is %TRUE, the module directory of every search path and
+   * the plugin directories in it are watched with a #GFileMonitor. A
+   * plugin info file that is created or modified is parsed again and
+   * the plugins that are removed from the disk are removed from
+   * #PeasEngine:plugin-list, unless they are loaded. This avoids having
+   * to call peas_engine_rescan_plugins() periodically.
+   *
+   * The changes are handled in the thread-default main context
+   * of the thread the monitoring was started from.
+   *
+   * Since: 1.6
+   */
+  properties[PROP_MONITOR_SEARCH_PATHS] =
+    g_param_spec_boolean ("monitor-search-paths",
+                          "Monitor search paths",
+                          "Whether the search paths are monitored for changes",
+                          FALSE,
+                          G_PARAM_READWRITE |
+                          G_PARAM_STATIC_STRINGS);
+
+  /**
+   * PeasEngine:parallel-load:
+   *
+   * Whether plugins are prepared on worker threads when several of
+   * them are loaded at once.
+   *
+   * When this is %TRUE, peas_engine_set_loaded_plugins() first lets
+   * the plugin loaders do the thread-safe part of loading every plugin,
+   * reading the shared libraries and scripts they are loaded from,
+   * concurrently on a #GThreadPool. This helps when the files are not
+   * yet in the page cache. The plugins are then loaded in dependency order on
+   * the calling thread, which is where their types are registered and
+   * #PeasEngine::load-plugin is emitted.
+   *
+   * Since: 1.6
+   */
+  properties[PROP_PARALLEL_LOAD] =
+    g_param_spec_boolean ("parallel-load",
+                          "Parallel load",
+                          "Whether plugins are prepared on worker threads",
+                          FALSE,
+                          G_PARAM_READWRITE |
+                          G_PARAM_STATIC_STRINGS);
+
+  /**
+   * PeasEngine:lazy-load:
+   *
+   * Whether loading the plugins enabled with
+   * peas_engine_set_loaded_plugins() is deferred until they are needed.
+   *
+   * When this is %TRUE, peas_engine_set_loaded_plugins() only marks the
+   * plugins as enabled. They are included in #PeasEngine:loaded-plugins
+   * but peas_plugin_info_is_loaded() returns %FALSE for them until the
+   * first call to peas_engine_provides_extension() or
+   * peas_engine_create_extension() for them, which loads them along
+   * with their dependencies. A #PeasExtensionSet asks the enabled
+   * plugins for its extension type when it is created and whenever
+   * #PeasEngine:loaded-plugins changes.
+   *
+   * Setting this back to %FALSE loads all of the enabled plugins.
+   *
+   * Since: 1.6
+   */
+  properties[PROP_LAZY_LOAD] =
+    g_param_spec_boolean ("lazy-load",
+                          "Lazy load",
+                          "Whether loading the enabled plugins is deferred",
+                          FALSE,
+                          G_PARAM_READWRITE |
+                          G_PARAM_STATIC_STRINGS);
+
   /**
    * PeasEngine::load-plugin:
    * @engine: A #PeasEngine.
@@ -597,6 +1655,8 @@ peas_engine_class_init (PeasEngineClass *klass)
   /* We are doing some global initialization here as there is currently no
    * global init function for libpeas. */
   peas_debug_init ();
+  peas_profile_init ();
+  peas_trace_init ();
 
   /* mapping from loadername -> loader object */
   loaders = g_hash_table_new_full (hash_lowercase,
@@ -625,6 +1685,36 @@ load_module (const gchar *module_name,
   return module;
 }
 
+/* Loads @info if it was enabled with PeasEngine:lazy-load set */
+static void
+load_deferred_plugin (PeasEngine     *engine,
+                      PeasPluginInfo *info)
+{
+  if (g_hash_table_contains (engine->priv->deferred, info))
+    peas_engine_load_plugin (engine, info);
+}
+
+/* Unloading a plugin unloads the plugins that depend on it,
+ * this does the same for the ones whose loading was deferred
+ */
+static void
+remove_deferred_dependants (PeasEngine     *engine,
+                            PeasPluginInfo *info)
+{
+  GPtrArray *dependants;
+  guint i;
+
+  dependants = g_hash_table_lookup (engine->priv->dependants,
+                                    peas_plugin_info_get_module_name (info));
+  for (i = 0; dependants != NULL && i < dependants->len; ++i)
+    {
+      PeasPluginInfo *other_info = g_ptr_array_index (dependants, i);
+
+      if (g_hash_table_remove (engine->priv->deferred, other_info))
+        remove_deferred_dependants (engine, other_info);
+    }
+}
+
 static PeasPluginLoader *
 get_plugin_loader (PeasEngine     *engine,
                    PeasPluginInfo *info)
@@ -751,38 +1841,334 @@ peas_engine_get_plugin_list (PeasEngine *engine)
   return engine->priv->plugin_list;
 }
 
-static gint
-compare_plugin_info_and_name (PeasPluginInfo *info,
-                              const gchar    *module_name)
-{
-  return strcmp (peas_plugin_info_get_module_name (info), module_name);
+/**
+ * peas_engine_get_plugin_info:
+ * @engine: A #PeasEngine.
+ * @plugin_name: A plugin name.
+ *
+ * Gets the #PeasPluginInfo corresponding with @plugin_name,
+ * or %NULL if @plugin_name was not found.
+ *
+ * Returns: (transfer none): the #PeasPluginInfo corresponding with
+ * a given plugin module name.
+ */
+PeasPluginInfo *
+peas_engine_get_plugin_info (PeasEngine  *engine,
+                             const gchar *plugin_name)
+{
+  g_return_val_if_fail (PEAS_IS_ENGINE (engine), NULL);
+  g_return_val_if_fail (plugin_name != NULL, NULL);
+
+  return (PeasPluginInfo *) g_hash_table_lookup (engine->priv->plugin_index,
+                                                 plugin_name);
+}
+
+/**
+ * peas_engine_get_dependants:
+ * @engine: A #PeasEngine.
+ * @info: A #PeasPluginInfo.
+ *
+ * Returns the plugins that directly depend on the plugin of @info,
+ * whether they are loaded or not.
+ *
+ * This does not need to go through all the plugins, so it is cheap
+ * even when many plugins are installed.
+ *
+ * Returns: (transfer container) (element-type Peas.PluginInfo): a #GList
+ * of #PeasPluginInfo. Free it with g_list_free().
+ *
+ * Since: 1.6
+ */
+GList *
+peas_engine_get_dependants (PeasEngine     *engine,
+                            PeasPluginInfo *info)
+{
+  GPtrArray *dependants;
+  GList *list = NULL;
+  guint i;
+
+  g_return_val_if_fail (PEAS_IS_ENGINE (engine), NULL);
+  g_return_val_if_fail (info != NULL, NULL);
+
+  dependants = g_hash_table_lookup (engine->priv->dependants,
+                                    peas_plugin_info_get_module_name (info));
+
+  if (dependants == NULL)
+    return NULL;
+
+  /* Prepend in reverse to keep the order of the array */
+  for (i = dependants->len; i > 0; --i)
+    list = g_list_prepend (list, g_ptr_array_index (dependants, i - 1));
+
+  return list;
+}
+
+/**
+ * peas_engine_get_plugins_for_extension:
+ * @engine: A #PeasEngine.
+ * @extension_type: The extension #GType.
+ *
+ * Returns the plugins that declare they provide @extension_type in the
+ * "Extensions" key of their plugin info file, whether they are loaded
+ * or not. Nothing is loaded to find them, so the plugins that do not
+ * declare their extension types are not included.
+ *
+ * Returns: (transfer container) (element-type Peas.PluginInfo): a #GList
+ * of #PeasPluginInfo. Free it with g_list_free().
+ *
+ * Since: 1.6
+ */
+GList *
+peas_engine_get_plugins_for_extension (PeasEngine *engine,
+                                       GType       extension_type)
+{
+  GPtrArray *providers;
+  GList *list = NULL;
+  guint i;
+
+  g_return_val_if_fail (PEAS_IS_ENGINE (engine), NULL);
+  g_return_val_if_fail (G_TYPE_IS_INTERFACE (extension_type), NULL);
+
+  providers = g_hash_table_lookup (engine->priv->providers,
+                                   g_type_name (extension_type));
+
+  if (providers == NULL)
+    return NULL;
+
+  for (i = providers->len; i > 0; --i)
+    list = g_list_prepend (list, g_ptr_array_index (providers, i - 1));
+
+  return list;
+}
+
+/**
+ * peas_engine_set_parallel_scan:
+ * @engine: A #PeasEngine.
+ * @parallel_scan: Whether to scan the search paths on worker threads.
+ *
+ * Sets whether the search paths are scanned on worker threads.
+ *
+ * See #PeasEngine:parallel-scan.
+ *
+ * Since: 1.6
+ */
+void
+peas_engine_set_parallel_scan (PeasEngine *engine,
+                               gboolean    parallel_scan)
+{
+  g_return_if_fail (PEAS_IS_ENGINE (engine));
+
+  parallel_scan = parallel_scan != FALSE;
+
+  if (engine->priv->parallel_scan == parallel_scan)
+    return;
+
+  engine->priv->parallel_scan = parallel_scan;
+
+  g_object_notify_by_pspec (G_OBJECT (engine),
+                            properties[PROP_PARALLEL_SCAN]);
+}
+
+/**
+ * peas_engine_get_parallel_scan:
+ * @engine: A #PeasEngine.
+ *
+ * Returns whether the search paths are scanned on worker threads.
+ *
+ * Returns: the value of #PeasEngine:parallel-scan.
+ *
+ * Since: 1.6
+ */
+gboolean
+peas_engine_get_parallel_scan (PeasEngine *engine)
+{
+  g_return_val_if_fail (PEAS_IS_ENGINE (engine), FALSE);
+
+  return engine->priv->parallel_scan;
+}
+
+/**
+ * peas_engine_set_monitor_search_paths:
+ * @engine: A #PeasEngine.
+ * @monitor_search_paths: Whether to monitor the search paths.
+ *
+ * Sets whether the search paths are monitored for changes.
+ *
+ * See #PeasEngine:monitor-search-paths.
+ *
+ * Since: 1.6
+ */
+void
+peas_engine_set_monitor_search_paths (PeasEngine *engine,
+                                      gboolean    monitor_search_paths)
+{
+  GList *item;
+
+  g_return_if_fail (PEAS_IS_ENGINE (engine));
+
+  monitor_search_paths = monitor_search_paths != FALSE;
+
+  if (engine->priv->monitor_search_paths == monitor_search_paths)
+    return;
+
+  engine->priv->monitor_search_paths = monitor_search_paths;
+
+  for (item = engine->priv->search_paths; item != NULL; item = item->next)
+    {
+      SearchPath *sp = (SearchPath *) item->data;
+
+      if (monitor_search_paths)
+        search_path_start_monitoring (sp);
+      else
+        search_path_stop_monitoring (sp);
+    }
+
+  g_object_notify_by_pspec (G_OBJECT (engine),
+                            properties[PROP_MONITOR_SEARCH_PATHS]);
+}
+
+/**
+ * peas_engine_get_monitor_search_paths:
+ * @engine: A #PeasEngine.
+ *
+ * Returns whether the search paths are monitored for changes.
+ *
+ * Returns: the value of #PeasEngine:monitor-search-paths.
+ *
+ * Since: 1.6
+ */
+gboolean
+peas_engine_get_monitor_search_paths (PeasEngine *engine)
+{
+  g_return_val_if_fail (PEAS_IS_ENGINE (engine), FALSE);
+
+  return engine->priv->monitor_search_paths;
+}
+
+/**
+ * peas_engine_set_parallel_load:
+ * @engine: A #PeasEngine.
+ * @parallel_load: Whether to prepare plugins on worker threads.
+ *
+ * Sets whether plugins are prepared on worker threads
+ * when several of them are loaded at once.
+ *
+ * See #PeasEngine:parallel-load.
+ *
+ * Since: 1.6
+ */
+void
+peas_engine_set_parallel_load (PeasEngine *engine,
+                               gboolean    parallel_load)
+{
+  g_return_if_fail (PEAS_IS_ENGINE (engine));
+
+  parallel_load = parallel_load != FALSE;
+
+  if (engine->priv->parallel_load == parallel_load)
+    return;
+
+  engine->priv->parallel_load = parallel_load;
+
+  g_object_notify_by_pspec (G_OBJECT (engine),
+                            properties[PROP_PARALLEL_LOAD]);
+}
+
+/**
+ * peas_engine_get_parallel_load:
+ * @engine: A #PeasEngine.
+ *
+ * Returns whether plugins are prepared on worker threads
+ * when several of them are loaded at once.
+ *
+ * Returns: the value of #PeasEngine:parallel-load.
+ *
+ * Since: 1.6
+ */
+gboolean
+peas_engine_get_parallel_load (PeasEngine *engine)
+{
+  g_return_val_if_fail (PEAS_IS_ENGINE (engine), FALSE);
+
+  return engine->priv->parallel_load;
+}
+
+/**
+ * peas_engine_set_lazy_load:
+ * @engine: A #PeasEngine.
+ * @lazy_load: Whether to defer loading the enabled plugins.
+ *
+ * Sets whether loading the plugins enabled with
+ * peas_engine_set_loaded_plugins() is deferred until they are needed.
+ *
+ * See #PeasEngine:lazy-load.
+ *
+ * Since: 1.6
+ */
+void
+peas_engine_set_lazy_load (PeasEngine *engine,
+                           gboolean    lazy_load)
+{
+  g_return_if_fail (PEAS_IS_ENGINE (engine));
+
+  lazy_load = lazy_load != FALSE;
+
+  if (engine->priv->lazy_load == lazy_load)
+    return;
+
+  engine->priv->lazy_load = lazy_load;
+
+  if (!lazy_load)
+    {
+      GList *pl;
+
+      for (pl = engine->priv->plugin_list; pl; pl = pl->next)
+        load_deferred_plugin (engine, (PeasPluginInfo *) pl->data);
+    }
+
+  g_object_notify_by_pspec (G_OBJECT (engine),
+                            properties[PROP_LAZY_LOAD]);
 }
 
 /**
- * peas_engine_get_plugin_info:
+ * peas_engine_get_lazy_load:
  * @engine: A #PeasEngine.
- * @plugin_name: A plugin name.
  *
- * Gets the #PeasPluginInfo corresponding with @plugin_name,
- * or %NULL if @plugin_name was not found.
+ * Returns whether loading the plugins enabled with
+ * peas_engine_set_loaded_plugins() is deferred until they are needed.
  *
- * Returns: (transfer none): the #PeasPluginInfo corresponding with
- * a given plugin module name.
+ * Returns: the value of #PeasEngine:lazy-load.
+ *
+ * Since: 1.6
  */
-PeasPluginInfo *
-peas_engine_get_plugin_info (PeasEngine  *engine,
-                             const gchar *plugin_name)
+gboolean
+peas_engine_get_lazy_load (PeasEngine *engine)
 {
-  GList *l;
+  g_return_val_if_fail (PEAS_IS_ENGINE (engine), FALSE);
 
-  g_return_val_if_fail (PEAS_IS_ENGINE (engine), NULL);
-  g_return_val_if_fail (plugin_name != NULL, NULL);
+  return engine->priv->lazy_load;
+}
 
-  l = g_list_find_custom (engine->priv->plugin_list,
-                          plugin_name,
-                          (GCompareFunc) compare_plugin_info_and_name);
+/**
+ * peas_engine_is_plugin_deferred:
+ * @engine: A #PeasEngine.
+ * @info: A #PeasPluginInfo.
+ *
+ * Returns whether @info was enabled while #PeasEngine:lazy-load was
+ * set and has not been loaded yet.
+ *
+ * Returns: whether loading @info is deferred.
+ *
+ * Since: 1.6
+ */
+gboolean
+peas_engine_is_plugin_deferred (PeasEngine     *engine,
+                                PeasPluginInfo *info)
+{
+  g_return_val_if_fail (PEAS_IS_ENGINE (engine), FALSE);
+  g_return_val_if_fail (info != NULL, FALSE);
 
-  return l == NULL ? NULL : (PeasPluginInfo *) l->data;
+  return g_hash_table_contains (engine->priv->deferred, info);
 }
 
 static gboolean
@@ -793,6 +2179,9 @@ load_plugin (PeasEngine     *engine,
   PeasPluginInfo *dep_info;
   guint i;
   PeasPluginLoader *loader;
+  PeasProfileMark mark;
+  gboolean loaded;
+  gint64 begin_time;
 
   if (peas_plugin_info_is_loaded (info))
     return TRUE;
@@ -805,6 +2194,13 @@ load_plugin (PeasEngine     *engine,
   info->loaded = TRUE;
 
   dependencies = peas_plugin_info_get_dependencies (info);
+
+  /* This includes loading the dependencies of the dependencies,
+   * the plugins without dependencies do not time this phase
+   */
+  if (dependencies[0] != NULL)
+    peas_profile_begin (&mark);
+
   for (i = 0; dependencies[i] != NULL; i++)
     {
       dep_info = peas_engine_get_plugin_info (engine, dependencies[i]);
@@ -817,6 +2213,7 @@ load_plugin (PeasEngine     *engine,
                        PEAS_PLUGIN_INFO_ERROR_DEP_NOT_FOUND,
                        _("Dependency '%s' was not found"),
                        dependencies[i]);
+          peas_profile_end (info, PEAS_PLUGIN_PHASE_DEPENDENCIES, &mark);
           goto error;
         }
 
@@ -827,11 +2224,17 @@ load_plugin (PeasEngine     *engine,
                        PEAS_PLUGIN_INFO_ERROR_LOADING_FAILED,
                        _("Dependency '%s' failed to load"),
                        peas_plugin_info_get_name (dep_info));
+          peas_profile_end (info, PEAS_PLUGIN_PHASE_DEPENDENCIES, &mark);
           goto error;
         }
     }
 
+  if (dependencies[0] != NULL)
+    peas_profile_end (info, PEAS_PLUGIN_PHASE_DEPENDENCIES, &mark);
+
+  peas_profile_begin (&mark);
   loader = get_plugin_loader (engine, info);
+  peas_profile_end (info, PEAS_PLUGIN_PHASE_LOADER, &mark);
 
   if (loader == NULL)
     {
@@ -845,7 +2248,13 @@ load_plugin (PeasEngine     *engine,
       goto error;
     }
 
-  if (!peas_plugin_loader_load (loader, info))
+  begin_time = peas_trace_begin ();
+  peas_profile_begin (&mark);
+  loaded = peas_plugin_loader_load (loader, info);
+  peas_profile_end (info, PEAS_PLUGIN_PHASE_LOAD, &mark);
+  peas_trace_end ("load", peas_plugin_info_get_module_name (info), begin_time);
+
+  if (!loaded)
     {
       g_warning ("Error loading plugin '%s'",
                  peas_plugin_info_get_module_name (info));
@@ -872,7 +2281,14 @@ static void
 peas_engine_load_plugin_real (PeasEngine     *engine,
                               PeasPluginInfo *info)
 {
-  if (load_plugin (engine, info))
+  gboolean was_deferred;
+
+  was_deferred = g_hash_table_remove (engine->priv->deferred, info);
+
+  /* A deferred plugin was already listed as loaded,
+   * failing to load it drops it from the list
+   */
+  if (load_plugin (engine, info) || was_deferred)
     g_object_notify_by_pspec (G_OBJECT (engine),
                               properties[PROP_LOADED_PLUGINS]);
 }
@@ -911,9 +2327,11 @@ static void
 peas_engine_unload_plugin_real (PeasEngine     *engine,
                                 PeasPluginInfo *info)
 {
-  GList *item;
-  const gchar *module_name;
+  GPtrArray *dependants;
+  guint i;
   PeasPluginLoader *loader;
+  PeasProfileMark mark;
+  gint64 begin_time;
 
   if (!peas_plugin_info_is_loaded (info) ||
       !peas_plugin_info_is_available (info, NULL))
@@ -924,23 +2342,27 @@ peas_engine_unload_plugin_real (PeasEngine     *engine,
   info->loaded = FALSE;
 
   /* First unload all the dependant plugins */
-  module_name = peas_plugin_info_get_module_name (info);
-  for (item = engine->priv->plugin_list; item; item = item->next)
+  dependants = g_hash_table_lookup (engine->priv->dependants,
+                                    peas_plugin_info_get_module_name (info));
+  for (i = 0; dependants != NULL && i < dependants->len; ++i)
     {
-      PeasPluginInfo *other_info = PEAS_PLUGIN_INFO (item->data);
-
-      if (!peas_plugin_info_is_loaded (other_info))
-        continue;
+      PeasPluginInfo *other_info = g_ptr_array_index (dependants, i);
 
-      if (peas_plugin_info_has_dependency (other_info, module_name))
-         peas_engine_unload_plugin (engine, other_info);
+      if (peas_plugin_info_is_loaded (other_info))
+        peas_engine_unload_plugin (engine, other_info);
     }
 
+  remove_deferred_dependants (engine, info);
+
   /* find the loader and tell it to gc and unload the plugin */
   loader = get_plugin_loader (engine, info);
 
+  peas_profile_begin (&mark);
   peas_plugin_loader_garbage_collect (loader);
+  begin_time = peas_trace_begin ();
   peas_plugin_loader_unload (loader, info);
+  peas_trace_end ("unload", peas_plugin_info_get_module_name (info), begin_time);
+  peas_profile_end (info, PEAS_PLUGIN_PHASE_UNLOAD, &mark);
 
   g_debug ("Unloaded plugin '%s'", peas_plugin_info_get_module_name (info));
 
@@ -968,6 +2390,15 @@ peas_engine_unload_plugin (PeasEngine     *engine,
   g_return_val_if_fail (PEAS_IS_ENGINE (engine), FALSE);
   g_return_val_if_fail (info != NULL, FALSE);
 
+  /* Nothing was loaded yet */
+  if (g_hash_table_remove (engine->priv->deferred, info))
+    {
+      remove_deferred_dependants (engine, info);
+      g_object_notify_by_pspec (G_OBJECT (engine),
+                                properties[PROP_LOADED_PLUGINS]);
+      return TRUE;
+    }
+
   if (!peas_plugin_info_is_loaded (info))
     return TRUE;
 
@@ -976,6 +2407,22 @@ peas_engine_unload_plugin (PeasEngine     *engine,
   return !peas_plugin_info_is_loaded (info);
 }
 
+static gboolean
+declares_extension (PeasPluginInfo *info,
+                    GType           extension_type)
+{
+  const gchar *type_name = g_type_name (extension_type);
+  guint i;
+
+  for (i = 0; info->extensions[i] != NULL; ++i)
+    {
+      if (g_strcmp0 (info->extensions[i], type_name) == 0)
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
 /**
  * peas_engine_provides_extension:
  * @engine: A #PeasEngine.
@@ -983,7 +2430,13 @@ peas_engine_unload_plugin (PeasEngine     *engine,
  * @extension_type: The extension #GType.
  *
  * Returns if @info provides an extension for @extension_type.
- * If the @info is not loaded than %FALSE will always be returned.
+ * If the @info is not loaded than %FALSE will always be returned,
+ * unless loading it was deferred, see #PeasEngine:lazy-load.
+ *
+ * If @info declares its extension types, see
+ * peas_plugin_info_get_extensions(), they are used instead of asking
+ * the plugin loader and a deferred plugin is only loaded if it
+ * declares @extension_type.
  *
  * Returns: if @info provides an extension for @extension_type.
  */
@@ -998,9 +2451,21 @@ peas_engine_provides_extension (PeasEngine     *engine,
   g_return_val_if_fail (info != NULL, FALSE);
   g_return_val_if_fail (G_TYPE_IS_INTERFACE (extension_type), FALSE);
 
+  /* Plugins that declare their extension types
+   * are neither loaded nor asked by their loader
+   */
+  if (info->extensions != NULL &&
+      !declares_extension (info, extension_type))
+    return FALSE;
+
+  load_deferred_plugin (engine, info);
+
   if (!peas_plugin_info_is_loaded (info))
     return FALSE;
 
+  if (info->extensions != NULL)
+    return TRUE;
+
   loader = get_plugin_loader (engine, info);
   return peas_plugin_loader_provides_extension (loader, info, extension_type);
 }
@@ -1034,15 +2499,22 @@ peas_engine_create_extensionv (PeasEngine     *engine,
 {
   PeasPluginLoader *loader;
   PeasExtension *extension;
+  PeasProfileMark mark;
 
   g_return_val_if_fail (PEAS_IS_ENGINE (engine), NULL);
   g_return_val_if_fail (info != NULL, NULL);
+
+  load_deferred_plugin (engine, info);
+
   g_return_val_if_fail (peas_plugin_info_is_loaded (info), NULL);
   g_return_val_if_fail (G_TYPE_IS_INTERFACE (extension_type), FALSE);
 
   loader = get_plugin_loader (engine, info);
+
+  peas_profile_begin (&mark);
   extension = peas_plugin_loader_create_extension (loader, info, extension_type,
                                                    n_parameters, parameters);
+  peas_profile_end (info, PEAS_PLUGIN_PHASE_CREATE_EXTENSION, &mark);
 
   if (!G_TYPE_CHECK_INSTANCE_TYPE (extension, extension_type))
     {
@@ -1086,6 +2558,9 @@ peas_engine_create_extension_valist (PeasEngine     *engine,
 
   g_return_val_if_fail (PEAS_IS_ENGINE (engine), NULL);
   g_return_val_if_fail (info != NULL, NULL);
+
+  load_deferred_plugin (engine, info);
+
   g_return_val_if_fail (peas_plugin_info_is_loaded (info), NULL);
   g_return_val_if_fail (G_TYPE_IS_INTERFACE (extension_type), FALSE);
 
@@ -1143,7 +2618,6 @@ peas_engine_create_extension (PeasEngine     *engine,
 
   g_return_val_if_fail (PEAS_IS_ENGINE (engine), NULL);
   g_return_val_if_fail (info != NULL, NULL);
-  g_return_val_if_fail (peas_plugin_info_is_loaded (info), NULL);
   g_return_val_if_fail (G_TYPE_IS_INTERFACE (extension_type), FALSE);
 
   va_start (var_args, first_property);
@@ -1160,6 +2634,8 @@ peas_engine_create_extension (PeasEngine     *engine,
  *
  * Returns the list of the names of all the loaded plugins, or an array
  * containing a single %NULL element if there is no plugin currently loaded.
+ * The plugins whose loading was deferred are included,
+ * see #PeasEngine:lazy-load.
  *
  * Please note that the returned array is a newly allocated one: you will need
  * to free it using g_strfreev().
@@ -1182,7 +2658,8 @@ peas_engine_get_loaded_plugins (PeasEngine *engine)
       PeasPluginInfo *info = (PeasPluginInfo *) pl->data;
       gchar *module_name;
 
-      if (peas_plugin_info_is_loaded (info))
+      if (peas_plugin_info_is_loaded (info) ||
+          g_hash_table_contains (engine->priv->deferred, info))
         {
           module_name = g_strdup (peas_plugin_info_get_module_name (info));
           g_array_append_val (array, module_name);
@@ -1192,19 +2669,130 @@ peas_engine_get_loaded_plugins (PeasEngine *engine)
   return (gchar **) g_array_free (array, FALSE);
 }
 
-static gboolean
-string_in_strv (const gchar  *needle,
-                const gchar **haystack)
+/* Adds @info and its dependencies to @needed and the ones that are
+ * not loaded yet to @load_plan, the dependencies always come first
+ */
+static void
+resolve_plugin (PeasEngine     *engine,
+                PeasPluginInfo *info,
+                GHashTable     *needed,
+                GPtrArray      *load_plan)
 {
+  const gchar **dependencies;
   guint i;
 
-  if (haystack == NULL)
-    return FALSE;
+  if (g_hash_table_contains (needed, info))
+    return;
 
-  for (i = 0; haystack[i] != NULL; i++)
-    if (strcmp (haystack[i], needle) == 0)
-      return TRUE;
-  return FALSE;
+  g_hash_table_add (needed, info);
+
+  dependencies = peas_plugin_info_get_dependencies (info);
+  for (i = 0; dependencies[i] != NULL; ++i)
+    {
+      PeasPluginInfo *dep_info;
+
+      /* load_plugin() will complain about it */
+      dep_info = peas_engine_get_plugin_info (engine, dependencies[i]);
+      if (dep_info != NULL)
+        resolve_plugin (engine, dep_info, needed, load_plan);
+    }
+
+  if (!peas_plugin_info_is_loaded (info))
+    g_ptr_array_add (load_plan, info);
+}
+
+typedef struct {
+  PeasPluginLoader *loader;
+  PeasPluginInfo *info;
+} PrepareItem;
+
+static void
+prepare_plugin (PrepareItem *item)
+{
+  PeasProfileMark mark;
+
+  peas_profile_begin (&mark);
+  peas_plugin_loader_prepare (item->loader, item->info);
+  peas_profile_end (item->info, PEAS_PLUGIN_PHASE_PREPARE, &mark);
+}
+
+static void
+prepare_plugin_thread (PrepareItem *item,
+                       gpointer     user_data)
+{
+  prepare_plugin (item);
+}
+
+/* Lets the loaders do the thread-safe part of loading the plugins of
+ * @load_plan concurrently, the order does not matter as nothing is
+ * registered until the plugins are loaded on this thread. Returns the
+ * prepared plugins which must be passed to unprepare_plugins().
+ */
+static PrepareItem *
+prepare_plugins (PeasEngine *engine,
+                 GPtrArray  *load_plan,
+                 guint      *n_prepared)
+{
+  PrepareItem *items;
+  GThreadPool *pool;
+  guint i, n_items = 0;
+
+  items = g_new (PrepareItem, load_plan->len);
+
+  /* The loaders are created here as it is not thread-safe */
+  for (i = 0; i < load_plan->len; ++i)
+    {
+      PeasPluginInfo *info = g_ptr_array_index (load_plan, i);
+      PeasPluginLoader *loader;
+
+      if (peas_plugin_info_is_loaded (info))
+        continue;
+
+      loader = get_plugin_loader (engine, info);
+
+      if (loader == NULL)
+        continue;
+
+      items[n_items].loader = loader;
+      items[n_items].info = info;
+      ++n_items;
+    }
+
+  if (n_items > 1)
+    {
+      pool = g_thread_pool_new ((GFunc) prepare_plugin_thread, NULL,
+                                MIN (n_items, g_get_num_processors ()),
+                                FALSE, NULL);
+
+      for (i = 0; i < n_items; ++i)
+        g_thread_pool_push (pool, &items[i], NULL);
+
+      /* Wait for all of the plugins to be prepared */
+      g_thread_pool_free (pool, FALSE, TRUE);
+    }
+  else
+    {
+      /* Not worth a thread, load() does all of the work */
+      n_items = 0;
+    }
+
+  *n_prepared = n_items;
+  return items;
+}
+
+/* Called once the plugins have been loaded, or have failed to,
+ * or were not loaded because a handler stopped the emission
+ */
+static void
+unprepare_plugins (PrepareItem *items,
+                   guint        n_items)
+{
+  guint i;
+
+  for (i = 0; i < n_items; ++i)
+    peas_plugin_loader_unprepare (items[i].loader, items[i].info);
+
+  g_free (items);
 }
 
 /**
@@ -1217,38 +2805,313 @@ string_in_strv (const gchar  *needle,
  * the #PeasEngine will load all the plugins whose names are in @plugin_names,
  * and ensures all other active plugins are unloaded.
  *
+ * The plugins are loaded after their dependencies and the dependencies
+ * of the plugins in @plugin_names are kept loaded. The
+ * #PeasEngine:loaded-plugins property is only notified once, after all
+ * the plugins have been loaded and unloaded.
+ *
  * If @plugin_names is %NULL, all plugins will be unloaded.
+ *
+ * If #PeasEngine:lazy-load is set, the plugins that are not loaded yet
+ * are only marked as enabled and loaded once they are needed.
  */
 void
 peas_engine_set_loaded_plugins (PeasEngine   *engine,
                                 const gchar **plugin_names)
 {
+  GHashTable *needed;
+  GPtrArray *load_plan;
   GList *pl;
+  guint i, n_prepared = 0;
+  PrepareItem *prepared = NULL;
+  gboolean deferred_changed = FALSE;
 
   g_return_if_fail (PEAS_IS_ENGINE (engine));
 
+  needed = g_hash_table_new (g_direct_hash, g_direct_equal);
+  load_plan = g_ptr_array_new ();
+
+  for (i = 0; plugin_names != NULL && plugin_names[i] != NULL; ++i)
+    {
+      PeasPluginInfo *info;
+
+      info = peas_engine_get_plugin_info (engine, plugin_names[i]);
+
+      if (info != NULL && peas_plugin_info_is_available (info, NULL))
+        resolve_plugin (engine, info, needed, load_plan);
+    }
+
+  if (engine->priv->parallel_load && !engine->priv->lazy_load &&
+      load_plan->len > 1)
+    prepared = prepare_plugins (engine, load_plan, &n_prepared);
+
+  g_object_freeze_notify (G_OBJECT (engine));
+
   for (pl = engine->priv->plugin_list; pl; pl = pl->next)
     {
       PeasPluginInfo *info = (PeasPluginInfo *) pl->data;
-      const gchar *module_name;
-      gboolean is_loaded;
-      gboolean to_load;
+
+      if (g_hash_table_contains (needed, info))
+        continue;
+
+      if (g_hash_table_remove (engine->priv->deferred, info))
+        deferred_changed = TRUE;
 
       if (!peas_plugin_info_is_available (info, NULL))
         continue;
 
-      module_name = peas_plugin_info_get_module_name (info);
-      is_loaded = peas_plugin_info_is_loaded (info);
+      /* The plugin may have been unloaded along with a dependency */
+      if (peas_plugin_info_is_loaded (info))
+        g_signal_emit (engine, signals[UNLOAD_PLUGIN], 0, info);
+    }
+
+  for (i = 0; i < load_plan->len; ++i)
+    {
+      PeasPluginInfo *info = g_ptr_array_index (load_plan, i);
 
-      to_load = string_in_strv (module_name, plugin_names);
+      /* The plugin may have failed to load as part of a dependant */
+      if (!peas_plugin_info_is_available (info, NULL) ||
+          peas_plugin_info_is_loaded (info))
+        continue;
 
-      if (!is_loaded && to_load)
+      if (!engine->priv->lazy_load)
         g_signal_emit (engine, signals[LOAD_PLUGIN], 0, info);
-      else if (is_loaded && !to_load)
-        g_signal_emit (engine, signals[UNLOAD_PLUGIN], 0, info);
+      else if (!g_hash_table_contains (engine->priv->deferred, info))
+        {
+          g_hash_table_add (engine->priv->deferred, info);
+          deferred_changed = TRUE;
+        }
+    }
+
+  if (prepared != NULL)
+    unprepare_plugins (prepared, n_prepared);
+
+  if (deferred_changed)
+    g_object_notify_by_pspec (G_OBJECT (engine),
+                              properties[PROP_LOADED_PLUGINS]);
+
+  g_object_thaw_notify (G_OBJECT (engine));
+
+  g_ptr_array_unref (load_plan);
+  g_hash_table_unref (needed);
+}
+
+typedef struct {
+  PeasPluginInfo *info;
+
+  /* The plugins that still have to be loaded, dependencies first */
+  GPtrArray *load_plan;
+  guint next;
+} AsyncLoad;
+
+static void
+async_load_free (AsyncLoad *async_load)
+{
+  g_ptr_array_unref (async_load->load_plan);
+  _peas_plugin_info_unref (async_load->info);
+  g_slice_free (AsyncLoad, async_load);
+}
+
+static void async_load_next (GTask *task);
+
+static void
+async_prepare_thread (GTask        *prepare_task,
+                      PeasEngine   *engine,
+                      PrepareItem  *item,
+                      GCancellable *cancellable)
+{
+  prepare_plugin (item);
+
+  g_task_return_boolean (prepare_task, TRUE);
+}
+
+static void
+async_prepare_ready (PeasEngine   *engine,
+                     GAsyncResult *result,
+                     GTask        *task)
+{
+  PrepareItem *item = g_task_get_task_data (G_TASK (result));
+
+  /* The plugin is loaded on the thread the operation was started
+   * from, unless it was cancelled while it was being prepared
+   */
+  if (g_task_return_error_if_cancelled (task))
+    {
+      peas_plugin_loader_unprepare (item->loader, item->info);
+    }
+  else
+    {
+      peas_engine_load_plugin (engine, item->info);
+      peas_plugin_loader_unprepare (item->loader, item->info);
+      async_load_next (task);
+    }
+
+  g_object_unref (task);
+}
+
+static void
+prepare_item_free (PrepareItem *item)
+{
+  _peas_plugin_info_unref (item->info);
+  g_slice_free (PrepareItem, item);
+}
+
+/* Loads the next plugin of the plan and returns once all of them were
+ * tried, a plugin that fails to load makes its dependants fail too
+ */
+static void
+async_load_next (GTask *task)
+{
+  PeasEngine *engine = g_task_get_source_object (task);
+  AsyncLoad *async_load = g_task_get_task_data (task);
+  GError *error = NULL;
+
+  while (async_load->next < async_load->load_plan->len)
+    {
+      PeasPluginInfo *info;
+      PeasPluginLoader *loader;
+      PrepareItem *item;
+      GTask *prepare_task;
+
+      info = g_ptr_array_index (async_load->load_plan, async_load->next++);
+
+      if (!peas_plugin_info_is_available (info, NULL) ||
+          peas_plugin_info_is_loaded (info))
+        continue;
+
+      loader = get_plugin_loader (engine, info);
+
+      /* load_plugin() will complain about it */
+      if (loader == NULL)
+        {
+          peas_engine_load_plugin (engine, info);
+          continue;
+        }
+
+      item = g_slice_new (PrepareItem);
+      item->loader = loader;
+      item->info = _peas_plugin_info_ref (info);
+
+      prepare_task = g_task_new (engine, g_task_get_cancellable (task),
+                                 (GAsyncReadyCallback) async_prepare_ready,
+                                 g_object_ref (task));
+      g_task_set_task_data (prepare_task, item,
+                            (GDestroyNotify) prepare_item_free);
+      g_task_run_in_thread (prepare_task,
+                            (GTaskThreadFunc) async_prepare_thread);
+      g_object_unref (prepare_task);
+      return;
+    }
+
+  if (peas_plugin_info_is_loaded (async_load->info))
+    {
+      g_task_return_boolean (task, TRUE);
+    }
+  else
+    {
+      if (peas_plugin_info_is_available (async_load->info, &error) ||
+          error == NULL)
+        {
+          g_clear_error (&error);
+          g_set_error (&error,
+                       PEAS_PLUGIN_INFO_ERROR,
+                       PEAS_PLUGIN_INFO_ERROR_LOADING_FAILED,
+                       _("Failed to load"));
+        }
+
+      g_task_return_error (task, error);
     }
 }
 
+/**
+ * peas_engine_load_plugin_async:
+ * @engine: A #PeasEngine.
+ * @info: A #PeasPluginInfo.
+ * @cancellable: (allow-none): optional #GCancellable object, %NULL to ignore.
+ * @callback: (scope async): a #GAsyncReadyCallback to call when the
+ *   plugin has been loaded.
+ * @user_data: (closure): the data to pass to @callback.
+ *
+ * Asynchronously loads the plugin corresponding to @info and its
+ * dependencies, see peas_engine_load_plugin().
+ *
+ * The dependencies are loaded one after the other, before @info. The
+ * plugin loaders that support it do the blocking part of loading each
+ * plugin on a worker thread, the "load-plugin" signal is then emitted
+ * in the thread-default main context of the thread this function was
+ * called from.
+ *
+ * If @cancellable is cancelled, no more plugins are loaded but the
+ * dependencies that were already loaded stay loaded.
+ *
+ * When the operation is finished, @callback will be called. You can
+ * then call peas_engine_load_plugin_finish() to get the result of
+ * the operation.
+ *
+ * Since: 1.6
+ */
+void
+peas_engine_load_plugin_async (PeasEngine          *engine,
+                               PeasPluginInfo      *info,
+                               GCancellable        *cancellable,
+                               GAsyncReadyCallback  callback,
+                               gpointer             user_data)
+{
+  GTask *task;
+  AsyncLoad *async_load;
+  GHashTable *needed;
+
+  g_return_if_fail (PEAS_IS_ENGINE (engine));
+  g_return_if_fail (info != NULL);
+  g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+  task = g_task_new (engine, cancellable, callback, user_data);
+
+  async_load = g_slice_new (AsyncLoad);
+  async_load->info = _peas_plugin_info_ref (info);
+  async_load->load_plan =
+        g_ptr_array_new_with_free_func ((GDestroyNotify) _peas_plugin_info_unref);
+  async_load->next = 0;
+  g_task_set_task_data (task, async_load, (GDestroyNotify) async_load_free);
+
+  needed = g_hash_table_new (g_direct_hash, g_direct_equal);
+  resolve_plugin (engine, info, needed, async_load->load_plan);
+  g_hash_table_unref (needed);
+
+  /* The plan holds references as the plugins could be
+   * removed from the engine while they are being prepared
+   */
+  g_ptr_array_foreach (async_load->load_plan,
+                       (GFunc) _peas_plugin_info_ref, NULL);
+
+  async_load_next (task);
+  g_object_unref (task);
+}
+
+/**
+ * peas_engine_load_plugin_finish:
+ * @engine: A #PeasEngine.
+ * @result: a #GAsyncResult.
+ * @error: return location for a #GError, or %NULL.
+ *
+ * Finishes an operation started with peas_engine_load_plugin_async().
+ *
+ * Returns: %TRUE if the plugin was loaded, %FALSE if it failed to
+ * load or the operation was cancelled.
+ *
+ * Since: 1.6
+ */
+gboolean
+peas_engine_load_plugin_finish (PeasEngine    *engine,
+                                GAsyncResult  *result,
+                                GError       **error)
+{
+  g_return_val_if_fail (PEAS_IS_ENGINE (engine), FALSE);
+  g_return_val_if_fail (g_task_is_valid (result, engine), FALSE);
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
+
 /**
  * peas_engine_new:
  *
@@ -1303,4 +3166,6 @@ peas_engine_shutdown (void)
       g_hash_table_destroy (loaders);
       loaders = NULL;
     }
+
+  peas_gi_clear_method_cache ();
 }
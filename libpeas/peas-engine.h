@@ -83,21 +83,70 @@ void              peas_engine_add_search_path     (PeasEngine      *engine,
 void              peas_engine_prepend_search_path (PeasEngine      *engine,
                                                    const gchar     *module_dir,
                                                    const gchar     *data_dir);
+void              peas_engine_add_search_path_async
+                                                  (PeasEngine      *engine,
+                                                   const gchar     *module_dir,
+                                                   const gchar     *data_dir,
+                                                   GCancellable    *cancellable,
+                                                   GAsyncReadyCallback callback,
+                                                   gpointer         user_data);
+gboolean          peas_engine_add_search_path_finish
+                                                  (PeasEngine      *engine,
+                                                   GAsyncResult    *result,
+                                                   GError         **error);
 
 /* plugin management */
 void              peas_engine_enable_loader       (PeasEngine      *engine,
                                                    const gchar     *loader_id);
 void              peas_engine_rescan_plugins      (PeasEngine      *engine);
+void              peas_engine_rescan_plugins_async
+                                                  (PeasEngine      *engine,
+                                                   GCancellable    *cancellable,
+                                                   GAsyncReadyCallback callback,
+                                                   gpointer         user_data);
+gboolean          peas_engine_rescan_plugins_finish
+                                                  (PeasEngine      *engine,
+                                                   GAsyncResult    *result,
+                                                   GError         **error);
 const GList      *peas_engine_get_plugin_list     (PeasEngine      *engine);
 gchar           **peas_engine_get_loaded_plugins  (PeasEngine      *engine);
 void              peas_engine_set_loaded_plugins  (PeasEngine      *engine,
                                                    const gchar    **plugin_names);
 PeasPluginInfo   *peas_engine_get_plugin_info     (PeasEngine      *engine,
                                                    const gchar     *plugin_name);
+GList            *peas_engine_get_dependants      (PeasEngine      *engine,
+                                                   PeasPluginInfo  *info);
+GList            *peas_engine_get_plugins_for_extension
+                                                  (PeasEngine      *engine,
+                                                   GType            extension_type);
+void              peas_engine_set_parallel_scan   (PeasEngine      *engine,
+                                                   gboolean         parallel_scan);
+gboolean          peas_engine_get_parallel_scan   (PeasEngine      *engine);
+void              peas_engine_set_parallel_load   (PeasEngine      *engine,
+                                                   gboolean         parallel_load);
+gboolean          peas_engine_get_parallel_load   (PeasEngine      *engine);
+void              peas_engine_set_lazy_load       (PeasEngine      *engine,
+                                                   gboolean         lazy_load);
+gboolean          peas_engine_get_lazy_load       (PeasEngine      *engine);
+gboolean          peas_engine_is_plugin_deferred  (PeasEngine      *engine,
+                                                   PeasPluginInfo  *info);
+void              peas_engine_set_monitor_search_paths
+                                                  (PeasEngine      *engine,
+                                                   gboolean         monitor_search_paths);
+gboolean          peas_engine_get_monitor_search_paths
+                                                  (PeasEngine      *engine);
 
 /* plugin loading and unloading */
 gboolean          peas_engine_load_plugin         (PeasEngine      *engine,
                                                    PeasPluginInfo  *info);
+void              peas_engine_load_plugin_async   (PeasEngine      *engine,
+                                                   PeasPluginInfo  *info,
+                                                   GCancellable    *cancellable,
+                                                   GAsyncReadyCallback callback,
+                                                   gpointer         user_data);
+gboolean          peas_engine_load_plugin_finish  (PeasEngine      *engine,
+                                                   GAsyncResult    *result,
+                                                   GError         **error);
 gboolean          peas_engine_unload_plugin       (PeasEngine      *engine,
                                                    PeasPluginInfo  *info);
 void              peas_engine_garbage_collect     (PeasEngine      *engine);
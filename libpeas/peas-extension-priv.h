@@ -0,0 +1,38 @@
+/*
+ * peas-extension-priv.h
+ * This file is part of libpeas
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Library General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __PEAS_EXTENSION_PRIV_H__
+#define __PEAS_EXTENSION_PRIV_H__
+
+#include "peas-extension.h"
+#include "peas-introspection.h"
+
+G_BEGIN_DECLS
+
+struct _PeasExtensionMethod {
+  gint refcount;
+
+  GType exten_type;
+  gchar *name;
+  PeasGISignature *signature;
+};
+
+G_END_DECLS
+
+#endif /* __PEAS_EXTENSION_PRIV_H__ */
@@ -30,6 +30,8 @@
 #include "peas-marshal.h"
 #include "peas-helpers.h"
 #include "peas-introspection.h"
+#include "peas-extension-priv.h"
+#include "peas-extension-wrapper.h"
 
 /**
  * SECTION:peas-extension-set
@@ -94,15 +96,34 @@ struct _PeasExtensionSetPrivate {
   guint n_parameters;
   GParameter *parameters;
 
-  GList *extensions;
+  /* Items are appended, and iterated from the end so that the
+   * most recently added extension comes first. The index maps a
+   * PeasPluginInfo to its slot in the array, plus one.
+   */
+  GArray *extensions;
+  GHashTable *index;
+
+  /* While the extensions are being iterated, removed items stay in
+   * the array as tombstones and are only compacted once the last
+   * iteration is over, see begin_iteration()
+   */
+  guint iteration_depth;
+  guint iteration_stamp;
+  guint n_tombstones;
 
   gulong load_handler_id;
   gulong unload_handler_id;
+  gulong loaded_plugins_handler_id;
 };
 
 typedef struct {
   PeasPluginInfo *info;
   PeasExtension *exten;
+
+  /* The stamp of the newest iteration when the item
+   * was removed during an iteration, or 0
+   */
+  guint removed_stamp;
 } ExtensionItem;
 
 typedef struct {
@@ -191,15 +212,107 @@ peas_extension_set_get_property (GObject    *object,
     }
 }
 
+#define EXTENSION_ITEM(set, i) \
+  (&g_array_index ((set)->priv->extensions, ExtensionItem, (i)))
+
+/* Plugins can be loaded or unloaded by the extensions being called,
+ * so the array is iterated in place with the following rules:
+ * - items added while iterating are appended after the first
+ *   @n_items ones and are not visited by the current iterations,
+ * - items removed while iterating keep their slot and their ref
+ *   on the extension, so the indexes stay valid. They are still
+ *   visited by the iterations that were already running, but not
+ *   by the ones started after the removal.
+ * The tombstones are compacted by the end of the outermost iteration.
+ */
+static guint
+begin_iteration (PeasExtensionSet *set,
+                 guint            *n_items)
+{
+  /* The extensions being called could drop the last ref on the set */
+  g_object_ref (set);
+
+  *n_items = set->priv->extensions->len;
+  set->priv->iteration_depth++;
+
+  return ++set->priv->iteration_stamp;
+}
+
+/* Returns the item in @slot if the iteration of @stamp visits it.
+ * The pointer is only valid until an extension gets added.
+ */
+static ExtensionItem *
+get_iteration_item (PeasExtensionSet *set,
+                    guint             slot,
+                    guint             stamp)
+{
+  ExtensionItem *item = EXTENSION_ITEM (set, slot);
+
+  if (item->removed_stamp != 0 && item->removed_stamp < stamp)
+    return NULL;
+
+  return item;
+}
+
+static void
+end_iteration (PeasExtensionSet *set)
+{
+  guint i, n_items = 0;
+
+  g_assert (set->priv->iteration_depth > 0);
+
+  if (--set->priv->iteration_depth > 0)
+    {
+      g_object_unref (set);
+      return;
+    }
+
+  set->priv->iteration_stamp = 0;
+
+  if (set->priv->n_tombstones == 0)
+    {
+      g_object_unref (set);
+      return;
+    }
+
+  for (i = 0; i < set->priv->extensions->len; ++i)
+    {
+      ExtensionItem *item = EXTENSION_ITEM (set, i);
+
+      if (item->removed_stamp != 0)
+        {
+          g_object_unref (item->exten);
+          continue;
+        }
+
+      if (i != n_items)
+        {
+          *EXTENSION_ITEM (set, n_items) = *item;
+          g_hash_table_insert (set->priv->index, item->info,
+                               GUINT_TO_POINTER (n_items + 1));
+        }
+
+      n_items++;
+    }
+
+  g_array_set_size (set->priv->extensions, n_items);
+  set->priv->n_tombstones = 0;
+
+  g_object_unref (set);
+}
+
 static void
 add_extension (PeasExtensionSet *set,
                PeasPluginInfo   *info)
 {
   PeasExtension *exten;
-  ExtensionItem *item;
+  ExtensionItem item;
 
-  /* Let's just ignore unloaded plugins... */
-  if (!peas_plugin_info_is_loaded (info))
+  /* Let's just ignore unloaded plugins, but not the ones
+   * whose loading was deferred as this is when they are needed
+   */
+  if (!peas_plugin_info_is_loaded (info) &&
+      !peas_engine_is_plugin_deferred (set->priv->engine, info))
     return;
 
   if (!peas_engine_provides_extension (set->priv->engine, info,
@@ -211,48 +324,149 @@ add_extension (PeasExtensionSet *set,
                                          set->priv->n_parameters,
                                          set->priv->parameters);
 
-  item = (ExtensionItem *) g_slice_new (ExtensionItem);
-  item->info = info;
-  item->exten = exten;
+  item.info = info;
+  item.exten = exten;
+  item.removed_stamp = 0;
 
-  set->priv->extensions = g_list_prepend (set->priv->extensions, item);
+  g_array_append_val (set->priv->extensions, item);
+  g_hash_table_insert (set->priv->index, info,
+                       GUINT_TO_POINTER (set->priv->extensions->len));
   g_signal_emit (set, signals[EXTENSION_ADDED], 0, info, exten);
 }
 
 static void
-remove_extension_item (PeasExtensionSet *set,
-                       ExtensionItem    *item)
+remove_extension (PeasExtensionSet *set,
+                  PeasPluginInfo   *info)
+{
+  guint slot, i;
+  ExtensionItem item;
+
+  slot = GPOINTER_TO_UINT (g_hash_table_lookup (set->priv->index, info));
+  if (slot == 0)
+    return;
+
+  slot--;
+  g_hash_table_remove (set->priv->index, info);
+
+  /* The iterations rely on the slots, so the item
+   * becomes a tombstone until they are all over
+   */
+  if (set->priv->iteration_depth > 0)
+    {
+      ExtensionItem *tombstone = EXTENSION_ITEM (set, slot);
+
+      tombstone->removed_stamp = set->priv->iteration_stamp;
+      set->priv->n_tombstones++;
+
+      g_signal_emit (set, signals[EXTENSION_REMOVED], 0,
+                     tombstone->info, tombstone->exten);
+      return;
+    }
+
+  /* Take the item out before emitting the signal
+   * so the handlers see a consistent set
+   */
+  item = *EXTENSION_ITEM (set, slot);
+  g_array_remove_index (set->priv->extensions, slot);
+
+  /* Removing shifts the following items down, which keeps the order */
+  for (i = slot; i < set->priv->extensions->len; ++i)
+    g_hash_table_insert (set->priv->index, EXTENSION_ITEM (set, i)->info,
+                         GUINT_TO_POINTER (i + 1));
+
+  g_signal_emit (set, signals[EXTENSION_REMOVED], 0, item.info, item.exten);
+
+  g_object_unref (item.exten);
+}
+
+/* Whether loading @info could give an extension for the set: it
+ * declares the type, or it does not declare any so the loader has
+ * to be asked
+ */
+static gboolean
+may_provide_extension (PeasExtensionSet *set,
+                       PeasPluginInfo   *info)
 {
-  g_signal_emit (set, signals[EXTENSION_REMOVED], 0, item->info, item->exten);
+  const gchar **extensions;
+  const gchar *type_name;
+  guint i;
+
+  extensions = peas_plugin_info_get_extensions (info);
+  if (extensions == NULL)
+    return TRUE;
 
-  g_object_unref (item->exten);
+  type_name = g_type_name (set->priv->exten_type);
+
+  for (i = 0; extensions[i] != NULL; ++i)
+    {
+      if (strcmp (extensions[i], type_name) == 0)
+        return TRUE;
+    }
 
-  g_slice_free (ExtensionItem, item);
+  return FALSE;
 }
 
+/* Newly enabled plugins are only loaded when asked for an extension,
+ * the extensions are then added by the load-plugin handler
+ */
 static void
-remove_extension (PeasExtensionSet *set,
-                  PeasPluginInfo   *info)
+load_deferred_plugins (PeasExtensionSet *set)
 {
-  GList *l;
-  ExtensionItem *item;
+  GList *plugins, *l;
+  GPtrArray *deferred;
+  guint i;
 
-  for (l = set->priv->extensions; l; l = l->next)
+  deferred = g_ptr_array_new ();
+
+  /* Loading a plugin changes the list of deferred plugins */
+  plugins = (GList *) peas_engine_get_plugin_list (set->priv->engine);
+  for (l = plugins; l; l = l->next)
     {
-      item = (ExtensionItem *) l->data;
-      if (item->info != info)
-        continue;
+      PeasPluginInfo *info = (PeasPluginInfo *) l->data;
+
+      if (peas_engine_is_plugin_deferred (set->priv->engine, info) &&
+          may_provide_extension (set, info))
+        g_ptr_array_add (deferred, info);
+    }
 
-      remove_extension_item (set, item);
-      set->priv->extensions = g_list_delete_link (set->priv->extensions, l);
+  if (deferred->len == 0)
+    {
+      g_ptr_array_unref (deferred);
       return;
     }
+
+  /* Every load notifies PeasEngine:loaded-plugins, which would call
+   * this again for each of them. The notifications are merged into
+   * one which is emitted while the handler is still blocked.
+   */
+  g_signal_handler_block (set->priv->engine,
+                          set->priv->loaded_plugins_handler_id);
+  g_object_freeze_notify (G_OBJECT (set->priv->engine));
+
+  for (i = 0; i < deferred->len; ++i)
+    {
+      PeasPluginInfo *info = g_ptr_array_index (deferred, i);
+
+      /* It may have been loaded as a dependency of a previous one */
+      if (peas_engine_is_plugin_deferred (set->priv->engine, info))
+        peas_engine_provides_extension (set->priv->engine, info,
+                                        set->priv->exten_type);
+    }
+
+  g_object_thaw_notify (G_OBJECT (set->priv->engine));
+  g_signal_handler_unblock (set->priv->engine,
+                            set->priv->loaded_plugins_handler_id);
+
+  g_ptr_array_unref (deferred);
 }
 
 static void
 peas_extension_set_init (PeasExtensionSet *set)
 {
   set->priv = G_TYPE_INSTANCE_GET_PRIVATE (set, PEAS_TYPE_EXTENSION_SET, PeasExtensionSetPrivate);
+
+  set->priv->extensions = g_array_new (FALSE, FALSE, sizeof (ExtensionItem));
+  set->priv->index = g_hash_table_new (g_direct_hash, g_direct_equal);
 }
 
 static void
@@ -266,10 +480,25 @@ peas_extension_set_constructed (GObject *object)
 
   g_object_ref (set->priv->engine);
 
-  plugins = (GList *) peas_engine_get_plugin_list (set->priv->engine);
+  /* The plugins that declare the type are found in the index,
+   * only the ones that do not declare their types are asked
+   */
+  plugins = peas_engine_get_plugins_for_extension (set->priv->engine,
+                                                   set->priv->exten_type);
   for (l = plugins; l; l = l->next)
     add_extension (set, (PeasPluginInfo *) l->data);
 
+  g_list_free (plugins);
+
+  plugins = (GList *) peas_engine_get_plugin_list (set->priv->engine);
+  for (l = plugins; l; l = l->next)
+    {
+      PeasPluginInfo *info = (PeasPluginInfo *) l->data;
+
+      if (peas_plugin_info_get_extensions (info) == NULL)
+        add_extension (set, info);
+    }
+
   set->priv->load_handler_id =
           g_signal_connect_data (set->priv->engine, "load-plugin",
                                  G_CALLBACK (add_extension), set,
@@ -278,6 +507,10 @@ peas_extension_set_constructed (GObject *object)
           g_signal_connect_data (set->priv->engine, "unload-plugin",
                                  G_CALLBACK (remove_extension), set,
                                  NULL, G_CONNECT_SWAPPED);
+  set->priv->loaded_plugins_handler_id =
+          g_signal_connect_data (set->priv->engine, "notify::loaded-plugins",
+                                 G_CALLBACK (load_deferred_plugins), set,
+                                 NULL, G_CONNECT_SWAPPED);
 
   G_OBJECT_CLASS (peas_extension_set_parent_class)->constructed (object);
 }
@@ -286,7 +519,7 @@ static void
 peas_extension_set_dispose (GObject *object)
 {
   PeasExtensionSet *set = PEAS_EXTENSION_SET (object);
-  GList *l;
+  guint i;
 
   if (set->priv->load_handler_id != 0)
     {
@@ -300,13 +533,21 @@ peas_extension_set_dispose (GObject *object)
       set->priv->unload_handler_id = 0;
     }
 
-  if (set->priv->extensions != NULL)
+  if (set->priv->loaded_plugins_handler_id != 0)
     {
-      for (l = set->priv->extensions; l != NULL; l = l->next)
-        remove_extension_item (set, (ExtensionItem *) l->data);
+      g_signal_handler_disconnect (set->priv->engine,
+                                   set->priv->loaded_plugins_handler_id);
+      set->priv->loaded_plugins_handler_id = 0;
+    }
 
-      g_list_free (set->priv->extensions);
-      set->priv->extensions = NULL;
+  /* Tombstones are already removed, and are released
+   * by the end of the iteration that is still running
+   */
+  for (i = set->priv->extensions->len; i > 0; --i)
+    {
+      if (i <= set->priv->extensions->len &&
+          EXTENSION_ITEM (set, i - 1)->removed_stamp == 0)
+        remove_extension (set, EXTENSION_ITEM (set, i - 1)->info);
     }
 
   if (set->priv->parameters != NULL)
@@ -319,6 +560,19 @@ peas_extension_set_dispose (GObject *object)
     }
 
   g_clear_object (&set->priv->engine);
+
+  G_OBJECT_CLASS (peas_extension_set_parent_class)->dispose (object);
+}
+
+static void
+peas_extension_set_finalize (GObject *object)
+{
+  PeasExtensionSet *set = PEAS_EXTENSION_SET (object);
+
+  g_array_unref (set->priv->extensions);
+  g_hash_table_unref (set->priv->index);
+
+  G_OBJECT_CLASS (peas_extension_set_parent_class)->finalize (object);
 }
 
 static gboolean
@@ -327,15 +581,23 @@ peas_extension_set_call_real (PeasExtensionSet *set,
                               GIArgument       *args)
 {
   gboolean ret = TRUE;
-  GList *l;
+  guint i, n_items, stamp;
+  ExtensionItem *item;
   GIArgument dummy;
 
-  for (l = set->priv->extensions; l; l = l->next)
+  stamp = begin_iteration (set, &n_items);
+
+  for (i = n_items; i > 0; --i)
     {
-      ExtensionItem *item = (ExtensionItem *) l->data;
-      ret = peas_extension_callv (item->exten, method_name, args, &dummy) && ret;
+      item = get_iteration_item (set, i - 1, stamp);
+
+      if (item != NULL)
+        ret = peas_extension_callv (item->exten, method_name,
+                                    args, &dummy) && ret;
     }
 
+  end_iteration (set);
+
   return ret;
 }
 
@@ -349,6 +611,7 @@ peas_extension_set_class_init (PeasExtensionSetClass *klass)
   object_class->get_property = peas_extension_set_get_property;
   object_class->constructed = peas_extension_set_constructed;
   object_class->dispose = peas_extension_set_dispose;
+  object_class->finalize = peas_extension_set_finalize;
 
   klass->call = peas_extension_set_call_real;
 
@@ -451,20 +714,16 @@ PeasExtension *
 peas_extension_set_get_extension (PeasExtensionSet *set,
                                   PeasPluginInfo   *info)
 {
-  GList *l;
+  guint slot;
 
   g_return_val_if_fail (PEAS_IS_EXTENSION_SET (set), NULL);
   g_return_val_if_fail (info != NULL, NULL);
 
-  for (l = set->priv->extensions; l != NULL; l = l->next)
-    {
-      ExtensionItem *item = l->data;
-
-      if (item->info == info)
-        return item->exten;
-    }
+  slot = GPOINTER_TO_UINT (g_hash_table_lookup (set->priv->index, info));
+  if (slot == 0)
+    return NULL;
 
-  return NULL;
+  return EXTENSION_ITEM (set, slot - 1)->exten;
 }
 
 /**
@@ -518,29 +777,24 @@ peas_extension_set_call_valist (PeasExtensionSet *set,
                                 const gchar      *method_name,
                                 va_list           va_args)
 {
-  GICallableInfo *callable_info;
+  PeasGISignature *signature;
   GIArgument *args;
-  gint n_args;
 
   g_return_val_if_fail (PEAS_IS_EXTENSION_SET (set), FALSE);
   g_return_val_if_fail (method_name != NULL, FALSE);
 
-  callable_info = peas_gi_get_method_info (set->priv->exten_type, method_name);
+  signature = peas_gi_get_method_signature (set->priv->exten_type,
+                                            method_name);
 
-  if (callable_info == NULL)
+  if (signature == NULL)
     {
       g_warning ("Method '%s.%s' was not found",
                  g_type_name (set->priv->exten_type), method_name);
       return FALSE;
     }
 
-  n_args = g_callable_info_get_n_args (callable_info);
-  g_return_val_if_fail (n_args >= 0, FALSE);
-
-  args = g_newa (GIArgument, n_args);
-  peas_gi_valist_to_arguments (callable_info, va_args, args, NULL);
-
-  g_base_info_unref ((GIBaseInfo *) callable_info);
+  args = g_newa (GIArgument, signature->n_args);
+  peas_gi_signature_valist_to_arguments (signature, va_args, args, NULL);
 
   return peas_extension_set_callv (set, method_name, args);
 }
@@ -573,6 +827,741 @@ peas_extension_set_callv (PeasExtensionSet *set,
   return klass->call (set, method_name, args);
 }
 
+/**
+ * peas_extension_set_call_method:
+ * @set: A #PeasExtensionSet.
+ * @method: A #PeasExtensionMethod.
+ * @...: arguments for the method.
+ *
+ * Call @method on all the #PeasExtension instances contained in @set.
+ * The arguments are converted only once for all the extensions.
+ *
+ * See peas_extension_method_call() for more information,
+ * the return value of the method is ignored.
+ *
+ * Return value: %TRUE if all the calls were successful.
+ *
+ * Since: 1.6
+ */
+gboolean
+peas_extension_set_call_method (PeasExtensionSet    *set,
+                                PeasExtensionMethod *method,
+                                ...)
+{
+  va_list args;
+  gboolean result;
+
+  g_return_val_if_fail (PEAS_IS_EXTENSION_SET (set), FALSE);
+  g_return_val_if_fail (method != NULL, FALSE);
+
+  va_start (args, method);
+  result = peas_extension_set_call_method_valist (set, method, args);
+  va_end (args);
+
+  return result;
+}
+
+/**
+ * peas_extension_set_call_method_valist:
+ * @set: A #PeasExtensionSet.
+ * @method: A #PeasExtensionMethod.
+ * @va_args: the arguments for the method.
+ *
+ * Call @method on all the #PeasExtension instances contained in @set.
+ *
+ * See peas_extension_set_call_method() for more information.
+ *
+ * Return value: %TRUE if all the calls were successful.
+ *
+ * Since: 1.6
+ */
+gboolean
+peas_extension_set_call_method_valist (PeasExtensionSet    *set,
+                                       PeasExtensionMethod *method,
+                                       va_list              va_args)
+{
+  GIArgument *args;
+
+  g_return_val_if_fail (PEAS_IS_EXTENSION_SET (set), FALSE);
+  g_return_val_if_fail (method != NULL, FALSE);
+
+  args = g_newa (GIArgument, method->signature->n_args);
+  peas_gi_signature_valist_to_arguments (method->signature, va_args,
+                                         args, NULL);
+
+  return peas_extension_set_call_methodv (set, method, args);
+}
+
+/**
+ * peas_extension_set_call_methodv:
+ * @set: A #PeasExtensionSet.
+ * @method: A #PeasExtensionMethod.
+ * @args: the arguments for the method.
+ *
+ * Call @method on all the #PeasExtension instances contained in @set.
+ *
+ * See peas_extension_method_callv() for more information.
+ *
+ * Return value: %TRUE if all the calls were successful.
+ *
+ * Since: 1.6
+ */
+gboolean
+peas_extension_set_call_methodv (PeasExtensionSet    *set,
+                                 PeasExtensionMethod *method,
+                                 GIArgument          *args)
+{
+  gboolean ret = TRUE;
+  guint i, n_items, stamp;
+  ExtensionItem *item;
+  GIArgument dummy;
+
+  g_return_val_if_fail (PEAS_IS_EXTENSION_SET (set), FALSE);
+  g_return_val_if_fail (method != NULL, FALSE);
+  g_return_val_if_fail (g_type_is_a (set->priv->exten_type,
+                                     method->exten_type), FALSE);
+
+  stamp = begin_iteration (set, &n_items);
+
+  for (i = n_items; i > 0; --i)
+    {
+      item = get_iteration_item (set, i - 1, stamp);
+
+      if (item != NULL)
+        ret = peas_extension_method_callv (method, item->exten,
+                                           args, &dummy) && ret;
+    }
+
+  end_iteration (set);
+
+  return ret;
+}
+
+/* The job shared by the threads of a parallel call, either
+ * @method is called with @args or @func is called with @data
+ */
+typedef struct {
+  PeasExtensionSet *set;
+
+  PeasExtensionMethod *method;
+  GIArgument *args;
+
+  PeasExtensionSetForeachFunc func;
+  gpointer data;
+
+  gint failed;
+} ParallelJob;
+
+static void
+parallel_job_run (ExtensionItem *item,
+                  ParallelJob   *job)
+{
+  GIArgument dummy;
+
+  if (job->func != NULL)
+    job->func (job->set, item->info, item->exten, job->data);
+  else if (!peas_extension_method_callv (job->method, item->exten,
+                                         job->args, &dummy))
+    g_atomic_int_set (&job->failed, TRUE);
+}
+
+static void
+parallel_job_dispatch (PeasExtensionSet *set,
+                       ParallelJob      *job)
+{
+  guint i, n_items, stamp, n_native = 0;
+  ExtensionItem *item;
+  ExtensionItem *natives = NULL;
+  GThreadPool *pool = NULL;
+
+  stamp = begin_iteration (set, &n_items);
+
+  for (i = n_items; i > 0; --i)
+    {
+      item = get_iteration_item (set, i - 1, stamp);
+
+      if (item != NULL && !PEAS_IS_EXTENSION_WRAPPER (item->exten))
+        n_native++;
+    }
+
+  /* Spawning threads is not worth it for a single extension.
+   *
+   * The serial lane may add extensions, which can reallocate the
+   * array under the threads, so they get their own copy of the items.
+   * The tombstones keep the extensions alive until the end.
+   */
+  if (n_native > 1)
+    {
+      natives = g_new (ExtensionItem, n_native);
+      pool = g_thread_pool_new ((GFunc) parallel_job_run, job,
+                                MIN (n_native, g_get_num_processors ()),
+                                FALSE, NULL);
+
+      n_native = 0;
+      for (i = n_items; i > 0; --i)
+        {
+          item = get_iteration_item (set, i - 1, stamp);
+
+          if (item != NULL && !PEAS_IS_EXTENSION_WRAPPER (item->exten))
+            {
+              natives[n_native] = *item;
+              g_thread_pool_push (pool, &natives[n_native++], NULL);
+            }
+        }
+    }
+
+  /* Wrappers call into the interpreter of their loader, which is
+   * not thread-safe, so they are the serial lane of the calling thread
+   */
+  for (i = n_items; i > 0; --i)
+    {
+      item = get_iteration_item (set, i - 1, stamp);
+
+      if (item != NULL &&
+          (pool == NULL || PEAS_IS_EXTENSION_WRAPPER (item->exten)))
+        {
+          ExtensionItem serial = *item;
+
+          parallel_job_run (&serial, job);
+        }
+    }
+
+  if (pool != NULL)
+    g_thread_pool_free (pool, FALSE, TRUE);
+
+  g_free (natives);
+  end_iteration (set);
+}
+
+/**
+ * peas_extension_set_call_parallel:
+ * @set: A #PeasExtensionSet.
+ * @method: A #PeasExtensionMethod.
+ * @...: arguments for the method.
+ *
+ * Call @method on all the #PeasExtension instances contained in @set
+ * concurrently, and wait for all the calls to finish.
+ *
+ * The extensions of the C loader are called on a #GThreadPool, so
+ * this must only be used for interfaces whose implementations are
+ * thread-safe. The extensions of loaders for languages which are not
+ * thread-safe, like Python and JavaScript, are called one after the
+ * other on the calling thread.
+ *
+ * As the arguments are shared by all the calls, @method must not
+ * have out arguments. Its return value is ignored.
+ *
+ * Return value: %TRUE if all the calls were successful.
+ *
+ * Since: 1.6
+ */
+gboolean
+peas_extension_set_call_parallel (PeasExtensionSet    *set,
+                                  PeasExtensionMethod *method,
+                                  ...)
+{
+  va_list args;
+  gboolean result;
+
+  g_return_val_if_fail (PEAS_IS_EXTENSION_SET (set), FALSE);
+  g_return_val_if_fail (method != NULL, FALSE);
+
+  va_start (args, method);
+  result = peas_extension_set_call_parallel_valist (set, method, args);
+  va_end (args);
+
+  return result;
+}
+
+/**
+ * peas_extension_set_call_parallel_valist:
+ * @set: A #PeasExtensionSet.
+ * @method: A #PeasExtensionMethod.
+ * @va_args: the arguments for the method.
+ *
+ * Call @method on all the #PeasExtension instances contained in @set
+ * concurrently.
+ *
+ * See peas_extension_set_call_parallel() for more information.
+ *
+ * Return value: %TRUE if all the calls were successful.
+ *
+ * Since: 1.6
+ */
+gboolean
+peas_extension_set_call_parallel_valist (PeasExtensionSet    *set,
+                                         PeasExtensionMethod *method,
+                                         va_list              va_args)
+{
+  GIArgument *args;
+
+  g_return_val_if_fail (PEAS_IS_EXTENSION_SET (set), FALSE);
+  g_return_val_if_fail (method != NULL, FALSE);
+
+  args = g_newa (GIArgument, method->signature->n_args);
+  peas_gi_signature_valist_to_arguments (method->signature, va_args,
+                                         args, NULL);
+
+  return peas_extension_set_call_parallelv (set, method, args);
+}
+
+/**
+ * peas_extension_set_call_parallelv:
+ * @set: A #PeasExtensionSet.
+ * @method: A #PeasExtensionMethod.
+ * @args: the arguments for the method.
+ *
+ * Call @method on all the #PeasExtension instances contained in @set
+ * concurrently.
+ *
+ * See peas_extension_set_call_parallel() for more information.
+ *
+ * Return value: %TRUE if all the calls were successful.
+ *
+ * Since: 1.6
+ */
+gboolean
+peas_extension_set_call_parallelv (PeasExtensionSet    *set,
+                                   PeasExtensionMethod *method,
+                                   GIArgument          *args)
+{
+  ParallelJob job = { set, method, args, NULL, NULL, FALSE };
+
+  g_return_val_if_fail (PEAS_IS_EXTENSION_SET (set), FALSE);
+  g_return_val_if_fail (method != NULL, FALSE);
+  g_return_val_if_fail (g_type_is_a (set->priv->exten_type,
+                                     method->exten_type), FALSE);
+  g_return_val_if_fail (method->signature->n_out_args == 0, FALSE);
+
+  parallel_job_dispatch (set, &job);
+
+  return !job.failed;
+}
+
+/**
+ * peas_extension_set_call_collect:
+ * @set: A #PeasExtensionSet.
+ * @method: A #PeasExtensionMethod.
+ * @...: arguments for the method.
+ *
+ * Call @method on all the #PeasExtension instances contained in @set
+ * and collect the return values. The arguments are converted only once
+ * for all the extensions.
+ *
+ * The results are in the same order as with peas_extension_set_foreach().
+ * The return values are owned as specified by the transfer annotation of
+ * @method, and the extensions are only valid as long as they are in @set.
+ *
+ * Return value: (transfer full): a #GArray of #PeasExtensionSetResult.
+ *
+ * Since: 1.6
+ */
+GArray *
+peas_extension_set_call_collect (PeasExtensionSet    *set,
+                                 PeasExtensionMethod *method,
+                                 ...)
+{
+  va_list args;
+  GArray *results;
+
+  g_return_val_if_fail (PEAS_IS_EXTENSION_SET (set), NULL);
+  g_return_val_if_fail (method != NULL, NULL);
+
+  va_start (args, method);
+  results = peas_extension_set_call_collect_valist (set, method, args);
+  va_end (args);
+
+  return results;
+}
+
+/**
+ * peas_extension_set_call_collect_valist:
+ * @set: A #PeasExtensionSet.
+ * @method: A #PeasExtensionMethod.
+ * @va_args: the arguments for the method.
+ *
+ * Call @method on all the #PeasExtension instances contained in @set
+ * and collect the return values.
+ *
+ * See peas_extension_set_call_collect() for more information.
+ *
+ * Return value: (transfer full): a #GArray of #PeasExtensionSetResult.
+ *
+ * Since: 1.6
+ */
+GArray *
+peas_extension_set_call_collect_valist (PeasExtensionSet    *set,
+                                        PeasExtensionMethod *method,
+                                        va_list              va_args)
+{
+  GIArgument *args;
+
+  g_return_val_if_fail (PEAS_IS_EXTENSION_SET (set), NULL);
+  g_return_val_if_fail (method != NULL, NULL);
+
+  args = g_newa (GIArgument, method->signature->n_args);
+  peas_gi_signature_valist_to_arguments (method->signature, va_args,
+                                         args, NULL);
+
+  return peas_extension_set_call_collectv (set, method, args);
+}
+
+/**
+ * peas_extension_set_call_collectv:
+ * @set: A #PeasExtensionSet.
+ * @method: A #PeasExtensionMethod.
+ * @args: the arguments for the method.
+ *
+ * Call @method on all the #PeasExtension instances contained in @set
+ * and collect the return values.
+ *
+ * See peas_extension_set_call_collect() for more information.
+ *
+ * Return value: (transfer full): a #GArray of #PeasExtensionSetResult.
+ *
+ * Since: 1.6
+ */
+GArray *
+peas_extension_set_call_collectv (PeasExtensionSet    *set,
+                                  PeasExtensionMethod *method,
+                                  GIArgument          *args)
+{
+  guint i, n_items, stamp;
+  ExtensionItem *item;
+  GArray *results;
+
+  g_return_val_if_fail (PEAS_IS_EXTENSION_SET (set), NULL);
+  g_return_val_if_fail (method != NULL, NULL);
+  g_return_val_if_fail (g_type_is_a (set->priv->exten_type,
+                                     method->exten_type), NULL);
+
+  stamp = begin_iteration (set, &n_items);
+  results = g_array_sized_new (FALSE, TRUE, sizeof (PeasExtensionSetResult),
+                               n_items);
+
+  for (i = n_items; i > 0; --i)
+    {
+      PeasExtensionSetResult result = { NULL, NULL, FALSE };
+
+      item = get_iteration_item (set, i - 1, stamp);
+      if (item == NULL)
+        continue;
+
+      result.info = item->info;
+      result.exten = item->exten;
+      result.success = peas_extension_method_callv (method, result.exten, args,
+                                                    &result.return_value);
+      g_array_append_val (results, result);
+    }
+
+  end_iteration (set);
+
+  return results;
+}
+
+typedef enum {
+  STOP_ON_NON_NULL,
+  STOP_ON_TRUE,
+  STOP_ON_FALSE
+} StopCondition;
+
+/* Calls @method on the extensions until the return value of one
+ * of them meets @condition, a failed call is only a reason to stop
+ * when looking for %FALSE. Returns whether the calls were stopped.
+ */
+static gboolean
+call_until (PeasExtensionSet    *set,
+            PeasExtensionMethod *method,
+            GIArgument          *args,
+            StopCondition        condition,
+            GIArgument          *return_value)
+{
+  guint i, n_items, stamp;
+  ExtensionItem *item;
+  gboolean stopped = FALSE;
+
+  stamp = begin_iteration (set, &n_items);
+
+  for (i = n_items; i > 0 && !stopped; --i)
+    {
+      GIArgument retval;
+      gboolean stop;
+
+      item = get_iteration_item (set, i - 1, stamp);
+      if (item == NULL)
+        continue;
+
+      memset (&retval, 0, sizeof (retval));
+
+      if (!peas_extension_method_callv (method, item->exten, args, &retval))
+        stop = condition == STOP_ON_FALSE;
+      else if (condition == STOP_ON_NON_NULL)
+        stop = retval.v_pointer != NULL;
+      else if (condition == STOP_ON_TRUE)
+        stop = retval.v_boolean;
+      else
+        stop = !retval.v_boolean;
+
+      if (stop)
+        {
+          if (return_value != NULL)
+            *return_value = retval;
+
+          stopped = TRUE;
+        }
+    }
+
+  end_iteration (set);
+
+  return stopped;
+}
+
+static gboolean
+returns_pointer (PeasExtensionMethod *method)
+{
+  GITypeInfo *return_type = &method->signature->return_type;
+  GIBaseInfo *iface_info;
+  GIInfoType iface_type;
+
+  /* A gpointer return is tagged as void, like no return
+   * value at all, and is not passed back to the caller
+   */
+  switch (method->signature->return_tag)
+    {
+    case GI_TYPE_TAG_UTF8:
+    case GI_TYPE_TAG_FILENAME:
+    case GI_TYPE_TAG_ARRAY:
+    case GI_TYPE_TAG_GLIST:
+    case GI_TYPE_TAG_GSLIST:
+    case GI_TYPE_TAG_GHASH:
+    case GI_TYPE_TAG_ERROR:
+      return TRUE;
+    case GI_TYPE_TAG_INTERFACE:
+      iface_info = g_type_info_get_interface (return_type);
+      iface_type = g_base_info_get_type (iface_info);
+      g_base_info_unref (iface_info);
+
+      return iface_type != GI_INFO_TYPE_ENUM &&
+             iface_type != GI_INFO_TYPE_FLAGS;
+    default:
+      return FALSE;
+    }
+}
+
+/**
+ * peas_extension_set_call_first_non_null:
+ * @set: A #PeasExtensionSet.
+ * @method: A #PeasExtensionMethod returning a pointer.
+ * @...: arguments for the method, followed by the location
+ *   of the return value.
+ *
+ * Call @method on the #PeasExtension instances contained in @set,
+ * in the same order as with peas_extension_set_foreach(), until
+ * one of them returns a non-%NULL value. The remaining extensions
+ * are not called.
+ *
+ * @method must return a string, an object or another boxed value,
+ * methods returning a plain #gpointer are not supported.
+ *
+ * Return value: %TRUE if an extension returned a non-%NULL value.
+ *
+ * Since: 1.6
+ */
+gboolean
+peas_extension_set_call_first_non_null (PeasExtensionSet    *set,
+                                        PeasExtensionMethod *method,
+                                        ...)
+{
+  va_list va_args;
+  GIArgument *args;
+  GIArgument retval;
+  gpointer retval_ptr;
+  gboolean ret;
+
+  g_return_val_if_fail (PEAS_IS_EXTENSION_SET (set), FALSE);
+  g_return_val_if_fail (method != NULL, FALSE);
+
+  args = g_newa (GIArgument, method->signature->n_args);
+
+  va_start (va_args, method);
+  peas_gi_signature_valist_to_arguments (method->signature, va_args,
+                                         args, &retval_ptr);
+  va_end (va_args);
+
+  ret = peas_extension_set_call_first_non_nullv (set, method, args, &retval);
+
+  if (retval_ptr != NULL)
+    peas_gi_argument_to_pointer (&method->signature->return_type,
+                                 &retval, retval_ptr);
+
+  return ret;
+}
+
+/**
+ * peas_extension_set_call_first_non_nullv:
+ * @set: A #PeasExtensionSet.
+ * @method: A #PeasExtensionMethod returning a pointer.
+ * @args: the arguments for the method.
+ * @return_value: the first non-%NULL return value, or %NULL.
+ *
+ * Call @method on the #PeasExtension instances contained in @set
+ * until one of them returns a non-%NULL value.
+ *
+ * See peas_extension_set_call_first_non_null() for more information.
+ *
+ * Return value: %TRUE if an extension returned a non-%NULL value.
+ *
+ * Since: 1.6
+ */
+gboolean
+peas_extension_set_call_first_non_nullv (PeasExtensionSet    *set,
+                                         PeasExtensionMethod *method,
+                                         GIArgument          *args,
+                                         GIArgument          *return_value)
+{
+  g_return_val_if_fail (PEAS_IS_EXTENSION_SET (set), FALSE);
+  g_return_val_if_fail (method != NULL, FALSE);
+  g_return_val_if_fail (g_type_is_a (set->priv->exten_type,
+                                     method->exten_type), FALSE);
+  g_return_val_if_fail (returns_pointer (method), FALSE);
+  g_return_val_if_fail (return_value != NULL, FALSE);
+
+  return_value->v_pointer = NULL;
+
+  return call_until (set, method, args, STOP_ON_NON_NULL, return_value);
+}
+
+/**
+ * peas_extension_set_call_any_true:
+ * @set: A #PeasExtensionSet.
+ * @method: A #PeasExtensionMethod returning a #gboolean.
+ * @...: arguments for the method.
+ *
+ * Call @method on the #PeasExtension instances contained in @set,
+ * in the same order as with peas_extension_set_foreach(), until
+ * one of them returns %TRUE. The remaining extensions are not called.
+ *
+ * Return value: %TRUE if an extension returned %TRUE.
+ *
+ * Since: 1.6
+ */
+gboolean
+peas_extension_set_call_any_true (PeasExtensionSet    *set,
+                                  PeasExtensionMethod *method,
+                                  ...)
+{
+  va_list va_args;
+  GIArgument *args;
+
+  g_return_val_if_fail (PEAS_IS_EXTENSION_SET (set), FALSE);
+  g_return_val_if_fail (method != NULL, FALSE);
+
+  args = g_newa (GIArgument, method->signature->n_args);
+
+  va_start (va_args, method);
+  peas_gi_signature_valist_to_arguments (method->signature, va_args,
+                                         args, NULL);
+  va_end (va_args);
+
+  return peas_extension_set_call_any_truev (set, method, args);
+}
+
+/**
+ * peas_extension_set_call_any_truev:
+ * @set: A #PeasExtensionSet.
+ * @method: A #PeasExtensionMethod returning a #gboolean.
+ * @args: the arguments for the method.
+ *
+ * Call @method on the #PeasExtension instances contained in @set
+ * until one of them returns %TRUE.
+ *
+ * See peas_extension_set_call_any_true() for more information.
+ *
+ * Return value: %TRUE if an extension returned %TRUE.
+ *
+ * Since: 1.6
+ */
+gboolean
+peas_extension_set_call_any_truev (PeasExtensionSet    *set,
+                                   PeasExtensionMethod *method,
+                                   GIArgument          *args)
+{
+  g_return_val_if_fail (PEAS_IS_EXTENSION_SET (set), FALSE);
+  g_return_val_if_fail (method != NULL, FALSE);
+  g_return_val_if_fail (g_type_is_a (set->priv->exten_type,
+                                     method->exten_type), FALSE);
+  g_return_val_if_fail (method->signature->return_tag == GI_TYPE_TAG_BOOLEAN,
+                        FALSE);
+
+  return call_until (set, method, args, STOP_ON_TRUE, NULL);
+}
+
+/**
+ * peas_extension_set_call_all_true:
+ * @set: A #PeasExtensionSet.
+ * @method: A #PeasExtensionMethod returning a #gboolean.
+ * @...: arguments for the method.
+ *
+ * Call @method on the #PeasExtension instances contained in @set,
+ * in the same order as with peas_extension_set_foreach(), until
+ * one of them returns %FALSE or fails. The remaining extensions
+ * are not called.
+ *
+ * Return value: %TRUE if all the extensions returned %TRUE.
+ *
+ * Since: 1.6
+ */
+gboolean
+peas_extension_set_call_all_true (PeasExtensionSet    *set,
+                                  PeasExtensionMethod *method,
+                                  ...)
+{
+  va_list va_args;
+  GIArgument *args;
+
+  g_return_val_if_fail (PEAS_IS_EXTENSION_SET (set), FALSE);
+  g_return_val_if_fail (method != NULL, FALSE);
+
+  args = g_newa (GIArgument, method->signature->n_args);
+
+  va_start (va_args, method);
+  peas_gi_signature_valist_to_arguments (method->signature, va_args,
+                                         args, NULL);
+  va_end (va_args);
+
+  return peas_extension_set_call_all_truev (set, method, args);
+}
+
+/**
+ * peas_extension_set_call_all_truev:
+ * @set: A #PeasExtensionSet.
+ * @method: A #PeasExtensionMethod returning a #gboolean.
+ * @args: the arguments for the method.
+ *
+ * Call @method on the #PeasExtension instances contained in @set
+ * until one of them returns %FALSE or fails.
+ *
+ * See peas_extension_set_call_all_true() for more information.
+ *
+ * Return value: %TRUE if all the extensions returned %TRUE.
+ *
+ * Since: 1.6
+ */
+gboolean
+peas_extension_set_call_all_truev (PeasExtensionSet    *set,
+                                   PeasExtensionMethod *method,
+                                   GIArgument          *args)
+{
+  g_return_val_if_fail (PEAS_IS_EXTENSION_SET (set), FALSE);
+  g_return_val_if_fail (method != NULL, FALSE);
+  g_return_val_if_fail (g_type_is_a (set->priv->exten_type,
+                                     method->exten_type), FALSE);
+  g_return_val_if_fail (method->signature->return_tag == GI_TYPE_TAG_BOOLEAN,
+                        FALSE);
+
+  return !call_until (set, method, args, STOP_ON_FALSE, NULL);
+}
+
 /**
  * peas_extension_set_foreach:
  * @set: A #PeasExtensionSet.
@@ -588,17 +1577,53 @@ peas_extension_set_foreach (PeasExtensionSet            *set,
                             PeasExtensionSetForeachFunc  func,
                             gpointer                     data)
 {
-  GList *l;
+  guint i, n_items, stamp;
+  ExtensionItem *item;
 
   g_return_if_fail (PEAS_IS_EXTENSION_SET (set));
   g_return_if_fail (func != NULL);
 
-  for (l = set->priv->extensions; l; l = l->next)
+  stamp = begin_iteration (set, &n_items);
+
+  for (i = n_items; i > 0; --i)
     {
-      ExtensionItem *item = (ExtensionItem *) l->data;
+      item = get_iteration_item (set, i - 1, stamp);
 
-      func (set, item->info, item->exten, data);
+      if (item != NULL)
+        func (set, item->info, item->exten, data);
     }
+
+  end_iteration (set);
+}
+
+/**
+ * peas_extension_set_foreach_parallel:
+ * @set: A #PeasExtensionSet.
+ * @func: (scope call): A function call for each extension.
+ * @data: Optional data to be passed to the function or %NULL.
+ *
+ * Calls @func for each #PeasExtension concurrently, and waits
+ * for all the calls to finish.
+ *
+ * @func is called on a #GThreadPool for the extensions of the C loader,
+ * and on the calling thread for the extensions of loaders which are not
+ * thread-safe. It must therefore be thread-safe itself.
+ *
+ * See peas_extension_set_call_parallel() for more information.
+ *
+ * Since: 1.6
+ */
+void
+peas_extension_set_foreach_parallel (PeasExtensionSet            *set,
+                                     PeasExtensionSetForeachFunc  func,
+                                     gpointer                     data)
+{
+  ParallelJob job = { set, NULL, NULL, func, data, FALSE };
+
+  g_return_if_fail (PEAS_IS_EXTENSION_SET (set));
+  g_return_if_fail (func != NULL);
+
+  parallel_job_dispatch (set, &job);
 }
 
 /**
@@ -107,6 +107,29 @@ typedef void (*PeasExtensionSetForeachFunc) (PeasExtensionSet *set,
                                              PeasExtension    *exten,
                                              gpointer          data);
 
+#ifndef __GI_SCANNER__
+/**
+ * PeasExtensionSetResult:
+ * @info: the #PeasPluginInfo of the extension.
+ * @exten: the #PeasExtension the method was called on.
+ * @success: whether the call was successful.
+ * @return_value: the return value of the method.
+ *
+ * The result of calling a method on one of the extensions
+ * of a #PeasExtensionSet, see peas_extension_set_call_collect().
+ *
+ * Since: 1.6
+ */
+typedef struct _PeasExtensionSetResult PeasExtensionSetResult;
+
+struct _PeasExtensionSetResult {
+  PeasPluginInfo *info;
+  PeasExtension *exten;
+  gboolean success;
+  GIArgument return_value;
+};
+#endif
+
 /*
  * Public methods
  */
@@ -124,9 +147,77 @@ gboolean           peas_extension_set_callv       (PeasExtensionSet *set,
                                                    GIArgument       *args);
 #endif
 
+#ifndef __GI_SCANNER__
+gboolean           peas_extension_set_call_method (PeasExtensionSet    *set,
+                                                   PeasExtensionMethod *method,
+                                                   ...);
+gboolean           peas_extension_set_call_method_valist
+                                                  (PeasExtensionSet    *set,
+                                                   PeasExtensionMethod *method,
+                                                   va_list              va_args);
+gboolean           peas_extension_set_call_methodv
+                                                  (PeasExtensionSet    *set,
+                                                   PeasExtensionMethod *method,
+                                                   GIArgument          *args);
+gboolean           peas_extension_set_call_parallel
+                                                  (PeasExtensionSet    *set,
+                                                   PeasExtensionMethod *method,
+                                                   ...);
+gboolean           peas_extension_set_call_parallel_valist
+                                                  (PeasExtensionSet    *set,
+                                                   PeasExtensionMethod *method,
+                                                   va_list              va_args);
+gboolean           peas_extension_set_call_parallelv
+                                                  (PeasExtensionSet    *set,
+                                                   PeasExtensionMethod *method,
+                                                   GIArgument          *args);
+
+GArray            *peas_extension_set_call_collect
+                                                  (PeasExtensionSet    *set,
+                                                   PeasExtensionMethod *method,
+                                                   ...);
+GArray            *peas_extension_set_call_collect_valist
+                                                  (PeasExtensionSet    *set,
+                                                   PeasExtensionMethod *method,
+                                                   va_list              va_args);
+GArray            *peas_extension_set_call_collectv
+                                                  (PeasExtensionSet    *set,
+                                                   PeasExtensionMethod *method,
+                                                   GIArgument          *args);
+gboolean           peas_extension_set_call_first_non_null
+                                                  (PeasExtensionSet    *set,
+                                                   PeasExtensionMethod *method,
+                                                   ...);
+gboolean           peas_extension_set_call_first_non_nullv
+                                                  (PeasExtensionSet    *set,
+                                                   PeasExtensionMethod *method,
+                                                   GIArgument          *args,
+                                                   GIArgument          *return_value);
+gboolean           peas_extension_set_call_any_true
+                                                  (PeasExtensionSet    *set,
+                                                   PeasExtensionMethod *method,
+                                                   ...);
+gboolean           peas_extension_set_call_any_truev
+                                                  (PeasExtensionSet    *set,
+                                                   PeasExtensionMethod *method,
+                                                   GIArgument          *args);
+gboolean           peas_extension_set_call_all_true
+                                                  (PeasExtensionSet    *set,
+                                                   PeasExtensionMethod *method,
+                                                   ...);
+gboolean           peas_extension_set_call_all_truev
+                                                  (PeasExtensionSet    *set,
+                                                   PeasExtensionMethod *method,
+                                                   GIArgument          *args);
+#endif
+
 void               peas_extension_set_foreach     (PeasExtensionSet *set,
                                                    PeasExtensionSetForeachFunc func,
                                                    gpointer          data);
+void               peas_extension_set_foreach_parallel
+                                                  (PeasExtensionSet *set,
+                                                   PeasExtensionSetForeachFunc func,
+                                                   gpointer          data);
 
 PeasExtension     *peas_extension_set_get_extension (PeasExtensionSet *set,
                                                      PeasPluginInfo   *info);
@@ -29,14 +29,27 @@
 #include "peas-extension-wrapper.h"
 #include "peas-extension-subclasses.h"
 #include "peas-introspection.h"
+#include "peas-debug.h"
+
+/* The signatures that have a trampoline, see below */
+typedef enum {
+  TRAMPOLINE_NONE = 0,
+  TRAMPOLINE_VOID,
+  TRAMPOLINE_VOID_POINTER,
+  TRAMPOLINE_POINTER
+} TrampolineKind;
+
+#define N_TRAMPOLINE_KINDS TRAMPOLINE_POINTER
+#define N_TRAMPOLINE_SLOTS 8
 
 typedef struct _MethodImpl {
   GType interface_type;
-  GIFunctionInfo *invoker_info;
+  PeasGISignature *signature;
   const gchar *method_name;
   ffi_cif cif;
   ffi_closure *closure;
   guint struct_offset;
+  TrampolineKind trampoline_kind;
 } MethodImpl;
 
 static GQuark
@@ -50,6 +63,154 @@ method_impl_quark (void)
   return quark;
 }
 
+static GQuark
+trampoline_impls_quark (void)
+{
+  static GQuark quark = 0;
+
+  if (quark == 0)
+    quark = g_quark_from_static_string ("PeasExtensionTrampolineImplementations");
+
+  return quark;
+}
+
+/* Most methods are as simple as void (*) (Self *), calling them
+ * does not need a libffi closure. Instead a trampoline with the
+ * right C prototype is used, but as it cannot carry any data
+ * there is one for each of the first vfuncs of an interface.
+ * The proxy type keeps the MethodImpl used by each trampoline,
+ * two of its interfaces cannot share one so the second one
+ * falls back to the libffi closure.
+ */
+static GIArgument
+call_trampoline_impl (gpointer        instance,
+                      TrampolineKind  kind,
+                      guint           slot,
+                      GIArgument     *args)
+{
+  MethodImpl **impls;
+  MethodImpl *impl;
+  GIArgument return_value;
+
+  g_assert (PEAS_IS_EXTENSION_WRAPPER (instance));
+
+  /* Proxy types are never subclassed */
+  impls = g_type_get_qdata (G_TYPE_FROM_INSTANCE (instance),
+                            trampoline_impls_quark ());
+  impl = impls[(kind - 1) * N_TRAMPOLINE_SLOTS + slot];
+
+  if (!peas_extension_wrapper_callv (instance, impl->interface_type,
+                                     impl->signature->callable_info,
+                                     impl->method_name,
+                                     args, &return_value))
+    memset (&return_value, 0, sizeof (GIArgument));
+
+  return return_value;
+}
+
+#define DEFINE_TRAMPOLINES(slot) \
+  static void \
+  trampoline_void_##slot (gpointer instance) \
+  { \
+    call_trampoline_impl (instance, TRAMPOLINE_VOID, slot, NULL); \
+  } \
+  static void \
+  trampoline_void_pointer_##slot (gpointer instance, \
+                                  gpointer arg) \
+  { \
+    GIArgument args[1]; \
+    args[0].v_pointer = arg; \
+    call_trampoline_impl (instance, TRAMPOLINE_VOID_POINTER, slot, args); \
+  } \
+  static gpointer \
+  trampoline_pointer_##slot (gpointer instance) \
+  { \
+    return call_trampoline_impl (instance, TRAMPOLINE_POINTER, \
+                                 slot, NULL).v_pointer; \
+  }
+
+DEFINE_TRAMPOLINES (0)
+DEFINE_TRAMPOLINES (1)
+DEFINE_TRAMPOLINES (2)
+DEFINE_TRAMPOLINES (3)
+DEFINE_TRAMPOLINES (4)
+DEFINE_TRAMPOLINES (5)
+DEFINE_TRAMPOLINES (6)
+DEFINE_TRAMPOLINES (7)
+
+#undef DEFINE_TRAMPOLINES
+
+#define TRAMPOLINE_TABLE(kind) \
+  { (gpointer) trampoline_##kind##_0, (gpointer) trampoline_##kind##_1, \
+    (gpointer) trampoline_##kind##_2, (gpointer) trampoline_##kind##_3, \
+    (gpointer) trampoline_##kind##_4, (gpointer) trampoline_##kind##_5, \
+    (gpointer) trampoline_##kind##_6, (gpointer) trampoline_##kind##_7 }
+
+static const gpointer trampolines[N_TRAMPOLINE_KINDS][N_TRAMPOLINE_SLOTS] = {
+  TRAMPOLINE_TABLE (void),
+  TRAMPOLINE_TABLE (void_pointer),
+  TRAMPOLINE_TABLE (pointer)
+};
+
+#undef TRAMPOLINE_TABLE
+
+/* Only used by the tests to check which methods got a trampoline */
+gboolean
+peas_extension_subclass_is_trampoline (gpointer method)
+{
+  guint kind, slot;
+
+  for (kind = 0; kind < N_TRAMPOLINE_KINDS; ++kind)
+    {
+      for (slot = 0; slot < N_TRAMPOLINE_SLOTS; ++slot)
+        {
+          if (trampolines[kind][slot] == method)
+            return TRUE;
+        }
+    }
+
+  return FALSE;
+}
+
+static TrampolineKind
+get_trampoline_kind (PeasGISignature *signature)
+{
+  gboolean returns_pointer;
+  gboolean arg_is_pointer;
+
+  /* The GError is an extra argument */
+  if ((g_function_info_get_flags (signature->callable_info) &
+       GI_FUNCTION_THROWS) != 0)
+    return TRAMPOLINE_NONE;
+
+  returns_pointer = g_type_info_is_pointer (&signature->return_type);
+
+  if (!returns_pointer && signature->return_tag != GI_TYPE_TAG_VOID)
+    return TRAMPOLINE_NONE;
+
+  if (signature->n_args == 0)
+    return returns_pointer ? TRAMPOLINE_POINTER : TRAMPOLINE_VOID;
+
+  if (signature->n_args != 1 || returns_pointer)
+    return TRAMPOLINE_NONE;
+
+  if (signature->args[0].direction != GI_DIRECTION_IN)
+    {
+      arg_is_pointer = TRUE;
+    }
+  else
+    {
+      GIArgInfo arg_info;
+      GITypeInfo arg_type_info;
+
+      g_callable_info_load_arg (signature->callable_info, 0, &arg_info);
+      g_arg_info_load_type (&arg_info, &arg_type_info);
+      arg_is_pointer = g_type_info_is_pointer (&arg_type_info);
+    }
+
+  return arg_is_pointer ? TRAMPOLINE_VOID_POINTER : TRAMPOLINE_NONE;
+}
+
 static void
 handle_method_impl (ffi_cif  *cif,
                     gpointer  result,
@@ -57,43 +218,34 @@ handle_method_impl (ffi_cif  *cif,
                     gpointer  data)
 {
   MethodImpl *impl = (MethodImpl *) data;
-  GIArgInfo arg_info;
-  GITypeInfo type_info;
-  GITypeInfo return_type_info;
-  gint n_args, i;
+  PeasGISignature *signature = impl->signature;
   PeasExtensionWrapper *instance;
   GIArgument *arguments;
   GIArgument return_value;
   gboolean success;
+  guint i;
 
   instance = *((PeasExtensionWrapper **) args[0]);
   g_assert (PEAS_IS_EXTENSION_WRAPPER (instance));
 
-  n_args = g_callable_info_get_n_args (impl->invoker_info);
-  g_return_if_fail (n_args >= 0);
-  arguments = g_newa (GIArgument, n_args);
-
-  for (i = 0; i < n_args; i++)
-    {
-      g_callable_info_load_arg (impl->invoker_info, i, &arg_info);
-      g_arg_info_load_type (&arg_info, &type_info);
+  arguments = g_newa (GIArgument, signature->n_args);
 
-      if (g_arg_info_get_direction (&arg_info) == GI_DIRECTION_IN)
-        peas_gi_pointer_to_argument (&type_info, args[i + 1], &arguments[i]);
-      else
-        arguments[i].v_pointer = *((gpointer **) args[i + 1]);
-    }
+  /* Every member of a GIArgument starts at its beginning
+   * so copying the size of the C type is all it takes
+   */
+  for (i = 0; i < signature->n_args; i++)
+    memcpy (&arguments[i], args[i + 1], signature->args[i].size);
 
   success = peas_extension_wrapper_callv (instance, impl->interface_type,
-                                          impl->invoker_info, impl->method_name,
+                                          signature->callable_info,
+                                          impl->method_name,
                                           arguments, &return_value);
 
   if (!success)
     memset (&return_value, 0, sizeof (GIArgument));
 
-  g_callable_info_load_return_type (impl->invoker_info, &return_type_info);
-  if (g_type_info_get_tag (&return_type_info) != GI_TYPE_TAG_VOID)
-    peas_gi_argument_to_pointer (&return_type_info, &return_value, result);
+  if (signature->return_size > 0)
+    memcpy (result, &return_value, signature->return_size);
 }
 
 static void
@@ -113,9 +265,9 @@ create_native_closure (GType            interface_type,
   invoker_info = g_vfunc_info_get_invoker (vfunc_info);
   if (invoker_info == NULL)
     {
-      g_debug ("No invoker for VFunc '%s.%s'",
-               g_base_info_get_name (iface_info),
-               g_base_info_get_name (vfunc_info));
+      peas_debug ("No invoker for VFunc '%s.%s'",
+                  g_base_info_get_name (iface_info),
+                  g_base_info_get_name (vfunc_info));
       return;
     }
 
@@ -139,9 +291,9 @@ create_native_closure (GType            interface_type,
 
   if (!found_field_info)
     {
-      g_debug ("No struct field for VFunc '%s.%s'",
-               g_base_info_get_name (iface_info),
-               g_base_info_get_name (vfunc_info));
+      peas_debug ("No struct field for VFunc '%s.%s'",
+                  g_base_info_get_name (iface_info),
+                  g_base_info_get_name (vfunc_info));
       g_base_info_unref (struct_info);
       g_base_info_unref (invoker_info);
       return;
@@ -154,16 +306,18 @@ create_native_closure (GType            interface_type,
   g_assert (g_base_info_get_type (callback_info) == GI_INFO_TYPE_CALLBACK);
 
   impl->interface_type = interface_type;
-  impl->invoker_info = invoker_info;
+  impl->signature = peas_gi_signature_new (invoker_info);
   impl->method_name = g_base_info_get_name (invoker_info);
   impl->closure = g_callable_info_prepare_closure (callback_info, &impl->cif,
                                                    handle_method_impl, impl);
   impl->struct_offset = g_field_info_get_offset (field_info);
+  impl->trampoline_kind = get_trampoline_kind (impl->signature);
 
   g_base_info_unref (callback_info);
   g_base_info_unref (type_info);
   g_base_info_unref (field_info);
   g_base_info_unref (struct_info);
+  g_base_info_unref (invoker_info);
 }
 
 static void
@@ -173,9 +327,10 @@ implement_interface_methods (gpointer iface,
   GType exten_type = G_TYPE_FROM_INTERFACE (iface);
   guint i;
   GArray *impls;
+  MethodImpl **trampoline_impls;
 
-  g_debug ("Implementing interface '%s' for proxy type '%s'",
-           g_type_name (exten_type), g_type_name (proxy_type));
+  peas_debug ("Implementing interface '%s' for proxy type '%s'",
+              g_type_name (exten_type), g_type_name (proxy_type));
 
   impls = g_type_get_qdata (exten_type, method_impl_quark ());
 
@@ -209,24 +364,48 @@ implement_interface_methods (gpointer iface,
       g_base_info_unref (iface_info);
     }
 
+  trampoline_impls = g_type_get_qdata (proxy_type, trampoline_impls_quark ());
+
+  if (trampoline_impls == NULL)
+    {
+      trampoline_impls = g_new0 (MethodImpl *,
+                                 N_TRAMPOLINE_KINDS * N_TRAMPOLINE_SLOTS);
+      g_type_set_qdata (proxy_type, trampoline_impls_quark (),
+                        trampoline_impls);
+    }
+
   for (i = 0; i < impls->len; i++)
     {
       MethodImpl *impl = &g_array_index (impls, MethodImpl, i);
       gpointer *method_ptr;
+      gpointer method;
 
       if (impl->closure == NULL)
         continue;
 
+      method = impl->closure;
+
+      if (impl->trampoline_kind != TRAMPOLINE_NONE && i < N_TRAMPOLINE_SLOTS)
+        {
+          guint index = (impl->trampoline_kind - 1) * N_TRAMPOLINE_SLOTS + i;
+
+          if (trampoline_impls[index] == NULL)
+            {
+              trampoline_impls[index] = impl;
+              method = trampolines[impl->trampoline_kind - 1][i];
+            }
+        }
+
       method_ptr = G_STRUCT_MEMBER_P (iface, impl->struct_offset);
-      *method_ptr = impl->closure;
+      *method_ptr = method;
 
-      g_debug ("Implemented '%s.%s' at %d (%p) with %p",
-               g_type_name (exten_type), impl->method_name,
-               impl->struct_offset, method_ptr, impl->closure);
+      peas_debug ("Implemented '%s.%s' at %d (%p) with %p",
+                  g_type_name (exten_type), impl->method_name,
+                  impl->struct_offset, method_ptr, method);
     }
 
-  g_debug ("Implemented interface '%s' for '%s' proxy",
-           g_type_name (exten_type), g_type_name (proxy_type));
+  peas_debug ("Implemented interface '%s' for '%s' proxy",
+              g_type_name (exten_type), g_type_name (proxy_type));
 }
 
 static gpointer
@@ -251,9 +430,9 @@ extension_subclass_set_property (GObject      *object,
   if ((pspec->flags & G_PARAM_CONSTRUCT) != 0 && !exten->constructed)
     return;
 
-  g_debug ("Setting '%s:%s'",
-           G_OBJECT_TYPE_NAME (object),
-           g_param_spec_get_name (pspec));
+  peas_debug ("Setting '%s:%s'",
+              G_OBJECT_TYPE_NAME (object),
+              g_param_spec_get_name (pspec));
 
   G_OBJECT_CLASS (get_parent_class (object))->set_property (object, prop_id,
                                                             value, pspec);
@@ -265,9 +444,9 @@ extension_subclass_get_property (GObject    *object,
                                  GValue     *value,
                                  GParamSpec *pspec)
 {
-  g_debug ("Getting '%s:%s'",
-           G_OBJECT_TYPE_NAME (object),
-           g_param_spec_get_name (pspec));
+  peas_debug ("Getting '%s:%s'",
+              G_OBJECT_TYPE_NAME (object),
+              g_param_spec_get_name (pspec));
 
   G_OBJECT_CLASS (get_parent_class (object))->get_property (object, prop_id,
                                                             value, pspec);
@@ -280,7 +459,7 @@ extension_subclass_init (GObjectClass *klass,
   guint i;
   guint property_id = 1;
 
-  g_debug ("Initializing class '%s'", G_OBJECT_CLASS_NAME (klass));
+  peas_debug ("Initializing class '%s'", G_OBJECT_CLASS_NAME (klass));
 
   klass->set_property = extension_subclass_set_property;
   klass->get_property = extension_subclass_get_property;
@@ -302,21 +481,21 @@ extension_subclass_init (GObjectClass *klass,
 
           g_object_class_override_property (klass, property_id, property_name);
 
-          g_debug ("Overrided '%s:%s' for '%s' proxy",
-                   g_type_name (exten_types[i]), property_name,
-                   G_OBJECT_CLASS_NAME (klass));
+          peas_debug ("Overrided '%s:%s' for '%s' proxy",
+                      g_type_name (exten_types[i]), property_name,
+                      G_OBJECT_CLASS_NAME (klass));
         }
 
       g_free (properties);
     }
 
-  g_debug ("Initialized class '%s'", G_OBJECT_CLASS_NAME (klass));
+  peas_debug ("Initialized class '%s'", G_OBJECT_CLASS_NAME (klass));
 }
 
 static void
 extension_subclass_instance_init (GObject *instance)
 {
-  g_debug ("Initializing new instance of '%s'", G_OBJECT_TYPE_NAME (instance));
+  peas_debug ("Initializing new instance of '%s'", G_OBJECT_TYPE_NAME (instance));
 }
 
 GType
@@ -360,7 +539,7 @@ peas_extension_register_subclass (GType  parent_type,
         NULL
       };
 
-      g_debug ("Registering new type '%s'", type_name->str);
+      peas_debug ("Registering new type '%s'", type_name->str);
 
       g_type_query (parent_type, &query);
       type_info.class_size = query.class_size;
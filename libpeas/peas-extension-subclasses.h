@@ -29,6 +29,8 @@ G_BEGIN_DECLS
 GType         peas_extension_register_subclass      (GType  parent_type,
                                                      GType *extension_types);
 
+gboolean      peas_extension_subclass_is_trampoline (gpointer method);
+
 G_END_DECLS
 
 #endif /* __PEAS_EXTENSION_SUBCLASSES_H__ */
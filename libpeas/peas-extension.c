@@ -24,8 +24,10 @@
 #endif
 
 #include "peas-extension.h"
+#include "peas-extension-priv.h"
 #include "peas-extension-wrapper.h"
 #include "peas-introspection.h"
+#include "peas-trace.h"
 
 /**
  * SECTION:peas-extension
@@ -60,6 +62,10 @@
  * with.
  *
  * See peas_extension_call() for more information.
+ *
+ * Code that calls the same method many times should resolve it once with
+ * peas_extension_method_new() and use peas_extension_method_call(), which
+ * does not look the method up by name on every call.
  **/
 GType
 peas_extension_get_type (void)
@@ -67,29 +73,42 @@ peas_extension_get_type (void)
   return G_TYPE_OBJECT;
 }
 
-static GICallableInfo *
-get_method_info (PeasExtension *exten,
-                 const gchar   *method_name,
-                 GType         *interface)
+G_DEFINE_BOXED_TYPE (PeasExtensionMethod, peas_extension_method,
+                     peas_extension_method_ref,
+                     peas_extension_method_unref)
+
+/* The returned signature is owned by the method cache */
+static PeasGISignature *
+get_method_signature (PeasExtension *exten,
+                      const gchar   *method_name,
+                      GType         *interface)
 {
   guint i;
-  GType exten_type;
+  GType exten_type, instance_type;
   GType *interfaces;
-  GICallableInfo *method_info;
+  PeasGISignature *signature;
   gboolean must_free_interfaces = FALSE;
 
   /* Must prioritize the initial GType */
   exten_type = peas_extension_get_extension_type (exten);
-  method_info = peas_gi_get_method_info (exten_type, method_name);
+  signature = peas_gi_get_method_signature (exten_type, method_name);
 
-  if (method_info != NULL)
+  if (signature != NULL)
     {
-      if (interface != NULL)
-        *interface = exten_type;
-
-      return method_info;
+      *interface = exten_type;
+      return signature;
     }
 
+  /* The interfaces only depend on the type of the
+   * instance, a wrapper's type is made from them
+   */
+  instance_type = G_TYPE_FROM_INSTANCE (exten);
+  signature = peas_gi_lookup_instance_method (instance_type, method_name,
+                                              interface);
+
+  if (signature != NULL)
+    return signature;
+
   if (PEAS_IS_EXTENSION_WRAPPER (exten))
     {
       interfaces = PEAS_EXTENSION_WRAPPER (exten)->interfaces;
@@ -97,18 +116,16 @@ get_method_info (PeasExtension *exten,
   else
     {
       must_free_interfaces = TRUE;
-      interfaces = g_type_interfaces (G_TYPE_FROM_INSTANCE (exten), NULL);
+      interfaces = g_type_interfaces (instance_type, NULL);
     }
 
   for (i = 0; interfaces[i] != G_TYPE_INVALID; ++i)
     {
-      method_info = peas_gi_get_method_info (interfaces[i], method_name);
+      signature = peas_gi_get_method_signature (interfaces[i], method_name);
 
-      if (method_info != NULL)
+      if (signature != NULL)
         {
-          if (interface != NULL)
-            *interface = interfaces[i];
-
+          *interface = interfaces[i];
           break;
         }
     }
@@ -116,10 +133,42 @@ get_method_info (PeasExtension *exten,
   if (must_free_interfaces)
     g_free (interfaces);
 
-  if (method_info == NULL)
+  if (signature == NULL)
     g_warning ("Could not find the interface for method '%s'", method_name);
+  else
+    peas_gi_cache_instance_method (instance_type, method_name,
+                                   signature, *interface);
 
-  return method_info;
+  return signature;
+}
+
+static gboolean
+call_method (PeasExtension   *exten,
+             PeasGISignature *signature,
+             GType            interface,
+             const gchar     *method_name,
+             GIArgument      *args,
+             GIArgument      *return_value)
+{
+  gboolean success;
+  gint64 begin_time = peas_trace_begin ();
+
+  if (PEAS_IS_EXTENSION_WRAPPER (exten))
+    {
+      success = peas_extension_wrapper_callv (PEAS_EXTENSION_WRAPPER (exten),
+                                              interface,
+                                              signature->callable_info,
+                                              method_name, args, return_value);
+    }
+  else
+    {
+      success = peas_gi_signature_call (signature, G_OBJECT (exten),
+                                        interface, method_name,
+                                        args, return_value);
+    }
+
+  peas_trace_end ("call", method_name, begin_time);
+  return success;
 }
 
 /**
@@ -167,6 +216,12 @@ peas_extension_get_extension_type (PeasExtension *exten)
  * This function will not do anything if the introspection data for the proxied
  * object's class has not been loaded previously through g_irepository_require().
  *
+ * For the extensions of C plugins, methods with few enough arguments call
+ * the implementation of the interface vfunc directly, without going through
+ * the introspected function of the interface that wraps it. Any check,
+ * default value or signal emission done by that function is then skipped.
+ * The extensions of the other loaders are not affected.
+ *
  * Return value: %TRUE on successful call.
  *
  * Deprecated: 1.2: Use the dynamically implemented interface instead.
@@ -208,37 +263,30 @@ peas_extension_call_valist (PeasExtension *exten,
                             const gchar   *method_name,
                             va_list        args)
 {
-  GICallableInfo *callable_info;
-  GITypeInfo retval_info;
+  PeasGISignature *signature;
+  GType interface;
   GIArgument *gargs;
   GIArgument retval;
   gpointer retval_ptr;
   gboolean ret;
-  gint n_args;
 
   g_return_val_if_fail (PEAS_IS_EXTENSION (exten), FALSE);
   g_return_val_if_fail (method_name != NULL, FALSE);
 
-  callable_info = get_method_info (exten, method_name, NULL);
+  signature = get_method_signature (exten, method_name, &interface);
 
   /* Already warned */
-  if (callable_info == NULL)
+  if (signature == NULL)
     return FALSE;
 
-  n_args = g_callable_info_get_n_args (callable_info);
-  g_return_val_if_fail (n_args >= 0, FALSE);
-  gargs = g_newa (GIArgument, n_args);
-  peas_gi_valist_to_arguments (callable_info, args, gargs, &retval_ptr);
+  gargs = g_newa (GIArgument, signature->n_args);
+  peas_gi_signature_valist_to_arguments (signature, args, gargs, &retval_ptr);
 
-  ret = peas_extension_callv (exten, method_name, gargs, &retval);
+  ret = call_method (exten, signature, interface,
+                     method_name, gargs, &retval);
 
   if (retval_ptr != NULL)
-    {
-      g_callable_info_load_return_type (callable_info, &retval_info);
-      peas_gi_argument_to_pointer (&retval_info, &retval, retval_ptr);
-    }
-
-  g_base_info_unref ((GIBaseInfo *) callable_info);
+    peas_gi_argument_to_pointer (&signature->return_type, &retval, retval_ptr);
 
   return ret;
 }
@@ -264,31 +312,226 @@ peas_extension_callv (PeasExtension *exten,
                       GIArgument    *args,
                       GIArgument    *return_value)
 {
-  GICallableInfo *method_info;
+  PeasGISignature *signature;
   GType interface;
-  gboolean success;
 
   g_return_val_if_fail (PEAS_IS_EXTENSION (exten), FALSE);
   g_return_val_if_fail (method_name != NULL, FALSE);
 
-  method_info = get_method_info (exten, method_name, &interface);
+  signature = get_method_signature (exten, method_name, &interface);
 
   /* Already warned */
-  if (method_info == NULL)
+  if (signature == NULL)
     return FALSE;
 
-  if (PEAS_IS_EXTENSION_WRAPPER (exten))
-    {
-      success = peas_extension_wrapper_callv (PEAS_EXTENSION_WRAPPER (exten),
-                                              interface, method_info,
-                                              method_name, args, return_value);
-    }
-  else
+  return call_method (exten, signature, interface,
+                      method_name, args, return_value);
+}
+
+/**
+ * peas_extension_method_new:
+ * @exten_type: the #GType of the extension interface.
+ * @method_name: the name of the method.
+ *
+ * Resolves the method @method_name of @exten_type once, along with
+ * everything needed to marshal its arguments. The returned
+ * #PeasExtensionMethod can then be called on any extension implementing
+ * @exten_type without looking the method up by name again.
+ *
+ * As with peas_extension_call(), the introspection data for @exten_type
+ * must have been loaded previously through g_irepository_require().
+ *
+ * Return value: (transfer full): a new #PeasExtensionMethod, or %NULL
+ * if @exten_type has no method called @method_name.
+ *
+ * Since: 1.6
+ */
+PeasExtensionMethod *
+peas_extension_method_new (GType        exten_type,
+                           const gchar *method_name)
+{
+  PeasExtensionMethod *method;
+  GICallableInfo *method_info;
+
+  g_return_val_if_fail (G_TYPE_IS_INTERFACE (exten_type), NULL);
+  g_return_val_if_fail (method_name != NULL, NULL);
+
+  method_info = peas_gi_get_method_info (exten_type, method_name);
+
+  if (method_info == NULL)
     {
-      success = peas_gi_method_call (G_OBJECT (exten), method_info, interface,
-                                     method_name, args, return_value);
+      g_warning ("Method '%s.%s' was not found",
+                 g_type_name (exten_type), method_name);
+      return NULL;
     }
 
+  method = g_slice_new (PeasExtensionMethod);
+  method->refcount = 1;
+  method->exten_type = exten_type;
+  method->name = g_strdup (method_name);
+  method->signature = peas_gi_signature_new (method_info);
+
   g_base_info_unref (method_info);
-  return success;
+
+  return method;
+}
+
+/**
+ * peas_extension_method_ref:
+ * @method: A #PeasExtensionMethod.
+ *
+ * Increases the reference count of @method.
+ *
+ * Return value: (transfer full): @method.
+ *
+ * Since: 1.6
+ */
+PeasExtensionMethod *
+peas_extension_method_ref (PeasExtensionMethod *method)
+{
+  g_return_val_if_fail (method != NULL, NULL);
+
+  g_atomic_int_inc (&method->refcount);
+
+  return method;
+}
+
+/**
+ * peas_extension_method_unref:
+ * @method: A #PeasExtensionMethod.
+ *
+ * Decreases the reference count of @method, freeing it when it drops to 0.
+ *
+ * Since: 1.6
+ */
+void
+peas_extension_method_unref (PeasExtensionMethod *method)
+{
+  g_return_if_fail (method != NULL);
+
+  if (!g_atomic_int_dec_and_test (&method->refcount))
+    return;
+
+  peas_gi_signature_free (method->signature);
+  g_free (method->name);
+  g_slice_free (PeasExtensionMethod, method);
+}
+
+/**
+ * peas_extension_method_get_name:
+ * @method: A #PeasExtensionMethod.
+ *
+ * Gets the name of the method resolved by @method.
+ *
+ * Return value: the name of the method.
+ *
+ * Since: 1.6
+ */
+const gchar *
+peas_extension_method_get_name (PeasExtensionMethod *method)
+{
+  g_return_val_if_fail (method != NULL, NULL);
+
+  return method->name;
+}
+
+/**
+ * peas_extension_method_call:
+ * @method: A #PeasExtensionMethod.
+ * @exten: A #PeasExtension.
+ * @...: arguments for the method.
+ *
+ * Call @method on the object behind @exten. The arguments are the same
+ * as for peas_extension_call(), and as with it the introspected function
+ * of the method can be bypassed for the extensions of C plugins.
+ *
+ * Return value: %TRUE on successful call.
+ *
+ * Since: 1.6
+ */
+gboolean
+peas_extension_method_call (PeasExtensionMethod *method,
+                            PeasExtension       *exten,
+                            ...)
+{
+  va_list args;
+  gboolean result;
+
+  g_return_val_if_fail (method != NULL, FALSE);
+  g_return_val_if_fail (PEAS_IS_EXTENSION (exten), FALSE);
+
+  va_start (args, exten);
+  result = peas_extension_method_call_valist (method, exten, args);
+  va_end (args);
+
+  return result;
+}
+
+/**
+ * peas_extension_method_call_valist:
+ * @method: A #PeasExtensionMethod.
+ * @exten: A #PeasExtension.
+ * @args: the arguments for the method.
+ *
+ * Call @method on the object behind @exten, using @args as arguments.
+ *
+ * See peas_extension_method_call() for more information.
+ *
+ * Return value: %TRUE on successful call.
+ *
+ * Since: 1.6
+ */
+gboolean
+peas_extension_method_call_valist (PeasExtensionMethod *method,
+                                   PeasExtension       *exten,
+                                   va_list              args)
+{
+  GIArgument *gargs;
+  GIArgument retval;
+  gpointer retval_ptr;
+  gboolean ret;
+
+  g_return_val_if_fail (method != NULL, FALSE);
+  g_return_val_if_fail (PEAS_IS_EXTENSION (exten), FALSE);
+
+  gargs = g_newa (GIArgument, method->signature->n_args);
+  peas_gi_signature_valist_to_arguments (method->signature, args,
+                                         gargs, &retval_ptr);
+
+  ret = peas_extension_method_callv (method, exten, gargs, &retval);
+
+  if (retval_ptr != NULL)
+    peas_gi_argument_to_pointer (&method->signature->return_type,
+                                 &retval, retval_ptr);
+
+  return ret;
+}
+
+/**
+ * peas_extension_method_callv:
+ * @method: A #PeasExtensionMethod.
+ * @exten: A #PeasExtension.
+ * @args: the arguments for the method.
+ * @return_value: the return value for the method.
+ *
+ * Call @method on the object behind @exten, using @args as arguments.
+ *
+ * See peas_extension_method_call() for more information.
+ *
+ * Return value: %TRUE on successful call.
+ *
+ * Since: 1.6
+ */
+gboolean
+peas_extension_method_callv (PeasExtensionMethod *method,
+                             PeasExtension       *exten,
+                             GIArgument          *args,
+                             GIArgument          *return_value)
+{
+  g_return_val_if_fail (method != NULL, FALSE);
+  g_return_val_if_fail (G_TYPE_CHECK_INSTANCE_TYPE (exten, method->exten_type),
+                        FALSE);
+
+  return call_method (exten, method->signature, method->exten_type,
+                      method->name, args, return_value);
 }
@@ -41,6 +41,18 @@ G_BEGIN_DECLS
  */
 typedef GObject PeasExtension;
 
+#define PEAS_TYPE_EXTENSION_METHOD     (peas_extension_method_get_type ())
+
+/**
+ * PeasExtensionMethod:
+ *
+ * A method of an extension type, resolved once so that it can be
+ * called repeatedly without looking it up by name.
+ *
+ * Since: 1.6
+ */
+typedef struct _PeasExtensionMethod PeasExtensionMethod;
+
 /*
  * All the public methods of PeasExtension are deprecated and should not be
  * used. Due to gi-scanner's touchiness, we also hide these legacy API from
@@ -64,6 +76,31 @@ gboolean     peas_extension_callv           (PeasExtension *exten,
                                              GIArgument    *return_value);
 #endif
 
+GType        peas_extension_method_get_type (void)  G_GNUC_CONST;
+
+PeasExtensionMethod *
+             peas_extension_method_new      (GType                exten_type,
+                                             const gchar         *method_name);
+PeasExtensionMethod *
+             peas_extension_method_ref      (PeasExtensionMethod *method);
+void         peas_extension_method_unref    (PeasExtensionMethod *method);
+
+const gchar *peas_extension_method_get_name (PeasExtensionMethod *method);
+
+#ifndef __GI_SCANNER__
+gboolean     peas_extension_method_call     (PeasExtensionMethod *method,
+                                             PeasExtension       *exten,
+                                             ...);
+gboolean     peas_extension_method_call_valist
+                                            (PeasExtensionMethod *method,
+                                             PeasExtension       *exten,
+                                             va_list              args);
+gboolean     peas_extension_method_callv    (PeasExtensionMethod *method,
+                                             PeasExtension       *exten,
+                                             GIArgument          *args,
+                                             GIArgument          *return_value);
+#endif
+
 G_END_DECLS
 
 #endif /* __PEAS_EXTENSION_H__ */
@@ -26,7 +26,82 @@
 #include <string.h>
 
 #include "peas-introspection.h"
+#include "peas-debug.h"
 
+/* Notes: According to GCC 4.4,
+ *  - int8, uint8, int16, uint16, short and ushort are promoted to int when passed through '...'
+ *  - float is promoted to double when passed through '...'
+ */
+static void
+read_in_argument (GITypeTag   type_tag,
+                  va_list    *va_args,
+                  GIArgument *arg)
+{
+  switch (type_tag)
+    {
+    case GI_TYPE_TAG_VOID:
+      arg->v_pointer = va_arg (*va_args, gpointer);
+      break;
+    case GI_TYPE_TAG_BOOLEAN:
+      arg->v_boolean = va_arg (*va_args, gboolean);
+      break;
+    case GI_TYPE_TAG_INT8:
+      arg->v_int8 = va_arg (*va_args, gint);
+      break;
+    case GI_TYPE_TAG_UINT8:
+      arg->v_uint8 = va_arg (*va_args, gint);
+      break;
+    case GI_TYPE_TAG_INT16:
+      arg->v_int16 = va_arg (*va_args, gint);
+      break;
+    case GI_TYPE_TAG_UINT16:
+      arg->v_uint16 = va_arg (*va_args, gint);
+      break;
+    case GI_TYPE_TAG_INT32:
+      arg->v_int32 = va_arg (*va_args, gint32);
+      break;
+    case GI_TYPE_TAG_UNICHAR:
+    case GI_TYPE_TAG_UINT32:
+      arg->v_uint32 = va_arg (*va_args, guint32);
+      break;
+    case GI_TYPE_TAG_INT64:
+      arg->v_int64 = va_arg (*va_args, gint64);
+      break;
+    case GI_TYPE_TAG_UINT64:
+      arg->v_uint64 = va_arg (*va_args, guint64);
+      break;
+    case GI_TYPE_TAG_FLOAT:
+      arg->v_float = va_arg (*va_args, gdouble);
+      break;
+    case GI_TYPE_TAG_DOUBLE:
+      arg->v_double = va_arg (*va_args, gdouble);
+      break;
+    case GI_TYPE_TAG_GTYPE:
+      /* apparently, GType is meant to be a gsize, from gobject/gtype.h in glib */
+      arg->v_size = va_arg (*va_args, GType);
+      break;
+    case GI_TYPE_TAG_UTF8:
+    case GI_TYPE_TAG_FILENAME:
+      arg->v_string = va_arg (*va_args, gchar *);
+      break;
+    case GI_TYPE_TAG_ARRAY:
+    case GI_TYPE_TAG_INTERFACE:
+    case GI_TYPE_TAG_GLIST:
+    case GI_TYPE_TAG_GSLIST:
+    case GI_TYPE_TAG_GHASH:
+    case GI_TYPE_TAG_ERROR:
+      arg->v_pointer = va_arg (*va_args, gpointer);
+      break;
+    default:
+      g_warn_if_reached ();
+      arg->v_pointer = va_arg (*va_args, gpointer);
+      break;
+    }
+}
+
+/* This reads the arguments from the typelib every time,
+ * prefer peas_gi_signature_valist_to_arguments() for methods
+ */
 void
 peas_gi_valist_to_arguments (GICallableInfo *callable_info,
                              va_list         va_args,
@@ -37,92 +112,30 @@ peas_gi_valist_to_arguments (GICallableInfo *callable_info,
   GIArgInfo arg_info;
   GITypeInfo arg_type_info;
   GITypeInfo retval_info;
-  GIArgument *cur_arg;
+  va_list args;
 
   g_return_if_fail (callable_info != NULL);
 
+  /* A va_list parameter cannot be passed on by address */
+  G_VA_COPY (args, va_args);
+
   n_args = g_callable_info_get_n_args (callable_info);
 
   for (i = 0; i < n_args; i++)
     {
       g_callable_info_load_arg (callable_info, i, &arg_info);
-      g_arg_info_load_type (&arg_info, &arg_type_info);
-      cur_arg = &arguments[i];
 
       switch (g_arg_info_get_direction (&arg_info))
         {
         case GI_DIRECTION_IN:
-          {
-            /* Notes: According to GCC 4.4,
-             *  - int8, uint8, int16, uint16, short and ushort are promoted to int when passed through '...'
-             *  - float is promoted to double when passed through '...'
-             */
-            switch (g_type_info_get_tag (&arg_type_info))
-              {
-              case GI_TYPE_TAG_VOID:
-                cur_arg->v_pointer = va_arg (va_args, gpointer);
-                break;
-              case GI_TYPE_TAG_BOOLEAN:
-                cur_arg->v_boolean = va_arg (va_args, gboolean);
-                break;
-              case GI_TYPE_TAG_INT8:
-                cur_arg->v_int8 = va_arg (va_args, gint);
-                break;
-              case GI_TYPE_TAG_UINT8:
-                cur_arg->v_uint8 = va_arg (va_args, gint);
-                break;
-              case GI_TYPE_TAG_INT16:
-                cur_arg->v_int16 = va_arg (va_args, gint);
-                break;
-              case GI_TYPE_TAG_UINT16:
-                cur_arg->v_uint16 = va_arg (va_args, gint);
-                break;
-              case GI_TYPE_TAG_INT32:
-                cur_arg->v_int32 = va_arg (va_args, gint32);
-                break;
-              case GI_TYPE_TAG_UNICHAR:
-              case GI_TYPE_TAG_UINT32:
-                cur_arg->v_uint32 = va_arg (va_args, guint32);
-                break;
-              case GI_TYPE_TAG_INT64:
-                cur_arg->v_int64 = va_arg (va_args, gint64);
-                break;
-              case GI_TYPE_TAG_UINT64:
-                cur_arg->v_uint64 = va_arg (va_args, guint64);
-                break;
-              case GI_TYPE_TAG_FLOAT:
-                cur_arg->v_float = va_arg (va_args, gdouble);
-                break;
-              case GI_TYPE_TAG_DOUBLE:
-                cur_arg->v_double = va_arg (va_args, gdouble);
-                break;
-              case GI_TYPE_TAG_GTYPE:
-                /* apparently, GType is meant to be a gsize, from gobject/gtype.h in glib */
-                cur_arg->v_size = va_arg (va_args, GType);
-                break;
-              case GI_TYPE_TAG_UTF8:
-              case GI_TYPE_TAG_FILENAME:
-                cur_arg->v_string = va_arg (va_args, gchar *);
-                break;
-              case GI_TYPE_TAG_ARRAY:
-              case GI_TYPE_TAG_INTERFACE:
-              case GI_TYPE_TAG_GLIST:
-              case GI_TYPE_TAG_GSLIST:
-              case GI_TYPE_TAG_GHASH:
-              case GI_TYPE_TAG_ERROR:
-                cur_arg->v_pointer = va_arg (va_args, gpointer);
-                break;
-              default:
-                g_warn_if_reached ();
-                cur_arg->v_pointer = va_arg (va_args, gpointer);
-                break;
-              }
-            break;
-          }
+          g_arg_info_load_type (&arg_info, &arg_type_info);
+          read_in_argument (g_type_info_get_tag (&arg_type_info),
+                            &args, &arguments[i]);
+          break;
         /* In the other cases, we expect we will always have a pointer. */
         case GI_DIRECTION_INOUT:
         case GI_DIRECTION_OUT:
-          cur_arg->v_pointer = va_arg (va_args, gpointer);
+          arguments[i].v_pointer = va_arg (args, gpointer);
           break;
         }
     }
@@ -132,10 +145,12 @@ peas_gi_valist_to_arguments (GICallableInfo *callable_info,
       g_callable_info_load_return_type (callable_info, &retval_info);
 
       if (g_type_info_get_tag (&retval_info) != GI_TYPE_TAG_VOID)
-        *return_value = va_arg (va_args, gpointer);
+        *return_value = va_arg (args, gpointer);
       else
         *return_value = NULL;
     }
+
+  va_end (args);
 }
 
 static void
@@ -305,9 +320,53 @@ peas_gi_pointer_to_argument (GITypeInfo     *type_info,
     }
 }
 
-GICallableInfo *
-peas_gi_get_method_info (GType        iface_type,
-                         const gchar *method_name)
+/* The typelibs are never unloaded so the signatures of the methods
+ * found for a type are kept until peas_gi_clear_method_cache().
+ * They are stored in a table of method name -> signature set as
+ * qdata of each type. A NULL signature means the type does not
+ * have such a method.
+ */
+static GRWLock method_cache_lock;
+static GArray *method_cache_types = NULL;
+
+/* The interface an instance type provides a method through, when it is
+ * not found in the extension type, is cached the same way in a table
+ * of method name -> InstanceMethod set as qdata of the instance type.
+ * The signatures are owned by the method cache.
+ */
+typedef struct {
+  PeasGISignature *signature;
+  GType interface;
+} InstanceMethod;
+
+static GArray *instance_method_types = NULL;
+
+static GQuark
+method_cache_quark (void)
+{
+  static GQuark quark = 0;
+
+  if (quark == 0)
+    quark = g_quark_from_static_string ("PeasIntrospectionMethodCache");
+
+  return quark;
+}
+
+static GQuark
+instance_method_quark (void)
+{
+  static GQuark quark = 0;
+
+  if (quark == 0)
+    quark = g_quark_from_static_string ("PeasIntrospectionInstanceMethodCache");
+
+  return quark;
+}
+
+static GICallableInfo *
+find_method_info (GType        iface_type,
+                  const gchar *method_name,
+                  gboolean    *found_type)
 {
   GIRepository *repo;
   GIBaseInfo *iface_info;
@@ -317,8 +376,7 @@ peas_gi_get_method_info (GType        iface_type,
   iface_info = g_irepository_find_by_gtype (repo, iface_type);
   if (iface_info == NULL)
     {
-      g_warning ("Type not found in introspection: '%s'",
-                 g_type_name (iface_type));
+      *found_type = FALSE;
       return NULL;
     }
 
@@ -337,9 +395,222 @@ peas_gi_get_method_info (GType        iface_type,
     }
 
   g_base_info_unref (iface_info);
+
+  *found_type = TRUE;
   return (GICallableInfo *) func_info;
 }
 
+/* The returned signature is owned by the cache */
+PeasGISignature *
+peas_gi_get_method_signature (GType        iface_type,
+                              const gchar *method_name)
+{
+  GHashTable *methods;
+  GICallableInfo *func_info;
+  PeasGISignature *signature = NULL;
+  PeasGISignature *cached_signature;
+  gboolean cached = FALSE;
+  gboolean found_type;
+
+  g_rw_lock_reader_lock (&method_cache_lock);
+
+  methods = g_type_get_qdata (iface_type, method_cache_quark ());
+  if (methods != NULL)
+    {
+      cached = g_hash_table_lookup_extended (methods, method_name,
+                                             NULL, (gpointer *) &signature);
+    }
+
+  g_rw_lock_reader_unlock (&method_cache_lock);
+
+  if (cached)
+    return signature;
+
+  func_info = find_method_info (iface_type, method_name, &found_type);
+
+  /* Do not cache it, the typelib might be required later on */
+  if (!found_type)
+    {
+      g_warning ("Type not found in introspection: '%s'",
+                 g_type_name (iface_type));
+      return NULL;
+    }
+
+  if (func_info != NULL)
+    {
+      signature = peas_gi_signature_new (func_info);
+      g_base_info_unref (func_info);
+    }
+
+  g_rw_lock_writer_lock (&method_cache_lock);
+
+  methods = g_type_get_qdata (iface_type, method_cache_quark ());
+  if (methods == NULL)
+    {
+      methods = g_hash_table_new (g_str_hash, g_str_equal);
+      g_type_set_qdata (iface_type, method_cache_quark (), methods);
+
+      if (method_cache_types == NULL)
+        method_cache_types = g_array_new (FALSE, FALSE, sizeof (GType));
+
+      g_array_append_val (method_cache_types, iface_type);
+    }
+
+  /* Another thread might have already added it */
+  if (g_hash_table_lookup_extended (methods, method_name,
+                                    NULL, (gpointer *) &cached_signature))
+    {
+      if (signature != NULL)
+        peas_gi_signature_free (signature);
+
+      signature = cached_signature;
+    }
+  else
+    {
+      g_hash_table_insert (methods, (gpointer) g_intern_string (method_name),
+                           signature);
+    }
+
+  g_rw_lock_writer_unlock (&method_cache_lock);
+
+  return signature;
+}
+
+GICallableInfo *
+peas_gi_get_method_info (GType        iface_type,
+                         const gchar *method_name)
+{
+  PeasGISignature *signature;
+
+  signature = peas_gi_get_method_signature (iface_type, method_name);
+
+  if (signature == NULL)
+    return NULL;
+
+  return g_base_info_ref (signature->callable_info);
+}
+
+static void
+free_method_signature (gpointer key,
+                       gpointer value,
+                       gpointer user_data)
+{
+  if (value != NULL)
+    peas_gi_signature_free (value);
+}
+
+/* Returns the signature cached by peas_gi_cache_instance_method()
+ * and sets @interface, or returns %NULL when nothing is cached
+ */
+PeasGISignature *
+peas_gi_lookup_instance_method (GType        instance_type,
+                                const gchar *method_name,
+                                GType       *interface)
+{
+  GHashTable *methods;
+  InstanceMethod *method = NULL;
+
+  g_rw_lock_reader_lock (&method_cache_lock);
+
+  methods = g_type_get_qdata (instance_type, instance_method_quark ());
+  if (methods != NULL)
+    method = g_hash_table_lookup (methods, method_name);
+
+  if (method != NULL)
+    *interface = method->interface;
+
+  g_rw_lock_reader_unlock (&method_cache_lock);
+
+  return method != NULL ? method->signature : NULL;
+}
+
+void
+peas_gi_cache_instance_method (GType            instance_type,
+                               const gchar     *method_name,
+                               PeasGISignature *signature,
+                               GType            interface)
+{
+  GHashTable *methods;
+  InstanceMethod *method;
+
+  g_return_if_fail (signature != NULL);
+
+  g_rw_lock_writer_lock (&method_cache_lock);
+
+  methods = g_type_get_qdata (instance_type, instance_method_quark ());
+  if (methods == NULL)
+    {
+      methods = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                       NULL, g_free);
+      g_type_set_qdata (instance_type, instance_method_quark (), methods);
+
+      if (instance_method_types == NULL)
+        instance_method_types = g_array_new (FALSE, FALSE, sizeof (GType));
+
+      g_array_append_val (instance_method_types, instance_type);
+    }
+
+  /* Another thread might have already added it */
+  if (!g_hash_table_contains (methods, method_name))
+    {
+      method = g_new (InstanceMethod, 1);
+      method->signature = signature;
+      method->interface = interface;
+
+      g_hash_table_insert (methods, (gpointer) g_intern_string (method_name),
+                           method);
+    }
+
+  g_rw_lock_writer_unlock (&method_cache_lock);
+}
+
+void
+peas_gi_clear_method_cache (void)
+{
+  guint i;
+
+  g_rw_lock_writer_lock (&method_cache_lock);
+
+  /* These point to the signatures freed below */
+  if (instance_method_types != NULL)
+    {
+      for (i = 0; i < instance_method_types->len; ++i)
+        {
+          GType instance_type = g_array_index (instance_method_types,
+                                               GType, i);
+          GHashTable *methods;
+
+          methods = g_type_get_qdata (instance_type, instance_method_quark ());
+          g_type_set_qdata (instance_type, instance_method_quark (), NULL);
+
+          g_hash_table_destroy (methods);
+        }
+
+      g_array_free (instance_method_types, TRUE);
+      instance_method_types = NULL;
+    }
+
+  if (method_cache_types != NULL)
+    {
+      for (i = 0; i < method_cache_types->len; ++i)
+        {
+          GType iface_type = g_array_index (method_cache_types, GType, i);
+          GHashTable *methods;
+
+          methods = g_type_get_qdata (iface_type, method_cache_quark ());
+          g_type_set_qdata (iface_type, method_cache_quark (), NULL);
+
+          g_hash_table_foreach (methods, free_method_signature, NULL);
+          g_hash_table_destroy (methods);
+        }
+
+      g_array_free (method_cache_types, TRUE);
+      method_cache_types = NULL;
+    }
+
+  g_rw_lock_writer_unlock (&method_cache_lock);
+}
+
 /* Only for interfaces! */
 GType
 peas_gi_get_type_from_name (const gchar *type_name)
@@ -441,6 +712,38 @@ peas_gi_get_type_from_name (const gchar *type_name)
   return the_type;
 }
 
+static gboolean
+invoke_method (GObject        *instance,
+               GICallableInfo *func_info,
+               GType           iface_type,
+               const gchar    *method_name,
+               GIArgument     *in_args,
+               guint           n_in_args,
+               GIArgument     *out_args,
+               guint           n_out_args,
+               GIArgument     *return_value)
+{
+  gboolean ret;
+  GError *error = NULL;
+
+  /* Set the object as the first argument for the method. */
+  in_args[0].v_pointer = instance;
+
+  peas_debug ("Calling '%s.%s' on '%p'",
+              g_type_name (iface_type), method_name, instance);
+
+  ret = g_function_info_invoke (func_info, in_args, n_in_args, out_args,
+                                n_out_args, return_value, &error);
+  if (!ret)
+    {
+      g_warning ("Error while calling '%s.%s': %s",
+                 g_type_name (iface_type), method_name, error->message);
+      g_error_free (error);
+    }
+
+  return ret;
+}
+
 gboolean
 peas_gi_method_call (GObject        *instance,
                      GICallableInfo *func_info,
@@ -452,8 +755,6 @@ peas_gi_method_call (GObject        *instance,
   gint n_args;
   guint n_in_args, n_out_args;
   GIArgument *in_args, *out_args;
-  gboolean ret = TRUE;
-  GError *error = NULL;
 
   g_return_val_if_fail (G_IS_OBJECT (instance), FALSE);
   g_return_val_if_fail (func_info != NULL, FALSE);
@@ -474,21 +775,380 @@ peas_gi_method_call (GObject        *instance,
                                       in_args+1, &n_in_args,
                                       out_args, &n_out_args);
 
-  /* Set the object as the first argument for the method. */
-  in_args[0].v_pointer = instance;
-  n_in_args++;
+  return invoke_method (instance, func_info, iface_type, method_name,
+                        in_args, n_in_args + 1, out_args, n_out_args,
+                        return_value);
+}
 
-  g_debug ("Calling '%s.%s' on '%p'",
-           g_type_name (iface_type), method_name, instance);
+static guint8
+type_tag_size (GITypeTag type_tag)
+{
+  switch (type_tag)
+    {
+    case GI_TYPE_TAG_BOOLEAN:
+      return sizeof (gboolean);
+    case GI_TYPE_TAG_INT8:
+    case GI_TYPE_TAG_UINT8:
+      return sizeof (gint8);
+    case GI_TYPE_TAG_INT16:
+    case GI_TYPE_TAG_UINT16:
+      return sizeof (gint16);
+    case GI_TYPE_TAG_INT32:
+    case GI_TYPE_TAG_UINT32:
+    case GI_TYPE_TAG_UNICHAR:
+      return sizeof (gint32);
+    case GI_TYPE_TAG_INT64:
+    case GI_TYPE_TAG_UINT64:
+      return sizeof (gint64);
+    case GI_TYPE_TAG_FLOAT:
+      return sizeof (gfloat);
+    case GI_TYPE_TAG_DOUBLE:
+      return sizeof (gdouble);
+    case GI_TYPE_TAG_GTYPE:
+      return sizeof (GType);
+    case GI_TYPE_TAG_VOID:
+    case GI_TYPE_TAG_UTF8:
+    case GI_TYPE_TAG_FILENAME:
+    case GI_TYPE_TAG_ARRAY:
+    case GI_TYPE_TAG_INTERFACE:
+    case GI_TYPE_TAG_GLIST:
+    case GI_TYPE_TAG_GSLIST:
+    case GI_TYPE_TAG_GHASH:
+    case GI_TYPE_TAG_ERROR:
+      return sizeof (gpointer);
+    default:
+      g_return_val_if_reached (0);
+    }
+}
 
-  ret = g_function_info_invoke (func_info, in_args, n_in_args, out_args,
-                                n_out_args, return_value, &error);
-  if (!ret)
+/* Calling the vfunc of an interface directly instead of going
+ * through g_function_info_invoke() avoids libffi altogether.
+ * This is only done for the common signatures whose arguments
+ * and return value are either pointers or 32-bit integers.
+ */
+#define P(i) args[i].v_pointer
+#define I(i) args[i].v_int32
+
+#define DEFINE_DIRECT_CALLS(suffix, params, call_args) \
+  static void \
+  direct_call_v##suffix (gpointer    func, \
+                         gpointer    instance, \
+                         GIArgument *args, \
+                         GIArgument *return_value) \
+  { \
+    ((void (*) params) func) call_args; \
+  } \
+  static void \
+  direct_call_p##suffix (gpointer    func, \
+                         gpointer    instance, \
+                         GIArgument *args, \
+                         GIArgument *return_value) \
+  { \
+    return_value->v_pointer = ((gpointer (*) params) func) call_args; \
+  } \
+  static void \
+  direct_call_i##suffix (gpointer    func, \
+                         gpointer    instance, \
+                         GIArgument *args, \
+                         GIArgument *return_value) \
+  { \
+    return_value->v_int32 = ((gint32 (*) params) func) call_args; \
+  }
+
+DEFINE_DIRECT_CALLS (, (gpointer), (instance))
+DEFINE_DIRECT_CALLS (_p, (gpointer, gpointer), (instance, P (0)))
+DEFINE_DIRECT_CALLS (_i, (gpointer, gint32), (instance, I (0)))
+DEFINE_DIRECT_CALLS (_pp, (gpointer, gpointer, gpointer), (instance, P (0), P (1)))
+DEFINE_DIRECT_CALLS (_pi, (gpointer, gpointer, gint32), (instance, P (0), I (1)))
+DEFINE_DIRECT_CALLS (_ip, (gpointer, gint32, gpointer), (instance, I (0), P (1)))
+DEFINE_DIRECT_CALLS (_ii, (gpointer, gint32, gint32), (instance, I (0), I (1)))
+
+#undef P
+#undef I
+#undef DEFINE_DIRECT_CALLS
+
+#define N_DIRECT_CALL_ARGS 2
+
+/* Indexed by the kind of return value and then by the
+ * arguments, see get_direct_call()
+ */
+static const PeasGIDirectCall direct_calls[3][7] = {
+  { direct_call_v, direct_call_v_p, direct_call_v_i,
+    direct_call_v_pp, direct_call_v_pi, direct_call_v_ip, direct_call_v_ii },
+  { direct_call_p, direct_call_p_p, direct_call_p_i,
+    direct_call_p_pp, direct_call_p_pi, direct_call_p_ip, direct_call_p_ii },
+  { direct_call_i, direct_call_i_p, direct_call_i_i,
+    direct_call_i_pp, direct_call_i_pi, direct_call_i_ip, direct_call_i_ii }
+};
+
+typedef enum {
+  KIND_VOID = 0,
+  KIND_POINTER = 1,
+  KIND_INT32 = 2,
+  KIND_UNSUPPORTED
+} DirectCallKind;
+
+static DirectCallKind
+get_direct_call_kind (GITypeInfo *type_info)
+{
+  if (g_type_info_is_pointer (type_info))
+    return KIND_POINTER;
+
+  switch (g_type_info_get_tag (type_info))
     {
-      g_warning ("Error while calling '%s.%s': %s",
-                 g_type_name (iface_type), method_name, error->message);
-      g_error_free (error);
+    case GI_TYPE_TAG_VOID:
+      return KIND_VOID;
+    case GI_TYPE_TAG_BOOLEAN:
+    case GI_TYPE_TAG_INT32:
+    case GI_TYPE_TAG_UINT32:
+    case GI_TYPE_TAG_UNICHAR:
+      return KIND_INT32;
+    default:
+      return KIND_UNSUPPORTED;
     }
+}
 
-  return ret;
+static gboolean
+find_vfunc_offset (GICallableInfo *callable_info,
+                   guint          *offset)
+{
+  GIBaseInfo *container;
+  GIVFuncInfo *vfunc_info;
+  GIStructInfo *struct_info;
+  gint i, n_fields;
+  gboolean found = FALSE;
+
+  if (!GI_IS_FUNCTION_INFO (callable_info))
+    return FALSE;
+
+  container = g_base_info_get_container (callable_info);
+  if (container == NULL || !GI_IS_INTERFACE_INFO (container))
+    return FALSE;
+
+  vfunc_info = g_function_info_get_vfunc ((GIFunctionInfo *) callable_info);
+  if (vfunc_info == NULL)
+    return FALSE;
+
+  struct_info = g_interface_info_get_iface_struct ((GIInterfaceInfo *) container);
+  if (struct_info == NULL)
+    {
+      g_base_info_unref (vfunc_info);
+      return FALSE;
+    }
+
+  n_fields = g_struct_info_get_n_fields (struct_info);
+
+  for (i = 0; i < n_fields && !found; i++)
+    {
+      GIFieldInfo *field_info = g_struct_info_get_field (struct_info, i);
+
+      if (strcmp (g_base_info_get_name (field_info),
+                  g_base_info_get_name (vfunc_info)) == 0)
+        {
+          *offset = g_field_info_get_offset (field_info);
+          found = TRUE;
+        }
+
+      g_base_info_unref (field_info);
+    }
+
+  g_base_info_unref (struct_info);
+  g_base_info_unref (vfunc_info);
+
+  return found;
+}
+
+static PeasGIDirectCall
+get_direct_call (PeasGISignature *signature)
+{
+  DirectCallKind return_kind;
+  guint i, index = 0;
+
+  if (signature->n_args > N_DIRECT_CALL_ARGS)
+    return NULL;
+
+  /* The GError is an extra argument */
+  if ((g_function_info_get_flags (signature->callable_info) &
+       GI_FUNCTION_THROWS) != 0)
+    return NULL;
+
+  return_kind = get_direct_call_kind (&signature->return_type);
+  if (return_kind == KIND_UNSUPPORTED)
+    return NULL;
+
+  for (i = 0; i < signature->n_args; i++)
+    {
+      GIArgInfo arg_info;
+      GITypeInfo arg_type_info;
+      DirectCallKind kind;
+
+      if (signature->args[i].direction != GI_DIRECTION_IN)
+        {
+          kind = KIND_POINTER;
+        }
+      else
+        {
+          g_callable_info_load_arg (signature->callable_info, i, &arg_info);
+          g_arg_info_load_type (&arg_info, &arg_type_info);
+          kind = get_direct_call_kind (&arg_type_info);
+        }
+
+      if (kind != KIND_POINTER && kind != KIND_INT32)
+        return NULL;
+
+      /* 0 args -> 0, 1 arg -> 1-2, 2 args -> 3-6 */
+      index = index * 2 + (kind == KIND_INT32 ? 1 : 0);
+    }
+
+  index += (1 << signature->n_args) - 1;
+
+  return direct_calls[return_kind][index];
+}
+
+PeasGISignature *
+peas_gi_signature_new (GICallableInfo *callable_info)
+{
+  PeasGISignature *signature;
+  GIArgInfo arg_info;
+  GITypeInfo arg_type_info;
+  gint i, n_args;
+
+  g_return_val_if_fail (callable_info != NULL, NULL);
+
+  n_args = g_callable_info_get_n_args (callable_info);
+  g_return_val_if_fail (n_args >= 0, NULL);
+
+  signature = g_malloc0 (sizeof (PeasGISignature) +
+                         sizeof (PeasGIArgumentSpec) * MAX (n_args - 1, 0));
+
+  signature->callable_info = g_base_info_ref (callable_info);
+  signature->n_args = n_args;
+
+  g_callable_info_load_return_type (callable_info, &signature->return_type);
+  signature->return_tag = g_type_info_get_tag (&signature->return_type);
+
+  if (signature->return_tag != GI_TYPE_TAG_VOID)
+    signature->return_size = type_tag_size (signature->return_tag);
+
+  for (i = 0; i < n_args; i++)
+    {
+      PeasGIArgumentSpec *spec = &signature->args[i];
+
+      g_callable_info_load_arg (callable_info, i, &arg_info);
+      g_arg_info_load_type (&arg_info, &arg_type_info);
+
+      spec->direction = g_arg_info_get_direction (&arg_info);
+      spec->type_tag = g_type_info_get_tag (&arg_type_info);
+
+      /* The other directions always use a pointer */
+      if (spec->direction == GI_DIRECTION_IN)
+        spec->size = type_tag_size (spec->type_tag);
+      else
+        spec->size = sizeof (gpointer);
+
+      if (spec->direction != GI_DIRECTION_OUT)
+        signature->n_in_args++;
+      if (spec->direction != GI_DIRECTION_IN)
+        signature->n_out_args++;
+    }
+
+  if (find_vfunc_offset (callable_info, &signature->vfunc_offset))
+    signature->direct_call = get_direct_call (signature);
+
+  return signature;
+}
+
+void
+peas_gi_signature_free (PeasGISignature *signature)
+{
+  g_base_info_unref (signature->callable_info);
+  g_free (signature);
+}
+
+void
+peas_gi_signature_valist_to_arguments (PeasGISignature *signature,
+                                       va_list          va_args,
+                                       GIArgument      *arguments,
+                                       gpointer        *return_value)
+{
+  guint i;
+  va_list args;
+
+  G_VA_COPY (args, va_args);
+
+  for (i = 0; i < signature->n_args; i++)
+    {
+      if (signature->args[i].direction == GI_DIRECTION_IN)
+        read_in_argument (signature->args[i].type_tag, &args, &arguments[i]);
+      else
+        arguments[i].v_pointer = va_arg (args, gpointer);
+    }
+
+  if (return_value != NULL)
+    {
+      if (signature->return_tag != GI_TYPE_TAG_VOID)
+        *return_value = va_arg (args, gpointer);
+      else
+        *return_value = NULL;
+    }
+
+  va_end (args);
+}
+
+/* When the signature has a direct call and @instance implements the
+ * vfunc, the vfunc is called directly and the introspected function,
+ * the invoker, is not called at all. Whatever it does besides calling
+ * the vfunc, like checking the arguments, filling in defaults or
+ * emitting a signal, does not happen for these calls.
+ */
+gboolean
+peas_gi_signature_call (PeasGISignature *signature,
+                        GObject         *instance,
+                        GType            iface_type,
+                        const gchar     *method_name,
+                        GIArgument      *args,
+                        GIArgument      *return_value)
+{
+  GIArgument *in_args, *out_args;
+  guint i, n_in_args = 1, n_out_args = 0;
+
+  g_return_val_if_fail (G_TYPE_CHECK_INSTANCE_TYPE (instance, iface_type),
+                        FALSE);
+
+  if (signature->direct_call != NULL)
+    {
+      gpointer iface;
+      gpointer func;
+
+      iface = g_type_interface_peek (G_OBJECT_GET_CLASS (instance),
+                                     iface_type);
+      func = G_STRUCT_MEMBER (gpointer, iface, signature->vfunc_offset);
+
+      /* Otherwise let the invoker deal with it */
+      if (func != NULL)
+        {
+          peas_debug ("Calling '%s.%s' on '%p' directly",
+                      g_type_name (iface_type), method_name, instance);
+
+          signature->direct_call (func, instance, args, return_value);
+          return TRUE;
+        }
+    }
+
+  /* The instance is the first argument */
+  in_args = g_newa (GIArgument, signature->n_in_args + 1);
+  out_args = g_newa (GIArgument, signature->n_out_args);
+
+  for (i = 0; i < signature->n_args; i++)
+    {
+      if (signature->args[i].direction != GI_DIRECTION_OUT)
+        in_args[n_in_args++] = args[i];
+      if (signature->args[i].direction != GI_DIRECTION_IN)
+        out_args[n_out_args++] = args[i];
+    }
+
+  return invoke_method (instance, signature->callable_info,
+                        iface_type, method_name,
+                        in_args, n_in_args, out_args, n_out_args,
+                        return_value);
 }
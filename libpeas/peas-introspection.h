@@ -27,8 +27,62 @@
 
 G_BEGIN_DECLS
 
+typedef struct _PeasGIArgumentSpec PeasGIArgumentSpec;
+typedef struct _PeasGISignature    PeasGISignature;
+
+typedef void (*PeasGIDirectCall) (gpointer    func,
+                                  gpointer    instance,
+                                  GIArgument *args,
+                                  GIArgument *return_value);
+
+struct _PeasGIArgumentSpec {
+  GIDirection direction;
+  GITypeTag type_tag;
+
+  /* The size of the C type, it is also the
+   * number of bytes used in the GIArgument
+   */
+  guint8 size;
+};
+
+/* What is needed to marshal the arguments of a callable,
+ * so it does not have to be read from the typelib every time
+ */
+struct _PeasGISignature {
+  GICallableInfo *callable_info;
+
+  GITypeInfo return_type;
+  GITypeTag return_tag;
+  guint8 return_size;
+
+  /* Set when the callable invokes an interface vfunc
+   * with a signature that can be called without libffi.
+   * The callable itself is then skipped, see
+   * peas_gi_signature_call().
+   */
+  PeasGIDirectCall direct_call;
+  guint vfunc_offset;
+
+  guint n_args;
+  guint n_in_args;
+  guint n_out_args;
+  PeasGIArgumentSpec args[1];
+};
+
 GICallableInfo  *peas_gi_get_method_info          (GType           iface_type,
                                                    const gchar    *method_name);
+PeasGISignature *peas_gi_get_method_signature     (GType           iface_type,
+                                                   const gchar    *method_name);
+
+PeasGISignature *peas_gi_lookup_instance_method   (GType           instance_type,
+                                                   const gchar    *method_name,
+                                                   GType          *interface);
+void             peas_gi_cache_instance_method    (GType            instance_type,
+                                                   const gchar     *method_name,
+                                                   PeasGISignature *signature,
+                                                   GType            interface);
+
+void             peas_gi_clear_method_cache       (void);
 
 GType            peas_gi_get_type_from_name       (const gchar    *type_name);
 
@@ -49,6 +103,20 @@ gboolean         peas_gi_method_call              (GObject        *instance,
                                                    GIArgument     *args,
                                                    GIArgument     *return_value);
 
+PeasGISignature *peas_gi_signature_new            (GICallableInfo *callable_info);
+void             peas_gi_signature_free           (PeasGISignature *signature);
+void             peas_gi_signature_valist_to_arguments
+                                                  (PeasGISignature *signature,
+                                                   va_list          va_args,
+                                                   GIArgument      *arguments,
+                                                   gpointer        *return_value);
+gboolean         peas_gi_signature_call           (PeasGISignature *signature,
+                                                   GObject         *instance,
+                                                   GType            iface_type,
+                                                   const gchar     *method_name,
+                                                   GIArgument      *args,
+                                                   GIArgument      *return_value);
+
 G_END_DECLS
 
 #endif
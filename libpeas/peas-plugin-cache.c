@@ -0,0 +1,392 @@
+/*
+ * peas-plugin-cache.c
+ * This file is part of libpeas
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Library General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <glib/gstdio.h>
+
+#include "peas-plugin-cache.h"
+#include "peas-plugin-info-priv.h"
+#include "peas-dirs.h"
+
+/*
+ * The plugin cache stores the parsed contents of every .plugin file
+ * found in a search path so that they do not have to be parsed again
+ * by GKeyFile the next time the search path is scanned.
+ *
+ * There is one cache file per module directory, it is a serialized
+ * GVariant which is mapped into memory and only ever replaced as a
+ * whole. The entries are keyed by the filename of the .plugin file
+ * and are only used when its mtime, to the nanosecond when the platform
+ * has it, and size have not changed. As the
+ * Name, Description and Icon keys are localized, the whole cache is
+ * discarded when the language changes.
+ */
+
+/* Bump whenever the format of the cache changes */
+#define CACHE_VERSION 3
+
+/* The mtime in seconds and nanoseconds, the size and the info */
+#define CACHE_ENTRY_TYPE "(xut" PEAS_PLUGIN_INFO_VARIANT_TYPE ")"
+#define CACHE_TYPE       "(usa{s" CACHE_ENTRY_TYPE "})"
+
+struct _PeasPluginCache {
+  gchar *filename;
+  gchar *locale;
+
+  /* Maps the .plugin filename to its entry */
+  GHashTable *old_entries;
+  GHashTable *new_entries;
+
+  /* Protects new_entries and dirty */
+  GMutex lock;
+
+  guint dirty : 1;
+};
+
+static void
+read_entries (PeasPluginCache *cache,
+              GVariant        *contents)
+{
+  guint32 version;
+  const gchar *locale;
+  GVariant *entries;
+  GVariantIter iter;
+  const gchar *filename;
+  GVariant *entry;
+
+  g_variant_get_child (contents, 0, "u", &version);
+  g_variant_get_child (contents, 1, "&s", &locale);
+
+  if (version != CACHE_VERSION || g_strcmp0 (locale, cache->locale) != 0)
+    {
+      g_debug ("Discarding outdated plugin cache '%s'", cache->filename);
+      return;
+    }
+
+  entries = g_variant_get_child_value (contents, 2);
+  g_variant_iter_init (&iter, entries);
+
+  while (g_variant_iter_next (&iter, "{&s@" CACHE_ENTRY_TYPE "}",
+                              &filename, &entry))
+    {
+      /* Takes ownership of the entry */
+      g_hash_table_insert (cache->old_entries, g_strdup (filename), entry);
+    }
+
+  g_variant_unref (entries);
+}
+
+static void
+write_entries (PeasPluginCache *cache)
+{
+  GVariantBuilder builder;
+  GHashTableIter iter;
+  gpointer filename, entry;
+  GVariant *contents;
+  gchar *cache_dir;
+  GError *error = NULL;
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{s" CACHE_ENTRY_TYPE "}"));
+
+  g_hash_table_iter_init (&iter, cache->new_entries);
+  while (g_hash_table_iter_next (&iter, &filename, &entry))
+    g_variant_builder_add (&builder, "{s@" CACHE_ENTRY_TYPE "}", filename, entry);
+
+  contents = g_variant_new ("(usa{s" CACHE_ENTRY_TYPE "})",
+                            CACHE_VERSION, cache->locale, &builder);
+  g_variant_ref_sink (contents);
+
+  /* Failing to write the cache is not fatal, it will
+   * just make the next scan of the search path slower
+   */
+  cache_dir = g_path_get_dirname (cache->filename);
+
+  if (g_mkdir_with_parents (cache_dir, 0755) != 0)
+    {
+      g_debug ("Could not create plugin cache directory '%s'", cache_dir);
+    }
+  else if (!g_file_set_contents (cache->filename,
+                                 g_variant_get_data (contents),
+                                 g_variant_get_size (contents),
+                                 &error))
+    {
+      g_debug ("Could not write plugin cache '%s': %s",
+               cache->filename, error->message);
+      g_error_free (error);
+    }
+
+  g_free (cache_dir);
+  g_variant_unref (contents);
+}
+
+/*
+ * peas_plugin_cache_open:
+ * @module_dir: The module directory of a search path.
+ *
+ * Maps the plugin cache of @module_dir into memory.
+ *
+ * Return value: a new #PeasPluginCache, free it with peas_plugin_cache_close().
+ */
+PeasPluginCache *
+peas_plugin_cache_open (const gchar *module_dir)
+{
+  PeasPluginCache *cache;
+  gchar *cache_dir, *checksum, *basename;
+  GMappedFile *mapped;
+  GVariant *contents;
+  GError *error = NULL;
+
+  g_return_val_if_fail (module_dir != NULL, NULL);
+
+  cache = g_slice_new0 (PeasPluginCache);
+  g_mutex_init (&cache->lock);
+  cache->locale = g_strjoinv (":", (gchar **) g_get_language_names ());
+  cache->old_entries = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                              (GDestroyNotify) g_free,
+                                              (GDestroyNotify) g_variant_unref);
+  cache->new_entries = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                              (GDestroyNotify) g_free,
+                                              (GDestroyNotify) g_variant_unref);
+
+  cache_dir = peas_dirs_get_plugin_cache_dir ();
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA1, module_dir, -1);
+  basename = g_strconcat (checksum, ".cache", NULL);
+  cache->filename = g_build_filename (cache_dir, basename, NULL);
+
+  g_free (basename);
+  g_free (checksum);
+  g_free (cache_dir);
+
+  mapped = g_mapped_file_new (cache->filename, FALSE, &error);
+
+  if (mapped == NULL)
+    {
+      /* The cache will be created when it is closed */
+      g_debug ("%s", error->message);
+      g_error_free (error);
+      return cache;
+    }
+
+  if (g_mapped_file_get_length (mapped) == 0)
+    {
+      g_mapped_file_unref (mapped);
+      return cache;
+    }
+
+  /* The data is not trusted, GVariant will use default
+   * values instead of reading invalid serialized data
+   */
+  contents = g_variant_new_from_data (G_VARIANT_TYPE (CACHE_TYPE),
+                                      g_mapped_file_get_contents (mapped),
+                                      g_mapped_file_get_length (mapped),
+                                      FALSE,
+                                      (GDestroyNotify) g_mapped_file_unref,
+                                      mapped);
+  g_variant_ref_sink (contents);
+
+  read_entries (cache, contents);
+
+  /* The entries keep the mapped file alive */
+  g_variant_unref (contents);
+
+  return cache;
+}
+
+/*
+ * peas_plugin_cache_load_file:
+ * @search_path_dir: The module directory of the search path.
+ * @filename: The filename of the plugin info file.
+ * @module_dir: The module directory.
+ * @data_dir: The data directory.
+ * @error: Return location for a #GError, or %NULL.
+ *
+ * Like peas_plugin_cache_load(), but for a single .plugin file
+ * found outside of a scan of the search path. The entries of the
+ * other files are kept in the cache.
+ *
+ * Return value: a newly created #PeasPluginInfo, or %NULL if the
+ * file is not a valid plugin info file.
+ */
+PeasPluginInfo *
+peas_plugin_cache_load_file (const gchar  *search_path_dir,
+                             const gchar  *filename,
+                             const gchar  *module_dir,
+                             const gchar  *data_dir,
+                             GError      **error)
+{
+  PeasPluginCache *cache;
+  PeasPluginInfo *info;
+  GHashTableIter iter;
+  gpointer key, entry;
+
+  g_return_val_if_fail (search_path_dir != NULL, NULL);
+  g_return_val_if_fail (filename != NULL, NULL);
+
+  cache = peas_plugin_cache_open (search_path_dir);
+
+  g_hash_table_iter_init (&iter, cache->old_entries);
+  while (g_hash_table_iter_next (&iter, &key, &entry))
+    g_hash_table_insert (cache->new_entries, g_strdup (key),
+                         g_variant_ref (entry));
+
+  info = peas_plugin_cache_load (cache, filename, module_dir,
+                                 data_dir, error);
+
+  peas_plugin_cache_close (cache);
+
+  return info;
+}
+
+/*
+ * peas_plugin_cache_close:
+ * @cache: A #PeasPluginCache.
+ *
+ * Writes the cache back to the disk if any of its entries were
+ * added, updated or did not match a .plugin file anymore, and
+ * frees @cache.
+ */
+void
+peas_plugin_cache_close (PeasPluginCache *cache)
+{
+  g_return_if_fail (cache != NULL);
+
+  if (cache->dirty ||
+      g_hash_table_size (cache->new_entries) !=
+      g_hash_table_size (cache->old_entries))
+    write_entries (cache);
+
+  g_hash_table_unref (cache->new_entries);
+  g_hash_table_unref (cache->old_entries);
+  g_mutex_clear (&cache->lock);
+  g_free (cache->locale);
+  g_free (cache->filename);
+
+  g_slice_free (PeasPluginCache, cache);
+}
+
+/* Comparing seconds only would miss an edit made
+ * within the same second as the one that was cached
+ */
+static guint32
+stat_mtime_nsec (const GStatBuf *buf)
+{
+#if defined (HAVE_STRUCT_STAT_ST_MTIM_TV_NSEC)
+  return buf->st_mtim.tv_nsec;
+#elif defined (HAVE_STRUCT_STAT_ST_MTIMESPEC_TV_NSEC)
+  return buf->st_mtimespec.tv_nsec;
+#else
+  return 0;
+#endif
+}
+
+/*
+ * peas_plugin_cache_load:
+ * @cache: A #PeasPluginCache.
+ * @filename: The filename of the plugin info file.
+ * @module_dir: The module directory.
+ * @data_dir: The data directory.
+ * @error: Return location for a #GError, or %NULL.
+ *
+ * Creates a new #PeasPluginInfo for @filename, from its cached contents
+ * if the file has not been modified since it was cached, otherwise by
+ * parsing the file and updating the cache.
+ *
+ * This can be called from multiple threads at once.
+ *
+ * Return value: a newly created #PeasPluginInfo, or %NULL if the
+ * file is not a valid plugin info file.
+ */
+PeasPluginInfo *
+peas_plugin_cache_load (PeasPluginCache *cache,
+                        const gchar     *filename,
+                        const gchar     *module_dir,
+                        const gchar     *data_dir,
+                        GError         **error)
+{
+  GStatBuf buf;
+  GVariant *entry = NULL;
+  PeasPluginInfo *info = NULL;
+  gboolean info_is_new = FALSE;
+
+  g_return_val_if_fail (cache != NULL, NULL);
+  g_return_val_if_fail (filename != NULL, NULL);
+
+  /* The file is stat()ed before being parsed so that a
+   * modification while parsing will invalidate the entry
+   */
+  if (g_stat (filename, &buf) != 0)
+    return _peas_plugin_info_new (filename, module_dir, data_dir, error);
+
+  /* old_entries is never modified after the cache is opened */
+  entry = g_hash_table_lookup (cache->old_entries, filename);
+  if (entry != NULL)
+    g_variant_ref (entry);
+
+  if (entry != NULL)
+    {
+      GVariant *info_variant;
+      gint64 mtime;
+      guint32 mtime_nsec;
+      guint64 size;
+
+      g_variant_get (entry, "(xut@" PEAS_PLUGIN_INFO_VARIANT_TYPE ")",
+                     &mtime, &mtime_nsec, &size, &info_variant);
+
+      if (mtime == (gint64) buf.st_mtime &&
+          mtime_nsec == stat_mtime_nsec (&buf) &&
+          size == (guint64) buf.st_size)
+        info = _peas_plugin_info_new_from_variant (info_variant, filename,
+                                                   module_dir, data_dir);
+
+      g_variant_unref (info_variant);
+    }
+
+  if (info == NULL)
+    {
+      if (entry != NULL)
+        g_variant_unref (entry);
+
+      info = _peas_plugin_info_new (filename, module_dir, data_dir, error);
+
+      if (info == NULL)
+        return NULL;
+
+      info_is_new = TRUE;
+      entry = g_variant_new ("(xut@" PEAS_PLUGIN_INFO_VARIANT_TYPE ")",
+                             (gint64) buf.st_mtime, stat_mtime_nsec (&buf),
+                             (guint64) buf.st_size,
+                             _peas_plugin_info_to_variant (info));
+      g_variant_ref_sink (entry);
+    }
+
+  g_mutex_lock (&cache->lock);
+
+  if (info_is_new)
+    cache->dirty = TRUE;
+
+  /* Takes ownership of the entry */
+  g_hash_table_insert (cache->new_entries, g_strdup (filename), entry);
+
+  g_mutex_unlock (&cache->lock);
+
+  return info;
+}
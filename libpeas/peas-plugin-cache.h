@@ -0,0 +1,48 @@
+/*
+ * peas-plugin-cache.h
+ * This file is part of libpeas
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Library General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __PEAS_PLUGIN_CACHE_H__
+#define __PEAS_PLUGIN_CACHE_H__
+
+#include <glib.h>
+
+#include "peas-plugin-info.h"
+
+G_BEGIN_DECLS
+
+typedef struct _PeasPluginCache PeasPluginCache;
+
+PeasPluginCache *peas_plugin_cache_open   (const gchar     *module_dir);
+void             peas_plugin_cache_close  (PeasPluginCache *cache);
+
+PeasPluginInfo  *peas_plugin_cache_load   (PeasPluginCache *cache,
+                                           const gchar     *filename,
+                                           const gchar     *module_dir,
+                                           const gchar     *data_dir,
+                                           GError         **error);
+PeasPluginInfo  *peas_plugin_cache_load_file
+                                          (const gchar     *search_path_dir,
+                                           const gchar     *filename,
+                                           const gchar     *module_dir,
+                                           const gchar     *data_dir,
+                                           GError         **error);
+
+G_END_DECLS
+
+#endif /* __PEAS_PLUGIN_CACHE_H__ */
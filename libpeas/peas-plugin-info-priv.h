@@ -25,18 +25,37 @@
 
 #include "peas-plugin-info.h"
 
+typedef struct {
+  gint64 wall_time;
+  gint64 cpu_time;
+  guint count;
+} PeasPluginTiming;
+
+#define PEAS_PLUGIN_N_PHASES (PEAS_PLUGIN_PHASE_UNLOAD + 1)
+
 struct _PeasPluginInfo {
   /*< private >*/
   gint refcount;
 
-  gchar *module_dir;
+  /* The strings are stored in a few blocks instead of being
+   * allocated separately, the fields point into the blocks.
+   * The string lists are each a single allocation as well.
+   */
+  gchar *paths;
+  gchar *display_strings;
+
+  gchar *filename;
+  /* Interned, it is shared by the plugins of the same directory */
+  const gchar *module_dir;
   gchar *data_dir;
 
   GSettingsSchemaSource *schema_source;
 
   gchar *module_name;
-  gchar *loader;
+  const gchar *loader;
   gchar **dependencies;
+  /* NULL unless the plugin info file has the Extensions key */
+  gchar **extensions;
 
   gchar *name;
   gchar *desc;
@@ -47,7 +66,21 @@ struct _PeasPluginInfo {
   gchar *version;
   gchar *help_uri;
 
-  GHashTable *external_data;
+  /* The X- keys without the prefix followed by their value */
+  gchar **external_data;
+
+  /* The fields above that are only used for displaying the plugin
+   * are read from the plugin cache entry the first time one of them
+   * is needed, the entry is dropped once they have been read
+   */
+  GVariant *variant;
+  volatile gsize display_fields_loaded;
+
+  /* Indexed by PeasPluginPhase, NULL until the first phase of
+   * the plugin is timed. Guarded by bit 0 of timings_lock.
+   */
+  PeasPluginTiming *timings;
+  volatile gint timings_lock;
 
   GError *error;
 
@@ -61,11 +94,26 @@ struct _PeasPluginInfo {
   guint hidden : 1;
 };
 
+/* Module, Loader, Name, Depends, Extensions, Description, Icon, Authors,
+ * Copyright, Website, Version, Help, Builtin, Hidden, whether Extensions
+ * was present and the X- keys, in that order.
+ */
+#define PEAS_PLUGIN_INFO_VARIANT_TYPE "(sssasasmsmsasmsmsmsmsbbba{ss})"
+
 PeasPluginInfo *_peas_plugin_info_new   (const gchar    *filename,
                                          const gchar    *module_dir,
-                                         const gchar    *data_dir);
+                                         const gchar    *data_dir,
+                                         GError        **error);
 PeasPluginInfo *_peas_plugin_info_ref   (PeasPluginInfo *info);
 void            _peas_plugin_info_unref (PeasPluginInfo *info);
 
+PeasPluginInfo *_peas_plugin_info_new_from_variant
+                                        (GVariant             *variant,
+                                         const gchar          *filename,
+                                         const gchar          *module_dir,
+                                         const gchar          *data_dir);
+GVariant       *_peas_plugin_info_to_variant
+                                        (const PeasPluginInfo *info);
+
 
 #endif /* __PEAS_PLUGIN_INFO_PRIV_H__ */
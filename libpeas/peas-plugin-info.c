@@ -29,6 +29,7 @@
 
 #include "peas-i18n.h"
 #include "peas-plugin-info-priv.h"
+#include "peas-profile.h"
 
 #ifdef G_OS_WIN32
 #define OS_HELP_KEY "Help-Windows"
@@ -38,6 +39,11 @@
 #define OS_HELP_KEY "Help-GNOME"
 #endif
 
+/* Matches PEAS_PLUGIN_INFO_VARIANT_TYPE, but the string
+ * arrays are converted to and from NULL-terminated arrays.
+ */
+#define PLUGIN_INFO_VARIANT_FORMAT "(sss^as^asmsms^asmsmsmsmsbbba{ss})"
+
 /**
  * SECTION:peas-plugin-info
  * @short_description: Information about a plugin.
@@ -56,6 +62,7 @@
  * Copyright=Copyright © 2009-10 Steve Frécinaux
  * Website=http://live.gnome.org/Libpeas
  * Help=http://library.gnome.org/devel/libpeas/unstable/
+ * Extensions=PeasActivatable
  * IAge=2
  * ]|
  **/
@@ -77,30 +84,229 @@ _peas_plugin_info_unref (PeasPluginInfo *info)
   if (!g_atomic_int_dec_and_test (&info->refcount))
     return;
 
-  g_free (info->module_dir);
-  g_free (info->data_dir);
+  g_free (info->paths);
+  g_free (info->display_strings);
   if (info->schema_source != NULL)
     g_settings_schema_source_unref (info->schema_source);
-  g_free (info->module_name);
-  g_strfreev (info->dependencies);
-  g_free (info->name);
-  g_free (info->desc);
-  g_free (info->icon_name);
-  g_free (info->website);
-  g_free (info->copyright);
-  g_free (info->loader);
-  g_free (info->version);
-  g_free (info->help_uri);
-  g_strfreev (info->authors);
+  g_free (info->dependencies);
+  g_free (info->extensions);
+  g_free (info->authors);
+  g_free (info->external_data);
+  g_free (info->timings);
   if (info->error != NULL)
     g_error_free (info->error);
 
-  if (info->external_data != NULL)
-    g_hash_table_unref (info->external_data);
+  if (info->variant != NULL)
+    g_variant_unref (info->variant);
 
   g_free (info);
 }
 
+/* Moves the strings into a single allocation which is returned,
+ * each of @fields is updated to point to its copy in the block
+ */
+static gchar *
+pack_strings (gchar **fields[],
+              guint   n_fields)
+{
+  gsize size = 0;
+  gchar *block, *p;
+  guint i;
+
+  for (i = 0; i < n_fields; ++i)
+    {
+      if (*fields[i] != NULL)
+        size += strlen (*fields[i]) + 1;
+    }
+
+  if (size == 0)
+    return NULL;
+
+  block = p = g_malloc (size);
+
+  for (i = 0; i < n_fields; ++i)
+    {
+      gsize len;
+
+      if (*fields[i] == NULL)
+        continue;
+
+      len = strlen (*fields[i]) + 1;
+      memcpy (p, *fields[i], len);
+
+      g_free (*fields[i]);
+      *fields[i] = p;
+      p += len;
+    }
+
+  return block;
+}
+
+static void
+pack_paths (PeasPluginInfo *info)
+{
+  gchar **fields[] = {
+    &info->filename,
+    &info->data_dir,
+    &info->module_name
+  };
+
+  info->paths = pack_strings (fields, G_N_ELEMENTS (fields));
+}
+
+static void
+pack_display_strings (PeasPluginInfo *info)
+{
+  gchar **fields[] = {
+    &info->name,
+    &info->desc,
+    &info->icon_name,
+    &info->copyright,
+    &info->website,
+    &info->version,
+    &info->help_uri
+  };
+
+  info->display_strings = pack_strings (fields, G_N_ELEMENTS (fields));
+}
+
+/* Stores the strings in @strings and the array pointing to them in
+ * a single allocation as a NULL-terminated array. With @intern_keys
+ * the strings at even indices are interned instead of being copied.
+ */
+static gchar **
+pack_string_array (GPtrArray *strings,
+                   gboolean   intern_keys)
+{
+  gsize size;
+  gchar **array;
+  gchar *p;
+  guint i;
+
+  size = (strings->len + 1) * sizeof (gchar *);
+  for (i = 0; i < strings->len; ++i)
+    {
+      if (!intern_keys || i % 2 != 0)
+        size += strlen (g_ptr_array_index (strings, i)) + 1;
+    }
+
+  array = g_malloc (size);
+  p = (gchar *) (array + strings->len + 1);
+
+  for (i = 0; i < strings->len; ++i)
+    {
+      gchar *str = g_ptr_array_index (strings, i);
+
+      if (intern_keys && i % 2 == 0)
+        {
+          array[i] = (gchar *) g_intern_string (str);
+        }
+      else
+        {
+          gsize len = strlen (str) + 1;
+
+          memcpy (p, str, len);
+          array[i] = p;
+          p += len;
+        }
+
+      g_free (str);
+    }
+
+  array[strings->len] = NULL;
+
+  g_ptr_array_unref (strings);
+
+  return array;
+}
+
+/* Repacks a string list returned by GKeyFile or GVariant */
+static gchar **
+pack_strv (gchar **strv)
+{
+  GPtrArray *strings;
+  guint i;
+
+  if (strv == NULL)
+    return NULL;
+
+  strings = g_ptr_array_new ();
+
+  for (i = 0; strv[i] != NULL; ++i)
+    g_ptr_array_add (strings, strv[i]);
+
+  g_free (strv);
+
+  return pack_string_array (strings, FALSE);
+}
+
+/* Takes the key and value pairs in @pairs and stores them in a
+ * single allocation as a NULL-terminated array of keys and values,
+ * the keys are interned as most are shared by all the plugins of
+ * an application
+ */
+static gchar **
+pack_external_data (GPtrArray *pairs)
+{
+  if (pairs->len == 0)
+    {
+      g_ptr_array_unref (pairs);
+      return NULL;
+    }
+
+  return pack_string_array (pairs, TRUE);
+}
+
+static void
+ensure_display_fields (const PeasPluginInfo *const_info)
+{
+  PeasPluginInfo *info = (PeasPluginInfo *) const_info;
+  GVariantIter *external_iter;
+  GPtrArray *pairs;
+  gchar *key, *value;
+
+  if (!g_once_init_enter (&info->display_fields_loaded))
+    return;
+
+  g_variant_get (info->variant, PLUGIN_INFO_VARIANT_FORMAT,
+                 NULL,
+                 NULL,
+                 &info->name,
+                 NULL,
+                 NULL,
+                 &info->desc,
+                 &info->icon_name,
+                 &info->authors,
+                 &info->copyright,
+                 &info->website,
+                 &info->version,
+                 &info->help_uri,
+                 NULL,
+                 NULL,
+                 NULL,
+                 &external_iter);
+
+  pairs = g_ptr_array_new ();
+
+  while (g_variant_iter_next (external_iter, "{ss}", &key, &value))
+    {
+      g_ptr_array_add (pairs, key);
+      g_ptr_array_add (pairs, value);
+    }
+
+  g_variant_iter_free (external_iter);
+
+  pack_display_strings (info);
+  info->authors = pack_strv (info->authors);
+  info->external_data = pack_external_data (pairs);
+
+  /* The entry keeps the whole plugin cache mapped */
+  g_variant_unref (info->variant);
+  info->variant = NULL;
+
+  g_once_init_leave (&info->display_fields_loaded, 1);
+}
+
 
 GQuark
 peas_plugin_info_error_quark (void)
@@ -119,23 +325,29 @@ peas_plugin_info_error_quark (void)
  * @filename: The filename where to read the plugin information.
  * @module_dir: The module directory.
  * @data_dir: The data directory.
+ * @error: Return location for a #GError, or %NULL.
  *
  * Creates a new #PeasPluginInfo from a file on the disk.
  *
- * Return value: a newly created #PeasPluginInfo.
+ * This does not log anything as it is also called on the
+ * threads of a parallel scan, the caller reports @error.
+ *
+ * Return value: a newly created #PeasPluginInfo, or %NULL.
  */
 PeasPluginInfo *
-_peas_plugin_info_new (const gchar *filename,
-                       const gchar *module_dir,
-                       const gchar *data_dir)
+_peas_plugin_info_new (const gchar  *filename,
+                       const gchar  *module_dir,
+                       const gchar  *data_dir,
+                       GError      **error)
 {
   PeasPluginInfo *info;
   GKeyFile *plugin_file = NULL;
   gchar *str;
   gchar **strv;
   gboolean b;
-  GError *error = NULL;
+  GError *bool_error = NULL;
   gchar **keys;
+  GPtrArray *pairs;
   gsize i;
 
   g_return_val_if_fail (filename != NULL, NULL);
@@ -146,7 +358,8 @@ _peas_plugin_info_new (const gchar *filename,
   plugin_file = g_key_file_new ();
   if (!g_key_file_load_from_file (plugin_file, filename, G_KEY_FILE_NONE, NULL))
     {
-      g_warning ("Bad plugin file: '%s'", filename);
+      g_set_error (error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_PARSE,
+                   "Bad plugin file: '%s'", filename);
       goto error;
     }
 
@@ -159,7 +372,8 @@ _peas_plugin_info_new (const gchar *filename,
     }
   else
     {
-      g_warning ("Could not find 'Module' in '%s'", filename);
+      g_set_error (error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_KEY_NOT_FOUND,
+                   "Could not find 'Module' in '%s'", filename);
       goto error;
     }
 
@@ -170,7 +384,8 @@ _peas_plugin_info_new (const gchar *filename,
     info->name = str;
   else
     {
-      g_warning ("Could not find 'Name' in '%s'", filename);
+      g_set_error (error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_KEY_NOT_FOUND,
+                   "Could not find 'Name' in '%s'", filename);
       goto error;
     }
 
@@ -181,19 +396,29 @@ _peas_plugin_info_new (const gchar *filename,
   if (info->dependencies == NULL)
     info->dependencies = g_new0 (gchar *, 1);
 
+  /* Get the extension types, NULL when they are not declared */
+  info->extensions = g_key_file_get_string_list (plugin_file,
+                                                 "Plugin",
+                                                 "Extensions", NULL, NULL);
+
   /* Get the loader for this plugin */
   str = g_key_file_get_string (plugin_file, "Plugin", "Loader", NULL);
 
+  /* There are only a handful of loaders, so
+   * every plugin info shares the same string
+   */
   if ((str != NULL) && (*str != '\0'))
     {
-      info->loader = str;
+      info->loader = g_intern_string (str);
     }
   else
     {
       /* default to the C loader */
-      info->loader = g_strdup ("C");
+      info->loader = g_intern_static_string ("C");
     }
 
+  g_free (str);
+
   /* Get Description */
   str = g_key_file_get_locale_string (plugin_file, "Plugin",
                                       "Description", NULL, NULL);
@@ -244,44 +469,54 @@ _peas_plugin_info_new (const gchar *filename,
     }
 
   /* Get Builtin */
-  b = g_key_file_get_boolean (plugin_file, "Plugin", "Builtin", &error);
-  if (error != NULL)
-    g_clear_error (&error);
+  b = g_key_file_get_boolean (plugin_file, "Plugin", "Builtin", &bool_error);
+  if (bool_error != NULL)
+    g_clear_error (&bool_error);
   else
     info->builtin = b;
 
   /* Get Hidden */
-  b = g_key_file_get_boolean (plugin_file, "Plugin", "Hidden", &error);
-  if (error != NULL)
-    g_clear_error (&error);
+  b = g_key_file_get_boolean (plugin_file, "Plugin", "Hidden", &bool_error);
+  if (bool_error != NULL)
+    g_clear_error (&bool_error);
   else
     info->hidden = b;
 
   keys = g_key_file_get_keys (plugin_file, "Plugin", NULL, NULL);
+  pairs = g_ptr_array_new ();
 
   for (i = 0; keys[i] != NULL; ++i)
     {
       if (!g_str_has_prefix (keys[i], "X-"))
         continue;
 
-      if (info->external_data == NULL)
-        info->external_data = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                                     (GDestroyNotify) g_free,
-                                                     (GDestroyNotify) g_free);
+      /* g_key_file_get_string() can fail on invalid UTF-8 */
+      str = g_key_file_get_string (plugin_file, "Plugin", keys[i], NULL);
+      if (str == NULL)
+        continue;
 
-      g_hash_table_insert (info->external_data,
-                           g_strdup (keys[i] + 2),
-                           g_key_file_get_string (plugin_file, "Plugin",
-                                                  keys[i], NULL));
+      g_ptr_array_add (pairs, g_strdup (keys[i] + 2));
+      g_ptr_array_add (pairs, str);
     }
 
   g_strfreev (keys);
 
   g_key_file_free (plugin_file);
 
-  info->module_dir = g_strdup (module_dir);
+  info->filename = g_strdup (filename);
+  info->module_dir = g_intern_string (module_dir);
   info->data_dir = g_build_filename (data_dir, info->module_name, NULL);
 
+  pack_paths (info);
+  pack_display_strings (info);
+  info->dependencies = pack_strv (info->dependencies);
+  info->extensions = pack_strv (info->extensions);
+  info->authors = pack_strv (info->authors);
+  info->external_data = pack_external_data (pairs);
+
+  /* The display fields are needed right away for the plugin cache */
+  info->display_fields_loaded = 1;
+
   /* If we know nothing about the availability of the plugin,
      set it as available */
   info->available = TRUE;
@@ -297,6 +532,138 @@ error:
   return NULL;
 }
 
+/*
+ * _peas_plugin_info_new_from_variant:
+ * @variant: A #GVariant of type %PEAS_PLUGIN_INFO_VARIANT_TYPE.
+ * @filename: The filename the plugin information was read from.
+ * @module_dir: The module directory.
+ * @data_dir: The data directory.
+ *
+ * Creates a new #PeasPluginInfo from the serialized form created
+ * by _peas_plugin_info_to_variant(), as stored in the plugin cache.
+ * The fields that are only used for displaying the plugin are read
+ * from @variant the first time they are needed.
+ *
+ * Return value: a newly created #PeasPluginInfo.
+ */
+PeasPluginInfo *
+_peas_plugin_info_new_from_variant (GVariant    *variant,
+                                    const gchar *filename,
+                                    const gchar *module_dir,
+                                    const gchar *data_dir)
+{
+  PeasPluginInfo *info;
+  gchar *loader;
+  gboolean builtin, hidden, has_extensions;
+
+  g_return_val_if_fail (variant != NULL, NULL);
+  g_return_val_if_fail (g_variant_is_of_type (variant,
+                                              G_VARIANT_TYPE (PEAS_PLUGIN_INFO_VARIANT_TYPE)),
+                        NULL);
+
+  info = g_new0 (PeasPluginInfo, 1);
+  info->refcount = 1;
+
+  /* Only what is needed to resolve and load the plugin is read
+   * here, the rest is read by ensure_display_fields()
+   */
+  g_variant_get (variant, PLUGIN_INFO_VARIANT_FORMAT,
+                 &info->module_name,
+                 &loader,
+                 NULL,
+                 &info->dependencies,
+                 &info->extensions,
+                 NULL,
+                 NULL,
+                 NULL,
+                 NULL,
+                 NULL,
+                 NULL,
+                 NULL,
+                 &builtin,
+                 &hidden,
+                 &has_extensions,
+                 NULL);
+
+  if (!has_extensions)
+    {
+      g_strfreev (info->extensions);
+      info->extensions = NULL;
+    }
+
+  info->dependencies = pack_strv (info->dependencies);
+  info->extensions = pack_strv (info->extensions);
+
+  info->loader = g_intern_string (loader);
+  g_free (loader);
+
+  info->builtin = builtin;
+  info->hidden = hidden;
+  info->variant = g_variant_ref (variant);
+
+  info->filename = g_strdup (filename);
+  info->module_dir = g_intern_string (module_dir);
+  info->data_dir = g_build_filename (data_dir, info->module_name, NULL);
+
+  pack_paths (info);
+
+  info->available = TRUE;
+
+  return info;
+}
+
+/*
+ * _peas_plugin_info_to_variant:
+ * @info: A #PeasPluginInfo.
+ *
+ * Serializes the data read from the plugin info file so it can be
+ * stored in the plugin cache. Neither the directories nor the
+ * runtime state of the plugin are part of the serialized form.
+ *
+ * Return value: a floating #GVariant of type %PEAS_PLUGIN_INFO_VARIANT_TYPE.
+ */
+GVariant *
+_peas_plugin_info_to_variant (const PeasPluginInfo *info)
+{
+  GVariantBuilder external;
+  const gchar *no_extensions[] = { NULL };
+
+  g_return_val_if_fail (info != NULL, NULL);
+
+  ensure_display_fields (info);
+
+  g_variant_builder_init (&external, G_VARIANT_TYPE ("a{ss}"));
+
+  if (info->external_data != NULL)
+    {
+      gsize i;
+
+      for (i = 0; info->external_data[i] != NULL; i += 2)
+        g_variant_builder_add (&external, "{ss}",
+                               info->external_data[i],
+                               info->external_data[i + 1]);
+    }
+
+  return g_variant_new (PLUGIN_INFO_VARIANT_FORMAT,
+                        info->module_name,
+                        info->loader,
+                        info->name,
+                        info->dependencies,
+                        info->extensions != NULL ? info->extensions :
+                                                   (gchar **) no_extensions,
+                        info->desc,
+                        info->icon_name,
+                        info->authors,
+                        info->copyright,
+                        info->website,
+                        info->version,
+                        info->help_uri,
+                        info->builtin != FALSE,
+                        info->hidden != FALSE,
+                        info->extensions != NULL,
+                        &external);
+}
+
 /**
  * peas_plugin_info_is_loaded:
  * @info: A #PeasPluginInfo.
@@ -574,6 +941,77 @@ peas_plugin_info_has_dependency (const PeasPluginInfo *info,
   return FALSE;
 }
 
+/**
+ * peas_plugin_info_get_extensions:
+ * @info: A #PeasPluginInfo.
+ *
+ * Gets the names of the extension types the plugin declares it provides.
+ *
+ * When a plugin declares them, #PeasEngine answers
+ * peas_engine_provides_extension() from this list instead of asking the
+ * plugin loader, so the plugin does not need to be loaded to know
+ * whether it provides an extension. A plugin that declares them must
+ * list every extension type it provides.
+ *
+ * The relevant key in the plugin info file is "Extensions".
+ *
+ * Returns: (transfer none) (allow-none): the names of the plugin's
+ * extension types, or %NULL if the plugin does not declare them.
+ *
+ * Since: 1.6
+ */
+const gchar **
+peas_plugin_info_get_extensions (const PeasPluginInfo *info)
+{
+  g_return_val_if_fail (info != NULL, NULL);
+
+  return (const gchar **) info->extensions;
+}
+
+
+/**
+ * peas_plugin_info_get_timing:
+ * @info: A #PeasPluginInfo.
+ * @phase: A #PeasPluginPhase.
+ * @wall_time: (out) (allow-none): return location for the
+ *   wall-clock time, or %NULL.
+ * @cpu_time: (out) (allow-none): return location for the
+ *   CPU time, or %NULL.
+ * @count: (out) (allow-none): return location for the number
+ *   of times @phase was timed, or %NULL.
+ *
+ * Gets the total time spent in @phase for the plugin, in microseconds,
+ * since the #PeasPluginInfo was created. The CPU time is the time
+ * spent by the thread that went through @phase. It is only measured
+ * when the PEAS_PROFILE environment variable is set and is 0 otherwise
+ * or on platforms where it cannot be measured.
+ *
+ * Setting the PEAS_PROFILE environment variable prints a report
+ * of these timings for every plugin when the program exits.
+ *
+ * Since: 1.6
+ */
+void
+peas_plugin_info_get_timing (const PeasPluginInfo *info,
+                             PeasPluginPhase       phase,
+                             gint64               *wall_time,
+                             gint64               *cpu_time,
+                             guint                *count)
+{
+  PeasPluginTiming timing = { 0, 0, 0 };
+
+  g_return_if_fail (info != NULL);
+  g_return_if_fail (phase < PEAS_PLUGIN_N_PHASES);
+
+  peas_profile_get_timing (info, phase, &timing);
+
+  if (wall_time != NULL)
+    *wall_time = timing.wall_time;
+  if (cpu_time != NULL)
+    *cpu_time = timing.cpu_time;
+  if (count != NULL)
+    *count = timing.count;
+}
 
 /**
  * peas_plugin_info_get_name:
@@ -592,6 +1030,8 @@ peas_plugin_info_get_name (const PeasPluginInfo *info)
 {
   g_return_val_if_fail (info != NULL, NULL);
 
+  ensure_display_fields (info);
+
   return info->name;
 }
 
@@ -613,6 +1053,8 @@ peas_plugin_info_get_description (const PeasPluginInfo *info)
 {
   g_return_val_if_fail (info != NULL, NULL);
 
+  ensure_display_fields (info);
+
   return info->desc;
 }
 
@@ -634,6 +1076,8 @@ peas_plugin_info_get_icon_name (const PeasPluginInfo *info)
 {
   g_return_val_if_fail (info != NULL, NULL);
 
+  ensure_display_fields (info);
+
   /* use the libpeas-plugin icon as a default if the plugin does not
      have its own */
   if (info->icon_name != NULL)
@@ -657,6 +1101,8 @@ peas_plugin_info_get_authors (const PeasPluginInfo *info)
 {
   g_return_val_if_fail (info != NULL, (const gchar **) NULL);
 
+  ensure_display_fields (info);
+
   return (const gchar **) info->authors;
 }
 
@@ -675,6 +1121,8 @@ peas_plugin_info_get_website (const PeasPluginInfo *info)
 {
   g_return_val_if_fail (info != NULL, NULL);
 
+  ensure_display_fields (info);
+
   return info->website;
 }
 
@@ -693,6 +1141,8 @@ peas_plugin_info_get_copyright (const PeasPluginInfo *info)
 {
   g_return_val_if_fail (info != NULL, NULL);
 
+  ensure_display_fields (info);
+
   return info->copyright;
 }
 
@@ -711,6 +1161,8 @@ peas_plugin_info_get_version (const PeasPluginInfo *info)
 {
   g_return_val_if_fail (info != NULL, NULL);
 
+  ensure_display_fields (info);
+
   return info->version;
 }
 
@@ -735,6 +1187,8 @@ peas_plugin_info_get_help_uri (const PeasPluginInfo *info)
 {
   g_return_val_if_fail (info != NULL, NULL);
 
+  ensure_display_fields (info);
+
   return info->help_uri;
 }
 
@@ -758,14 +1212,25 @@ const gchar *
 peas_plugin_info_get_external_data (const PeasPluginInfo *info,
                                     const gchar          *key)
 {
+  gsize i;
+
   g_return_val_if_fail (info != NULL, NULL);
   g_return_val_if_fail (key != NULL, NULL);
 
+  ensure_display_fields (info);
+
   if (info->external_data == NULL)
     return NULL;
 
   if (g_str_has_prefix (key, "X-"))
     key += 2;
 
-  return g_hash_table_lookup (info->external_data, key);
+  /* Plugins only have a few keys, so this is faster than a hash table */
+  for (i = 0; info->external_data[i] != NULL; i += 2)
+    {
+      if (strcmp (info->external_data[i], key) == 0)
+        return info->external_data[i + 1];
+    }
+
+  return NULL;
 }
@@ -60,6 +60,41 @@ typedef enum {
   PEAS_PLUGIN_INFO_ERROR_DEP_LOADING_FAILED
 } PeasPluginInfoError;
 
+/**
+ * PeasPluginPhase:
+ * @PEAS_PLUGIN_PHASE_DEPENDENCIES:
+ *      Loading the dependencies of the plugin. This includes the
+ *      time spent in all of the phases of the dependencies and of
+ *      their own dependencies, so nested loads are counted again
+ *      by every plugin up the chain. It is not timed for plugins
+ *      without dependencies.
+ * @PEAS_PLUGIN_PHASE_LOADER:
+ *      Looking up the plugin loader, which includes creating
+ *      it for the first plugin that uses it.
+ * @PEAS_PLUGIN_PHASE_PREPARE:
+ *      Preparing the plugin on a worker thread,
+ *      see #PeasEngine:parallel-load.
+ * @PEAS_PLUGIN_PHASE_LOAD:
+ *      Loading the plugin with its loader.
+ * @PEAS_PLUGIN_PHASE_CREATE_EXTENSION:
+ *      Creating extensions of the plugin.
+ * @PEAS_PLUGIN_PHASE_UNLOAD:
+ *      Unloading the plugin with its loader.
+ *
+ * The phases of the life of a plugin that are timed,
+ * see peas_plugin_info_get_timing().
+ *
+ * Since: 1.6
+ */
+typedef enum {
+  PEAS_PLUGIN_PHASE_DEPENDENCIES,
+  PEAS_PLUGIN_PHASE_LOADER,
+  PEAS_PLUGIN_PHASE_PREPARE,
+  PEAS_PLUGIN_PHASE_LOAD,
+  PEAS_PLUGIN_PHASE_CREATE_EXTENSION,
+  PEAS_PLUGIN_PHASE_UNLOAD
+} PeasPluginPhase;
+
 /**
  * PeasPluginInfo:
  *
@@ -85,6 +120,12 @@ GSettings    *peas_plugin_info_get_settings     (const PeasPluginInfo *info,
 const gchar **peas_plugin_info_get_dependencies (const PeasPluginInfo *info);
 gboolean      peas_plugin_info_has_dependency   (const PeasPluginInfo *info,
                                                  const gchar          *module_name);
+const gchar **peas_plugin_info_get_extensions   (const PeasPluginInfo *info);
+void          peas_plugin_info_get_timing       (const PeasPluginInfo *info,
+                                                 PeasPluginPhase       phase,
+                                                 gint64               *wall_time,
+                                                 gint64               *cpu_time,
+                                                 guint                *count);
 
 const gchar  *peas_plugin_info_get_name         (const PeasPluginInfo *info);
 const gchar  *peas_plugin_info_get_description  (const PeasPluginInfo *info);
@@ -36,6 +36,22 @@ struct _PeasPluginLoaderCPrivate {
 
 G_DEFINE_TYPE (PeasPluginLoaderC, peas_plugin_loader_c, PEAS_TYPE_PLUGIN_LOADER);
 
+static void
+peas_plugin_loader_c_prepare (PeasPluginLoader *loader,
+                              PeasPluginInfo   *info)
+{
+  gchar *path;
+
+  /* dlopen() runs under a global lock so the library is not opened
+   * here, reading it lets the reads of several plugins overlap and
+   * the g_module_open() done by load() find it in the page cache
+   */
+  path = g_module_build_path (peas_plugin_info_get_module_dir (info),
+                              peas_plugin_info_get_module_name (info));
+  peas_plugin_loader_read_ahead (path);
+  g_free (path);
+}
+
 static gboolean
 peas_plugin_loader_c_load (PeasPluginLoader *loader,
                            PeasPluginInfo   *info)
@@ -191,6 +207,7 @@ peas_plugin_loader_c_class_init (PeasPluginLoaderCClass *klass)
 
   object_class->finalize = peas_plugin_loader_c_finalize;
 
+  loader_class->prepare = peas_plugin_loader_c_prepare;
   loader_class->load = peas_plugin_loader_c_load;
   loader_class->unload = peas_plugin_loader_c_unload;
   loader_class->provides_extension = peas_plugin_loader_c_provides_extension;
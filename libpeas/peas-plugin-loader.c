@@ -23,7 +23,20 @@
 #include <config.h>
 #endif
 
+#include <fcntl.h>
+#include <errno.h>
+#ifdef G_OS_WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <glib/gstdio.h>
+
 #include "peas-plugin-loader.h"
+#include "peas-trace.h"
+
+#define READ_AHEAD_BUFFER_SIZE (64 * 1024)
 
 G_DEFINE_ABSTRACT_TYPE (PeasPluginLoader, peas_plugin_loader, G_TYPE_OBJECT);
 
@@ -52,6 +65,86 @@ peas_plugin_loader_initialize (PeasPluginLoader *loader)
   return TRUE;
 }
 
+/*
+ * peas_plugin_loader_prepare:
+ * @loader: A #PeasPluginLoader.
+ * @info: A #PeasPluginInfo.
+ *
+ * Lets @loader do the part of loading @info that does not need to
+ * happen on the thread the plugin is loaded on, like reading the files
+ * it is loaded from. This is called on a worker thread and can be
+ * called concurrently for different plugins. Loaders that do not
+ * implement this do all the work in peas_plugin_loader_load().
+ */
+void
+peas_plugin_loader_prepare (PeasPluginLoader *loader,
+                            PeasPluginInfo   *info)
+{
+  PeasPluginLoaderClass *klass;
+
+  g_return_if_fail (PEAS_IS_PLUGIN_LOADER (loader));
+
+  klass = PEAS_PLUGIN_LOADER_GET_CLASS (loader);
+
+  if (klass->prepare != NULL)
+    klass->prepare (loader, info);
+}
+
+/*
+ * peas_plugin_loader_read_ahead:
+ * @filename: The file to read.
+ *
+ * Reads all of @filename so that it is in the page cache when it is
+ * opened by peas_plugin_loader_load(). Loaders call this from their
+ * prepare() for the files the plugin is loaded from, the reads of the
+ * plugins prepared concurrently then overlap. Errors are ignored,
+ * they are reported when the plugin is loaded.
+ */
+void
+peas_plugin_loader_read_ahead (const gchar *filename)
+{
+  gchar *buffer;
+  gssize n_read;
+  gint fd;
+
+  fd = g_open (filename, O_RDONLY, 0);
+
+  if (fd == -1)
+    return;
+
+  buffer = g_malloc (READ_AHEAD_BUFFER_SIZE);
+
+  do
+    n_read = read (fd, buffer, READ_AHEAD_BUFFER_SIZE);
+  while (n_read > 0 || (n_read == -1 && errno == EINTR));
+
+  g_free (buffer);
+  close (fd);
+}
+
+/*
+ * peas_plugin_loader_unprepare:
+ * @loader: A #PeasPluginLoader.
+ * @info: A #PeasPluginInfo.
+ *
+ * Releases what peas_plugin_loader_prepare() kept for @info. This is
+ * called on the thread the plugin is loaded on once the plugin has
+ * been loaded, has failed to load or will not be loaded at all.
+ */
+void
+peas_plugin_loader_unprepare (PeasPluginLoader *loader,
+                              PeasPluginInfo   *info)
+{
+  PeasPluginLoaderClass *klass;
+
+  g_return_if_fail (PEAS_IS_PLUGIN_LOADER (loader));
+
+  klass = PEAS_PLUGIN_LOADER_GET_CLASS (loader);
+
+  if (klass->unprepare != NULL)
+    klass->unprepare (loader, info);
+}
+
 gboolean
 peas_plugin_loader_load (PeasPluginLoader *loader,
                          PeasPluginInfo   *info)
@@ -116,11 +209,20 @@ void
 peas_plugin_loader_garbage_collect (PeasPluginLoader *loader)
 {
   PeasPluginLoaderClass *klass;
+  gint64 begin_time;
 
   g_return_if_fail (PEAS_IS_PLUGIN_LOADER (loader));
 
   klass = PEAS_PLUGIN_LOADER_GET_CLASS (loader);
 
+  /* Also traced when there is nothing to collect,
+   * so the trace shows when it was asked for
+   */
+  begin_time = peas_trace_begin ();
+
   if (klass->garbage_collect != NULL)
     klass->garbage_collect (loader);
+
+  peas_trace_end ("garbage-collect", G_OBJECT_TYPE_NAME (loader),
+                  begin_time);
 }
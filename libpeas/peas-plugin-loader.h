@@ -48,6 +48,12 @@ struct _PeasPluginLoaderClass {
 
   gboolean       (*initialize)            (PeasPluginLoader *loader);
 
+  /* Called on a worker thread before load() */
+  void           (*prepare)               (PeasPluginLoader *loader,
+                                           PeasPluginInfo   *info);
+  /* Called after load() or instead of it, on every outcome */
+  void           (*unprepare)             (PeasPluginLoader *loader,
+                                           PeasPluginInfo   *info);
   gboolean       (*load)                  (PeasPluginLoader *loader,
                                            PeasPluginInfo   *info);
   void           (*unload)                (PeasPluginLoader *loader,
@@ -68,6 +74,11 @@ GType         peas_plugin_loader_get_type             (void)  G_GNUC_CONST;
 
 gboolean      peas_plugin_loader_initialize           (PeasPluginLoader *loader);
 
+void          peas_plugin_loader_prepare              (PeasPluginLoader *loader,
+                                                       PeasPluginInfo   *info);
+void          peas_plugin_loader_unprepare            (PeasPluginLoader *loader,
+                                                       PeasPluginInfo   *info);
+void          peas_plugin_loader_read_ahead           (const gchar      *filename);
 gboolean      peas_plugin_loader_load                 (PeasPluginLoader *loader,
                                                        PeasPluginInfo   *info);
 void          peas_plugin_loader_unload               (PeasPluginLoader *loader,
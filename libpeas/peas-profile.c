@@ -0,0 +1,215 @@
+/*
+ * peas-profile.c
+ * This file is part of libpeas
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Library General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <time.h>
+
+#include "peas-profile.h"
+#include "peas-trace.h"
+
+/*
+ * Every PeasPluginInfo accumulates the time spent in each of the
+ * phases of loading, using and unloading the plugin. The wall-clock
+ * time is always recorded as it only costs a monotonic clock read,
+ * the timings are guarded by a bit lock in each PeasPluginInfo so the
+ * plugins never wait on each other. Reading the CPU time is a system
+ * call on many platforms, it is only measured when PEAS_PROFILE is set.
+ * The plugins that were timed are then also remembered, under the
+ * global lock, so that a report sorted by the time spent in each
+ * plugin can be printed when the program exits.
+ */
+
+#define TIMINGS_LOCK_BIT 0
+
+static gboolean profile_enabled = FALSE;
+
+static GMutex lock;
+static GPtrArray *profiled_infos = NULL;
+
+static const gchar *phase_names[PEAS_PLUGIN_N_PHASES] = {
+  "deps",
+  "loader",
+  "prepare",
+  "load",
+  "extensions",
+  "unload"
+};
+
+static gint64
+get_cpu_time (void)
+{
+#ifdef CLOCK_THREAD_CPUTIME_ID
+  struct timespec ts;
+
+  if (clock_gettime (CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+    return (gint64) ts.tv_sec * G_USEC_PER_SEC + ts.tv_nsec / 1000;
+#endif
+
+  return 0;
+}
+
+/* The dependencies are not included, they have their own entry */
+static gint64
+get_total_wall_time (PeasPluginInfo *info)
+{
+  gint64 total = 0;
+  guint i;
+
+  for (i = 0; i < PEAS_PLUGIN_N_PHASES; ++i)
+    {
+      if (i != PEAS_PLUGIN_PHASE_DEPENDENCIES)
+        total += info->timings[i].wall_time;
+    }
+
+  return total;
+}
+
+static gint
+compare_total_wall_time (PeasPluginInfo **info1,
+                         PeasPluginInfo **info2)
+{
+  gint64 total1 = get_total_wall_time (*info1);
+  gint64 total2 = get_total_wall_time (*info2);
+
+  return total1 < total2 ? 1 : total1 > total2 ? -1 : 0;
+}
+
+static void
+print_report (void)
+{
+  guint i, j;
+
+  g_mutex_lock (&lock);
+
+  g_ptr_array_sort (profiled_infos, (GCompareFunc) compare_total_wall_time);
+
+  g_printerr ("libpeas plugin profile, wall/cpu time in ms:\n");
+  g_printerr ("%-24s %17s", "plugin", "total");
+  for (j = 0; j < PEAS_PLUGIN_N_PHASES; ++j)
+    g_printerr (" %17s", phase_names[j]);
+  g_printerr ("\n");
+
+  for (i = 0; i < profiled_infos->len; ++i)
+    {
+      PeasPluginInfo *info = g_ptr_array_index (profiled_infos, i);
+      gint64 total_cpu_time = 0;
+
+      for (j = 0; j < PEAS_PLUGIN_N_PHASES; ++j)
+        {
+          if (j != PEAS_PLUGIN_PHASE_DEPENDENCIES)
+            total_cpu_time += info->timings[j].cpu_time;
+        }
+
+      g_printerr ("%-24s %8.2f/%8.2f",
+                  peas_plugin_info_get_module_name (info),
+                  get_total_wall_time (info) / 1000.0,
+                  total_cpu_time / 1000.0);
+
+      for (j = 0; j < PEAS_PLUGIN_N_PHASES; ++j)
+        g_printerr (" %8.2f/%8.2f",
+                    info->timings[j].wall_time / 1000.0,
+                    info->timings[j].cpu_time / 1000.0);
+
+      g_printerr ("\n");
+    }
+
+  g_ptr_array_unref (profiled_infos);
+  profiled_infos = NULL;
+
+  g_mutex_unlock (&lock);
+}
+
+void
+peas_profile_init (void)
+{
+  if (g_getenv ("PEAS_PROFILE") == NULL)
+    return;
+
+  profiled_infos =
+        g_ptr_array_new_with_free_func ((GDestroyNotify) _peas_plugin_info_unref);
+  profile_enabled = TRUE;
+
+  atexit (print_report);
+}
+
+void
+peas_profile_begin (PeasProfileMark *mark)
+{
+  mark->wall_time = g_get_monotonic_time ();
+  mark->cpu_time = G_UNLIKELY (profile_enabled) ? get_cpu_time () : 0;
+}
+
+void
+peas_profile_end (PeasPluginInfo        *info,
+                  PeasPluginPhase        phase,
+                  const PeasProfileMark *mark)
+{
+  gint64 wall_time, cpu_time = 0;
+  gboolean first_timing = FALSE;
+
+  wall_time = g_get_monotonic_time () - mark->wall_time;
+  if (G_UNLIKELY (profile_enabled))
+    cpu_time = get_cpu_time () - mark->cpu_time;
+
+  g_bit_lock (&info->timings_lock, TIMINGS_LOCK_BIT);
+
+  if (info->timings == NULL)
+    {
+      info->timings = g_new0 (PeasPluginTiming, PEAS_PLUGIN_N_PHASES);
+      first_timing = TRUE;
+    }
+
+  info->timings[phase].wall_time += wall_time;
+  info->timings[phase].cpu_time += cpu_time;
+  info->timings[phase].count++;
+
+  g_bit_unlock (&info->timings_lock, TIMINGS_LOCK_BIT);
+
+  if (G_UNLIKELY (first_timing && profile_enabled))
+    {
+      g_mutex_lock (&lock);
+
+      if (profiled_infos != NULL)
+        g_ptr_array_add (profiled_infos, _peas_plugin_info_ref (info));
+
+      g_mutex_unlock (&lock);
+    }
+
+  if (G_UNLIKELY (_peas_trace_enabled))
+    peas_trace_event (phase_names[phase], info->module_name, mark->wall_time);
+}
+
+void
+peas_profile_get_timing (const PeasPluginInfo *info,
+                         PeasPluginPhase       phase,
+                         PeasPluginTiming     *timing)
+{
+  PeasPluginInfo *mutable_info = (PeasPluginInfo *) info;
+
+  g_bit_lock (&mutable_info->timings_lock, TIMINGS_LOCK_BIT);
+
+  if (info->timings != NULL)
+    *timing = info->timings[phase];
+
+  g_bit_unlock (&mutable_info->timings_lock, TIMINGS_LOCK_BIT);
+}
@@ -0,0 +1,47 @@
+/*
+ * peas-profile.h
+ * This file is part of libpeas
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Library General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __PEAS_PROFILE_H__
+#define __PEAS_PROFILE_H__
+
+#include <glib.h>
+
+#include "peas-plugin-info-priv.h"
+
+G_BEGIN_DECLS
+
+typedef struct {
+  gint64 wall_time;
+  gint64 cpu_time;
+} PeasProfileMark;
+
+void  peas_profile_init       (void);
+
+void  peas_profile_begin      (PeasProfileMark       *mark);
+void  peas_profile_end        (PeasPluginInfo        *info,
+                               PeasPluginPhase        phase,
+                               const PeasProfileMark *mark);
+
+void  peas_profile_get_timing (const PeasPluginInfo  *info,
+                               PeasPluginPhase        phase,
+                               PeasPluginTiming      *timing);
+
+G_END_DECLS
+
+#endif /* __PEAS_PROFILE_H__ */
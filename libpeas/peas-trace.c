@@ -0,0 +1,310 @@
+/*
+ * peas-trace.c
+ * This file is part of libpeas
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Library General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#ifdef G_OS_UNIX
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#ifdef G_OS_WIN32
+#include <windows.h>
+#endif
+
+#include "peas-trace.h"
+
+/*
+ * When PEAS_TRACE is set to a filename, the engine activity is
+ * recorded and written to that file in the Chrome trace event format
+ * when the program exits, it can then be opened with chrome://tracing
+ * or Perfetto. The timestamps come from g_get_monotonic_time().
+ *
+ * Every thread records its events in its own ring buffer, so recording
+ * an event takes no lock. Only the last BUFFER_SIZE events of each
+ * thread are kept. The other threads can still be recording while the
+ * trace is written, so an event is only published once it is complete
+ * and the slots that get overwritten while being read are skipped.
+ *
+ * The argument of an event is copied into the event as it is usually
+ * a filename that is freed long before the trace is written. Only the
+ * end of a longer argument is kept, which for a path is the part that
+ * tells the events apart.
+ */
+
+#define BUFFER_SIZE 4096
+#define ARG_SIZE 96
+
+typedef struct {
+  const gchar *name;
+  gint64 begin_time;
+  gint64 duration;
+  /* Empty when the event has no argument */
+  gchar arg[ARG_SIZE];
+} TraceEvent;
+
+typedef struct {
+  guint tid;
+
+  /* The number of events ever recorded, the next one goes at
+   * n_events % BUFFER_SIZE. Only accessed with atomic operations.
+   */
+  guint n_events;
+  TraceEvent events[BUFFER_SIZE];
+} TraceBuffer;
+
+gboolean _peas_trace_enabled = FALSE;
+
+static gchar *trace_filename = NULL;
+static GPrivate thread_buffer = G_PRIVATE_INIT (NULL);
+
+/* Only taken when a thread records its first event and at exit */
+static GMutex buffers_lock;
+static GPtrArray *buffers = NULL;
+
+/* The id of the thread in the system tools, when there is one */
+static guint
+get_thread_id (void)
+{
+#if defined (__linux__) && defined (SYS_gettid)
+  return (guint) syscall (SYS_gettid);
+#elif defined (G_OS_WIN32)
+  return (guint) GetCurrentThreadId ();
+#else
+  return buffers->len + 1;
+#endif
+}
+
+static TraceBuffer *
+get_thread_buffer (void)
+{
+  TraceBuffer *buffer = g_private_get (&thread_buffer);
+
+  if (G_LIKELY (buffer != NULL))
+    return buffer;
+
+  /* The buffers outlive their thread so they can be written at exit */
+  buffer = g_new0 (TraceBuffer, 1);
+
+  g_mutex_lock (&buffers_lock);
+  buffer->tid = get_thread_id ();
+  g_ptr_array_add (buffers, buffer);
+  g_mutex_unlock (&buffers_lock);
+
+  g_private_set (&thread_buffer, buffer);
+
+  return buffer;
+}
+
+static void
+copy_arg (gchar       *dest,
+          const gchar *arg)
+{
+  gsize len;
+
+  if (arg == NULL)
+    {
+      dest[0] = '\0';
+      return;
+    }
+
+  len = strlen (arg);
+
+  if (len < ARG_SIZE)
+    {
+      memcpy (dest, arg, len + 1);
+      return;
+    }
+
+  /* Keep the end, without starting in the middle of a UTF-8 character */
+  arg += len - (ARG_SIZE - 4);
+  while (((guchar) *arg & 0xc0) == 0x80)
+    ++arg;
+
+  memcpy (dest, "...", 3);
+  g_strlcpy (dest + 3, arg, ARG_SIZE - 3);
+}
+
+void
+peas_trace_event (const gchar *name,
+                  const gchar *arg,
+                  gint64       begin_time)
+{
+  TraceBuffer *buffer = get_thread_buffer ();
+  TraceEvent *event;
+
+  /* Only this thread changes n_events */
+  event = &buffer->events[buffer->n_events % BUFFER_SIZE];
+  event->name = name;
+  copy_arg (event->arg, arg);
+  event->begin_time = begin_time;
+  event->duration = g_get_monotonic_time () - begin_time;
+
+  /* Publishes the event, and is a barrier
+   * before the next one overwrites a slot
+   */
+  g_atomic_int_inc (&buffer->n_events);
+}
+
+/* Filenames are not always valid UTF-8,
+ * the invalid bytes are replaced by U+FFFD
+ */
+static void
+append_json_string (GString     *str,
+                    const gchar *value)
+{
+  g_string_append_c (str, '"');
+
+  while (*value != '\0')
+    {
+      gunichar c;
+
+      if (*value == '"' || *value == '\\')
+        {
+          g_string_append_printf (str, "\\%c", *value);
+          ++value;
+        }
+      else if ((guchar) *value < 0x20)
+        {
+          g_string_append_printf (str, "\\u%04x", (guchar) *value);
+          ++value;
+        }
+      else if ((guchar) *value < 0x80)
+        {
+          g_string_append_c (str, *value);
+          ++value;
+        }
+      else if ((c = g_utf8_get_char_validated (value, -1)) >= 0x80 &&
+               c < 0x110000)
+        {
+          const gchar *next = g_utf8_next_char (value);
+
+          g_string_append_len (str, value, next - value);
+          value = next;
+        }
+      else
+        {
+          g_string_append (str, "\\ufffd");
+          ++value;
+        }
+    }
+
+  g_string_append_c (str, '"');
+}
+
+static void
+write_trace (void)
+{
+  GString *str;
+  gboolean first = TRUE;
+  gint pid = 0;
+  GError *error = NULL;
+  guint i;
+
+#ifdef G_OS_UNIX
+  pid = getpid ();
+#endif
+
+  str = g_string_new ("{\"traceEvents\":[");
+
+  g_mutex_lock (&buffers_lock);
+
+  for (i = 0; i < buffers->len; ++i)
+    {
+      TraceBuffer *buffer = g_ptr_array_index (buffers, i);
+      guint j, n_events, n_recorded;
+
+      n_recorded = (guint) g_atomic_int_get (&buffer->n_events);
+      n_events = MIN (n_recorded, BUFFER_SIZE);
+
+      /* Oldest first */
+      for (j = n_recorded - n_events; j < n_recorded; ++j)
+        {
+          TraceEvent copy;
+          TraceEvent *event = &copy;
+
+          memcpy (&copy, &buffer->events[j % BUFFER_SIZE], sizeof (copy));
+
+          /* The thread may have started to overwrite the slot
+           * with event j + BUFFER_SIZE while it was being copied
+           */
+          if ((guint) g_atomic_int_get (&buffer->n_events) >= j + BUFFER_SIZE)
+            continue;
+
+          g_string_append (str, first ? "\n" : ",\n");
+          first = FALSE;
+
+          g_string_append (str, "{\"cat\":\"libpeas\",\"ph\":\"X\",\"name\":");
+          append_json_string (str, event->name);
+          g_string_append_printf (str,
+                                  ",\"ts\":%" G_GINT64_FORMAT
+                                  ",\"dur\":%" G_GINT64_FORMAT
+                                  ",\"pid\":%d,\"tid\":%u",
+                                  event->begin_time, event->duration,
+                                  pid, buffer->tid);
+
+          if (event->arg[0] != '\0')
+            {
+              g_string_append (str, ",\"args\":{\"name\":");
+              append_json_string (str, event->arg);
+              g_string_append_c (str, '}');
+            }
+
+          g_string_append_c (str, '}');
+        }
+    }
+
+  g_mutex_unlock (&buffers_lock);
+
+  g_string_append (str, "\n]}\n");
+
+  if (!g_file_set_contents (trace_filename, str->str, str->len, &error))
+    {
+      g_printerr ("libpeas: could not write the trace: %s\n", error->message);
+      g_error_free (error);
+    }
+
+  g_string_free (str, TRUE);
+}
+
+void
+peas_trace_init (void)
+{
+  const gchar *filename;
+
+  filename = g_getenv ("PEAS_TRACE");
+  if (filename == NULL || *filename == '\0')
+    return;
+
+  trace_filename = g_strdup (filename);
+  buffers = g_ptr_array_new ();
+  _peas_trace_enabled = TRUE;
+
+  atexit (write_trace);
+}
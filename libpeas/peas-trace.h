@@ -0,0 +1,51 @@
+/*
+ * peas-trace.h
+ * This file is part of libpeas
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Library General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __PEAS_TRACE_H__
+#define __PEAS_TRACE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Only read, set once by peas_trace_init() */
+extern gboolean _peas_trace_enabled;
+
+void    peas_trace_init  (void);
+
+void    peas_trace_event (const gchar *name,
+                          const gchar *arg,
+                          gint64       begin_time);
+
+/* Returns 0 when tracing is disabled, which makes
+ * peas_trace_end() a no-op for the matching event
+ */
+#define peas_trace_begin() \
+  (G_UNLIKELY (_peas_trace_enabled) ? g_get_monotonic_time () : 0)
+
+/* @name must be a static string, @arg is copied */
+#define peas_trace_end(name, arg, begin_time) \
+  G_STMT_START { \
+    if (G_UNLIKELY ((begin_time) != 0)) \
+      peas_trace_event ((name), (arg), (begin_time)); \
+  } G_STMT_END
+
+G_END_DECLS
+
+#endif /* __PEAS_TRACE_H__ */
@@ -54,6 +54,18 @@ get_script_filename_for_plugin_info (PeasPluginInfo *info)
   return filename;
 }
 
+static void
+peas_plugin_loader_gjs_prepare (PeasPluginLoader *loader,
+                                PeasPluginInfo   *info)
+{
+  gchar *filename;
+
+  /* The script is read by GJS, the context is not touched here */
+  filename = get_script_filename_for_plugin_info (info);
+  peas_plugin_loader_read_ahead (filename);
+  g_free (filename);
+}
+
 static gboolean
 peas_plugin_loader_gjs_load (PeasPluginLoader *loader,
                              PeasPluginInfo   *info)
@@ -343,6 +355,7 @@ peas_plugin_loader_gjs_class_init (PeasPluginLoaderGjsClass *klass)
 
   gobject_class->finalize = peas_plugin_loader_gjs_finalize;
 
+  loader_class->prepare = peas_plugin_loader_gjs_prepare;
   loader_class->load = peas_plugin_loader_gjs_load;
   loader_class->provides_extension = peas_plugin_loader_gjs_provides_extension;
   loader_class->create_extension = peas_plugin_loader_gjs_create_extension;
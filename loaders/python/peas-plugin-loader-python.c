@@ -204,6 +204,30 @@ add_python_info (PeasPluginLoaderPython *loader,
   g_hash_table_insert (loader->priv->loaded_plugins, info, pyinfo);
 }
 
+static void
+peas_plugin_loader_python_prepare (PeasPluginLoader *loader,
+                                   PeasPluginInfo   *info)
+{
+  const gchar *module_dir, *module_name;
+  gchar *basename, *filename;
+
+  /* The interpreter is not touched without the GIL, only the files
+   * the import will read are, a plugin is a module or a package
+   */
+  module_dir = peas_plugin_info_get_module_dir (info);
+  module_name = peas_plugin_info_get_module_name (info);
+
+  basename = g_strconcat (module_name, ".py", NULL);
+  filename = g_build_filename (module_dir, basename, NULL);
+  peas_plugin_loader_read_ahead (filename);
+  g_free (filename);
+  g_free (basename);
+
+  filename = g_build_filename (module_dir, module_name, "__init__.py", NULL);
+  peas_plugin_loader_read_ahead (filename);
+  g_free (filename);
+}
+
 static gboolean
 peas_plugin_loader_python_load (PeasPluginLoader *loader,
                                 PeasPluginInfo   *info)
@@ -521,6 +545,7 @@ peas_plugin_loader_python_class_init (PeasPluginLoaderPythonClass *klass)
   object_class->finalize = peas_plugin_loader_python_finalize;
 
   loader_class->initialize = peas_plugin_loader_python_initialize;
+  loader_class->prepare = peas_plugin_loader_python_prepare;
   loader_class->load = peas_plugin_loader_python_load;
   loader_class->unload = peas_plugin_loader_python_unload;
   loader_class->create_extension = peas_plugin_loader_python_create_extension;
@@ -54,6 +54,38 @@ get_script_filename_for_plugin_info (PeasPluginInfo *info)
   return filename;
 }
 
+static void
+peas_plugin_loader_seed_prepare (PeasPluginLoader *loader,
+                                 PeasPluginInfo   *info)
+{
+  PeasPluginLoaderSeed *sloader = PEAS_PLUGIN_LOADER_SEED (loader);
+  gchar *filename;
+  gchar *content;
+
+  filename = get_script_filename_for_plugin_info (info);
+
+  /* Errors are reported when load() reads it again */
+  if (g_file_get_contents (filename, &content, NULL, NULL))
+    {
+      g_mutex_lock (&sloader->prepared_lock);
+      g_hash_table_insert (sloader->prepared_sources, info, content);
+      g_mutex_unlock (&sloader->prepared_lock);
+    }
+
+  g_free (filename);
+}
+
+static void
+peas_plugin_loader_seed_unprepare (PeasPluginLoader *loader,
+                                   PeasPluginInfo   *info)
+{
+  PeasPluginLoaderSeed *sloader = PEAS_PLUGIN_LOADER_SEED (loader);
+
+  g_mutex_lock (&sloader->prepared_lock);
+  g_hash_table_remove (sloader->prepared_sources, info);
+  g_mutex_unlock (&sloader->prepared_lock);
+}
+
 static gboolean
 peas_plugin_loader_seed_load (PeasPluginLoader *loader,
                               PeasPluginInfo   *info)
@@ -72,7 +104,15 @@ peas_plugin_loader_seed_load (PeasPluginLoader *loader,
 
   g_debug ("Seed script filename is '%s'", filename);
 
-  if (!g_file_get_contents (filename, &content, NULL, &error))
+  /* Use the source prepare() read, if any */
+  g_mutex_lock (&sloader->prepared_lock);
+  content = g_hash_table_lookup (sloader->prepared_sources, info);
+  if (content != NULL)
+    g_hash_table_steal (sloader->prepared_sources, info);
+  g_mutex_unlock (&sloader->prepared_lock);
+
+  if (content == NULL &&
+      !g_file_get_contents (filename, &content, NULL, &error))
     {
       g_warning ("Error: %s", error->message);
       g_error_free (error);
@@ -350,6 +390,11 @@ peas_plugin_loader_seed_init (PeasPluginLoaderSeed *sloader)
   sloader->loaded_plugins = g_hash_table_new_full (g_direct_hash, g_direct_equal,
                                                    NULL,
                                                    (GDestroyNotify) destroy_seed_info);
+
+  g_mutex_init (&sloader->prepared_lock);
+  sloader->prepared_sources = g_hash_table_new_full (g_direct_hash,
+                                                     g_direct_equal,
+                                                     NULL, g_free);
 }
 
 static void
@@ -358,6 +403,8 @@ peas_plugin_loader_seed_finalize (GObject *object)
   PeasPluginLoaderSeed *sloader = PEAS_PLUGIN_LOADER_SEED (object);
 
   g_hash_table_destroy (sloader->loaded_plugins);
+  g_hash_table_destroy (sloader->prepared_sources);
+  g_mutex_clear (&sloader->prepared_lock);
 
   G_OBJECT_CLASS (peas_plugin_loader_seed_parent_class)->finalize (object);
 }
@@ -370,6 +417,8 @@ peas_plugin_loader_seed_class_init (PeasPluginLoaderSeedClass *klass)
 
   object_class->finalize = peas_plugin_loader_seed_finalize;
 
+  loader_class->prepare = peas_plugin_loader_seed_prepare;
+  loader_class->unprepare = peas_plugin_loader_seed_unprepare;
   loader_class->load = peas_plugin_loader_seed_load;
   loader_class->provides_extension = peas_plugin_loader_seed_provides_extension;
   loader_class->create_extension = peas_plugin_loader_seed_create_extension;
@@ -41,6 +41,10 @@ struct _PeasPluginLoaderSeed {
   PeasPluginLoader parent;
 
   GHashTable *loaded_plugins;
+
+  /* The sources read by prepare(), until load() or unprepare() */
+  GMutex prepared_lock;
+  GHashTable *prepared_sources;
 };
 
 struct _PeasPluginLoaderSeedClass {
@@ -24,11 +24,17 @@
 #endif
 
 #include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <utime.h>
 #include <glib.h>
+#include <glib/gstdio.h>
 #include <libpeas/peas.h>
 
 #include "libpeas/peas-engine-priv.h"
 
+#include "introspection/introspection-callable.h"
+
 #include "testing/testing.h"
 
 typedef struct _TestFixture TestFixture;
@@ -222,6 +228,33 @@ test_engine_unload_plugin_with_self_dep (PeasEngine *engine)
   g_assert (!peas_plugin_info_is_loaded (info));
 }
 
+static void
+test_engine_get_dependants (PeasEngine *engine)
+{
+  PeasPluginInfo *info;
+  GList *dependants;
+
+  info = peas_engine_get_plugin_info (engine, "loadable");
+  dependants = peas_engine_get_dependants (engine, info);
+
+  g_assert_cmpuint (g_list_length (dependants), ==, 1);
+  g_assert (dependants->data == peas_engine_get_plugin_info (engine, "has-dep"));
+
+  g_list_free (dependants);
+
+  info = peas_engine_get_plugin_info (engine, "has-dep");
+  g_assert (peas_engine_get_dependants (engine, info) == NULL);
+
+  /* Plugins can depend on themselves */
+  info = peas_engine_get_plugin_info (engine, "self-dep");
+  dependants = peas_engine_get_dependants (engine, info);
+
+  g_assert_cmpuint (g_list_length (dependants), ==, 1);
+  g_assert (dependants->data == info);
+
+  g_list_free (dependants);
+}
+
 static void
 test_engine_unavailable_plugin (PeasEngine *engine)
 {
@@ -257,6 +290,14 @@ test_engine_not_loadable_plugin (PeasEngine *engine)
   g_error_free (error);
 }
 
+static void
+notify_count_cb (GObject    *object,
+                 GParamSpec *pspec,
+                 gint       *count)
+{
+  ++(*count);
+}
+
 static void
 load_plugin_cb (PeasEngine     *engine,
                 PeasPluginInfo *info,
@@ -374,6 +415,408 @@ test_engine_loaded_plugins (PeasEngine *engine)
   g_strfreev (loaded_plugins);
 }
 
+static void
+record_load_order_cb (PeasEngine     *engine,
+                      PeasPluginInfo *info,
+                      GPtrArray      *order)
+{
+  g_ptr_array_add (order, info);
+}
+
+static void
+test_engine_loaded_plugins_batch (PeasEngine *engine)
+{
+  PeasPluginInfo *info, *dep_info;
+  GPtrArray *order;
+  gint count = 0;
+  const gchar *load_plugins[] = { "has-dep", NULL };
+
+  info = peas_engine_get_plugin_info (engine, "has-dep");
+  dep_info = peas_engine_get_plugin_info (engine, "loadable");
+
+  order = g_ptr_array_new ();
+
+  g_signal_connect (engine, "load-plugin",
+                    G_CALLBACK (record_load_order_cb), order);
+  g_signal_connect (engine, "notify::loaded-plugins",
+                    G_CALLBACK (notify_count_cb), &count);
+
+  /* The dependency is loaded first and only one notify is emitted */
+  peas_engine_set_loaded_plugins (engine, load_plugins);
+
+  g_assert (peas_plugin_info_is_loaded (info));
+  g_assert (peas_plugin_info_is_loaded (dep_info));
+  g_assert_cmpuint (order->len, ==, 2);
+  g_assert (g_ptr_array_index (order, 0) == dep_info);
+  g_assert (g_ptr_array_index (order, 1) == info);
+  g_assert_cmpint (count, ==, 1);
+
+  /* The dependency is kept loaded as has-dep needs it */
+  peas_engine_set_loaded_plugins (engine, load_plugins);
+
+  g_assert (peas_plugin_info_is_loaded (dep_info));
+  g_assert_cmpuint (order->len, ==, 2);
+  g_assert_cmpint (count, ==, 1);
+
+  peas_engine_set_loaded_plugins (engine, NULL);
+
+  g_assert (!peas_plugin_info_is_loaded (info));
+  g_assert (!peas_plugin_info_is_loaded (dep_info));
+  g_assert_cmpint (count, ==, 2);
+
+  g_signal_handlers_disconnect_by_func (engine, record_load_order_cb, order);
+  g_ptr_array_unref (order);
+}
+
+static void
+test_engine_parallel_load (PeasEngine *engine)
+{
+  PeasPluginInfo *info, *dep_info;
+  GPtrArray *order;
+  const gchar *load_plugins[] = { "has-dep", "loadable", NULL };
+
+  g_assert (!peas_engine_get_parallel_load (engine));
+  peas_engine_set_parallel_load (engine, TRUE);
+  g_assert (peas_engine_get_parallel_load (engine));
+
+  info = peas_engine_get_plugin_info (engine, "has-dep");
+  dep_info = peas_engine_get_plugin_info (engine, "loadable");
+
+  order = g_ptr_array_new ();
+
+  g_signal_connect (engine, "load-plugin",
+                    G_CALLBACK (record_load_order_cb), order);
+
+  /* The plugins are still loaded in dependency order */
+  peas_engine_set_loaded_plugins (engine, load_plugins);
+
+  g_assert (peas_plugin_info_is_loaded (info));
+  g_assert (peas_plugin_info_is_loaded (dep_info));
+  g_assert_cmpuint (order->len, ==, 2);
+  g_assert (g_ptr_array_index (order, 0) == dep_info);
+  g_assert (g_ptr_array_index (order, 1) == info);
+
+  peas_engine_set_loaded_plugins (engine, NULL);
+
+  g_assert (!peas_plugin_info_is_loaded (info));
+  g_assert (!peas_plugin_info_is_loaded (dep_info));
+
+  /* Loading again after unloading works the same way */
+  peas_engine_set_loaded_plugins (engine, load_plugins);
+
+  g_assert (peas_plugin_info_is_loaded (info));
+  g_assert (peas_plugin_info_is_loaded (dep_info));
+  g_assert_cmpuint (order->len, ==, 4);
+
+  g_signal_handlers_disconnect_by_func (engine, record_load_order_cb, order);
+  g_ptr_array_unref (order);
+}
+
+static void
+test_engine_parallel_load_prepare_thread (PeasEngine *engine)
+{
+  PeasPluginInfo *info;
+  GQuark quark;
+  guint count;
+  const gchar *load_plugins[] = { "prepare", "loadable", NULL };
+
+  /* Set by the plugin when its module is first opened */
+  quark = g_quark_from_static_string ("testing-prepare-thread");
+  g_assert (g_type_get_qdata (PEAS_TYPE_ENGINE, quark) == NULL);
+
+  peas_engine_set_parallel_load (engine, TRUE);
+
+  info = peas_engine_get_plugin_info (engine, "prepare");
+
+  peas_engine_set_loaded_plugins (engine, load_plugins);
+
+  g_assert (peas_plugin_info_is_loaded (info));
+
+  /* The plugin was prepared on a worker thread */
+  peas_plugin_info_get_timing (info, PEAS_PLUGIN_PHASE_PREPARE,
+                               NULL, NULL, &count);
+  g_assert_cmpuint (count, ==, 1);
+
+  /* But prepare() only read the module, it was opened by load() */
+  g_assert (g_type_get_qdata (PEAS_TYPE_ENGINE, quark) == g_thread_self ());
+
+  peas_engine_set_loaded_plugins (engine, NULL);
+  g_assert (!peas_plugin_info_is_loaded (info));
+
+  peas_engine_set_loaded_plugins (engine, load_plugins);
+  g_assert (peas_plugin_info_is_loaded (info));
+}
+
+/* Drops the modules of the plugins from the page cache,
+ * C plugins are resident so each run loads them in a new process
+ */
+static void
+evict_plugin_modules (PeasEngine   *engine,
+                      const gchar **plugin_names)
+{
+#ifdef POSIX_FADV_DONTNEED
+  guint i;
+
+  for (i = 0; plugin_names[i] != NULL; ++i)
+    {
+      PeasPluginInfo *info;
+      gchar *path;
+      gint fd;
+
+      info = peas_engine_get_plugin_info (engine, plugin_names[i]);
+      path = g_module_build_path (peas_plugin_info_get_module_dir (info),
+                                  peas_plugin_info_get_module_name (info));
+
+      fd = g_open (path, O_RDONLY, 0);
+      if (fd != -1)
+        {
+          posix_fadvise (fd, 0, 0, POSIX_FADV_DONTNEED);
+          close (fd);
+        }
+
+      g_free (path);
+    }
+#endif
+}
+
+static void
+test_engine_parallel_load_benchmark (PeasEngine *engine)
+{
+  guint i;
+  const gchar *load_plugins[] = {
+    "extension-c", "has-dep", "loadable", "prepare", NULL
+  };
+
+  for (i = 0; i < 2; ++i)
+    {
+      gboolean parallel_load = i == 1;
+
+      if (g_test_trap_fork (0, 0))
+        {
+          gdouble elapsed;
+
+          peas_engine_set_parallel_load (engine, parallel_load);
+          evict_plugin_modules (engine, load_plugins);
+
+          g_test_timer_start ();
+          peas_engine_set_loaded_plugins (engine, load_plugins);
+          elapsed = g_test_timer_elapsed ();
+
+          g_test_minimized_result (elapsed * 1000,
+                                   "Loading %u plugins with cold caches, "
+                                   "parallel-load %s: %.3f ms",
+                                   g_strv_length ((gchar **) load_plugins),
+                                   parallel_load ? "on" : "off",
+                                   elapsed * 1000);
+          exit (0);
+        }
+
+      g_test_trap_assert_passed ();
+    }
+}
+
+static void
+test_engine_lazy_load (PeasEngine *engine)
+{
+  PeasPluginInfo *info, *dep_info;
+  gchar **loaded_plugins;
+  gint count = 0;
+  const gchar *load_plugins[] = { "has-dep", NULL };
+
+  g_assert (!peas_engine_get_lazy_load (engine));
+  peas_engine_set_lazy_load (engine, TRUE);
+  g_assert (peas_engine_get_lazy_load (engine));
+
+  info = peas_engine_get_plugin_info (engine, "has-dep");
+  dep_info = peas_engine_get_plugin_info (engine, "loadable");
+
+  g_signal_connect (engine, "notify::loaded-plugins",
+                    G_CALLBACK (notify_count_cb), &count);
+
+  /* The plugins are only marked as enabled */
+  peas_engine_set_loaded_plugins (engine, load_plugins);
+
+  g_assert_cmpint (count, ==, 1);
+  g_assert (!peas_plugin_info_is_loaded (info));
+  g_assert (!peas_plugin_info_is_loaded (dep_info));
+  g_assert (peas_engine_is_plugin_deferred (engine, info));
+  g_assert (peas_engine_is_plugin_deferred (engine, dep_info));
+
+  loaded_plugins = peas_engine_get_loaded_plugins (engine);
+  g_assert_cmpuint (g_strv_length (loaded_plugins), ==, 2);
+  g_strfreev (loaded_plugins);
+
+  /* Asking for an extension loads the plugin and its dependency */
+  g_assert (peas_engine_provides_extension (engine, info,
+                                            PEAS_TYPE_ACTIVATABLE));
+
+  g_assert (peas_plugin_info_is_loaded (info));
+  g_assert (peas_plugin_info_is_loaded (dep_info));
+  g_assert (!peas_engine_is_plugin_deferred (engine, info));
+  g_assert (!peas_engine_is_plugin_deferred (engine, dep_info));
+
+  peas_engine_set_loaded_plugins (engine, NULL);
+
+  g_assert (!peas_plugin_info_is_loaded (info));
+  g_assert (!peas_plugin_info_is_loaded (dep_info));
+
+  /* Unloading a deferred plugin only forgets about it */
+  peas_engine_set_loaded_plugins (engine, load_plugins);
+  g_assert (peas_engine_unload_plugin (engine, info));
+  g_assert (!peas_engine_is_plugin_deferred (engine, info));
+  g_assert (!peas_plugin_info_is_loaded (info));
+
+  /* And its deferred dependants are forgotten with it */
+  peas_engine_set_loaded_plugins (engine, load_plugins);
+  g_assert (peas_engine_unload_plugin (engine, dep_info));
+  g_assert (!peas_engine_is_plugin_deferred (engine, dep_info));
+  g_assert (!peas_engine_is_plugin_deferred (engine, info));
+
+  /* Turning lazy loading off loads the remaining plugins */
+  peas_engine_set_loaded_plugins (engine, load_plugins);
+  g_assert (peas_engine_unload_plugin (engine, info));
+  peas_engine_set_lazy_load (engine, FALSE);
+
+  g_assert (!peas_plugin_info_is_loaded (info));
+  g_assert (peas_plugin_info_is_loaded (dep_info));
+  g_assert (!peas_engine_is_plugin_deferred (engine, dep_info));
+}
+
+static void
+test_engine_lazy_load_failure (PeasEngine *engine)
+{
+  PeasPluginInfo *info;
+  gchar **loaded_plugins;
+  gint count = 0;
+  const gchar *load_plugins[] = { "not-loadable", NULL };
+
+  testing_util_push_log_hook ("*libnot-loadable.so: cannot open shared "
+                              "object file: No such file or directory");
+  testing_util_push_log_hook ("Error loading plugin 'not-loadable'");
+
+  peas_engine_set_lazy_load (engine, TRUE);
+
+  info = peas_engine_get_plugin_info (engine, "not-loadable");
+
+  peas_engine_set_loaded_plugins (engine, load_plugins);
+  g_assert (peas_engine_is_plugin_deferred (engine, info));
+
+  loaded_plugins = peas_engine_get_loaded_plugins (engine);
+  g_assert_cmpuint (g_strv_length (loaded_plugins), ==, 1);
+  g_strfreev (loaded_plugins);
+
+  g_signal_connect (engine, "notify::loaded-plugins",
+                    G_CALLBACK (notify_count_cb), &count);
+
+  /* Failing to load it drops it from the loaded plugins */
+  g_assert (!peas_engine_load_plugin (engine, info));
+
+  g_assert_cmpint (count, ==, 1);
+  g_assert (!peas_plugin_info_is_loaded (info));
+  g_assert (!peas_engine_is_plugin_deferred (engine, info));
+
+  loaded_plugins = peas_engine_get_loaded_plugins (engine);
+  g_assert_cmpuint (g_strv_length (loaded_plugins), ==, 0);
+  g_strfreev (loaded_plugins);
+}
+
+static void
+test_engine_declared_extensions (PeasEngine *engine)
+{
+  PeasPluginInfo *info;
+  GList *plugins;
+  const gchar *load_plugins[] = { "loadable", NULL };
+
+  info = peas_engine_get_plugin_info (engine, "loadable");
+
+  /* Found without loading anything */
+  plugins = peas_engine_get_plugins_for_extension (engine,
+                                                   PEAS_TYPE_ACTIVATABLE);
+  g_assert (g_list_find (plugins, info) != NULL);
+  g_assert (!peas_plugin_info_is_loaded (info));
+  g_list_free (plugins);
+
+  plugins = peas_engine_get_plugins_for_extension (engine,
+                                                   INTROSPECTION_TYPE_CALLABLE);
+  g_assert (g_list_find (plugins, info) == NULL);
+  g_list_free (plugins);
+
+  peas_engine_set_lazy_load (engine, TRUE);
+  peas_engine_set_loaded_plugins (engine, load_plugins);
+
+  /* A type that is not declared does not load the plugin */
+  g_assert (!peas_engine_provides_extension (engine, info,
+                                             INTROSPECTION_TYPE_CALLABLE));
+  g_assert (!peas_plugin_info_is_loaded (info));
+  g_assert (peas_engine_is_plugin_deferred (engine, info));
+
+  /* But a declared one does */
+  g_assert (peas_engine_provides_extension (engine, info,
+                                            PEAS_TYPE_ACTIVATABLE));
+  g_assert (peas_plugin_info_is_loaded (info));
+}
+
+static void
+test_engine_plugin_timing (PeasEngine *engine)
+{
+  PeasPluginInfo *info;
+  PeasExtension *extension;
+  gint64 wall_time, cpu_time;
+  guint count;
+
+  info = peas_engine_get_plugin_info (engine, "loadable");
+
+  peas_plugin_info_get_timing (info, PEAS_PLUGIN_PHASE_LOAD,
+                               &wall_time, &cpu_time, &count);
+  g_assert_cmpint (wall_time, ==, 0);
+  g_assert_cmpint (cpu_time, ==, 0);
+  g_assert_cmpuint (count, ==, 0);
+
+  g_assert (peas_engine_load_plugin (engine, info));
+
+  /* The plugin has no dependencies */
+  peas_plugin_info_get_timing (info, PEAS_PLUGIN_PHASE_DEPENDENCIES,
+                               NULL, NULL, &count);
+  g_assert_cmpuint (count, ==, 0);
+  peas_plugin_info_get_timing (info, PEAS_PLUGIN_PHASE_LOADER,
+                               NULL, NULL, &count);
+  g_assert_cmpuint (count, ==, 1);
+  peas_plugin_info_get_timing (info, PEAS_PLUGIN_PHASE_LOAD,
+                               &wall_time, &cpu_time, &count);
+  g_assert_cmpuint (count, ==, 1);
+  g_assert_cmpint (wall_time, >=, 0);
+  g_assert_cmpint (cpu_time, >=, 0);
+
+  extension = peas_engine_create_extension (engine, info,
+                                            PEAS_TYPE_ACTIVATABLE,
+                                            "object", NULL,
+                                            NULL);
+  g_object_unref (extension);
+
+  peas_plugin_info_get_timing (info, PEAS_PLUGIN_PHASE_CREATE_EXTENSION,
+                               NULL, NULL, &count);
+  g_assert_cmpuint (count, ==, 1);
+
+  g_assert (peas_engine_unload_plugin (engine, info));
+
+  peas_plugin_info_get_timing (info, PEAS_PLUGIN_PHASE_UNLOAD,
+                               NULL, NULL, &count);
+  g_assert_cmpuint (count, ==, 1);
+
+  /* Nothing was prepared on a worker thread */
+  peas_plugin_info_get_timing (info, PEAS_PLUGIN_PHASE_PREPARE,
+                               NULL, NULL, &count);
+  g_assert_cmpuint (count, ==, 0);
+
+  info = peas_engine_get_plugin_info (engine, "has-dep");
+  g_assert (peas_engine_load_plugin (engine, info));
+
+  peas_plugin_info_get_timing (info, PEAS_PLUGIN_PHASE_DEPENDENCIES,
+                               &wall_time, NULL, &count);
+  g_assert_cmpuint (count, ==, 1);
+  g_assert_cmpint (wall_time, >=, 0);
+}
+
 static void
 test_engine_nonexistent_loader (PeasEngine *engine)
 {
@@ -427,6 +870,511 @@ test_engine_nonexistent_search_path (PeasEngine *engine)
   peas_engine_add_search_path (engine, "/nowhere", NULL);
 }
 
+static void
+test_engine_plugin_cache (PeasEngine *engine)
+{
+  gchar *checksum;
+  gchar *basename;
+  gchar *filename;
+  gchar *module_dir;
+  gchar *plugin_filename;
+  struct utimbuf times = { 1000000000, 1000000000 };
+  PeasEngine *cache_engine;
+  PeasPluginInfo *info;
+  GError *error = NULL;
+
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA1,
+                                            BUILDDIR "/tests/libpeas/plugins",
+                                            -1);
+  basename = g_strconcat (checksum, ".cache", NULL);
+  filename = g_build_filename (BUILDDIR, "tests", "plugin-cache",
+                               basename, NULL);
+
+  /* Adding the search path has written the cache */
+  g_assert (g_file_test (filename, G_FILE_TEST_IS_REGULAR));
+
+  /* Rescanning uses the cache and does not duplicate plugins */
+  info = peas_engine_get_plugin_info (engine, "loadable");
+  peas_engine_rescan_plugins (engine);
+  g_assert (peas_engine_get_plugin_info (engine, "loadable") == info);
+
+  g_free (filename);
+  g_free (basename);
+  g_free (checksum);
+
+  module_dir = g_build_filename (g_get_tmp_dir (), "libpeas-XXXXXX", NULL);
+  g_assert (g_mkdtemp (module_dir) != NULL);
+  plugin_filename = g_build_filename (module_dir, "cached.plugin", NULL);
+
+  g_file_set_contents (plugin_filename,
+                       "[Plugin]\nModule=cached\nName=First\n",
+                       -1, &error);
+  g_assert_no_error (error);
+
+  /* Whole seconds, so that utime() can restore the exact mtime */
+  g_assert_cmpint (g_utime (plugin_filename, &times), ==, 0);
+
+  cache_engine = peas_engine_new ();
+  peas_engine_add_search_path (cache_engine, module_dir, NULL);
+  g_object_unref (cache_engine);
+
+  /* Neither the size nor the mtime change, so a new engine
+   * gets the info from the cache instead of parsing the file
+   */
+  g_file_set_contents (plugin_filename,
+                       "[Plugin]\nModule=cached\nName=Other\n",
+                       -1, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (g_utime (plugin_filename, &times), ==, 0);
+
+  cache_engine = peas_engine_new ();
+  peas_engine_add_search_path (cache_engine, module_dir, NULL);
+
+  info = peas_engine_get_plugin_info (cache_engine, "cached");
+  g_assert (info != NULL);
+  g_assert_cmpstr (peas_plugin_info_get_name (info), ==, "First");
+
+  g_object_unref (cache_engine);
+
+  g_unlink (plugin_filename);
+  g_rmdir (module_dir);
+  g_free (plugin_filename);
+  g_free (module_dir);
+}
+
+static void
+test_engine_plugin_cache_same_second (PeasEngine *engine)
+{
+  PeasEngine *cache_engine;
+  PeasPluginInfo *info;
+  gchar *module_dir;
+  gchar *filename;
+  GError *error = NULL;
+
+  module_dir = g_build_filename (g_get_tmp_dir (), "libpeas-XXXXXX", NULL);
+  g_assert (g_mkdtemp (module_dir) != NULL);
+  filename = g_build_filename (module_dir, "cached.plugin", NULL);
+
+  g_file_set_contents (filename,
+                       "[Plugin]\nModule=cached\nName=First\n",
+                       -1, &error);
+  g_assert_no_error (error);
+
+  cache_engine = peas_engine_new ();
+  peas_engine_add_search_path (cache_engine, module_dir, NULL);
+  g_object_unref (cache_engine);
+
+  /* Same size and most likely the same second as the cached entry */
+  g_file_set_contents (filename,
+                       "[Plugin]\nModule=cached\nName=Other\n",
+                       -1, &error);
+  g_assert_no_error (error);
+
+  cache_engine = peas_engine_new ();
+  peas_engine_add_search_path (cache_engine, module_dir, NULL);
+
+  info = peas_engine_get_plugin_info (cache_engine, "cached");
+  g_assert (info != NULL);
+  g_assert_cmpstr (peas_plugin_info_get_name (info), ==, "Other");
+
+  g_object_unref (cache_engine);
+
+  g_unlink (filename);
+  g_rmdir (module_dir);
+  g_free (filename);
+  g_free (module_dir);
+}
+
+static void
+test_engine_parallel_scan (PeasEngine *engine)
+{
+  PeasEngine *parallel_engine;
+  const GList *serial_list, *parallel_list;
+
+  parallel_engine = PEAS_ENGINE (g_object_new (PEAS_TYPE_ENGINE,
+                                               "parallel-scan", TRUE,
+                                               NULL));
+  g_assert (peas_engine_get_parallel_scan (parallel_engine));
+
+  peas_engine_add_search_path (parallel_engine,
+                               BUILDDIR "/tests/plugins",
+                               SRCDIR   "/tests/plugins");
+  peas_engine_add_search_path (parallel_engine,
+                               BUILDDIR "/tests/libpeas/plugins",
+                               SRCDIR   "/tests/libpeas/plugins");
+
+  /* The plugins are found in the same order as when scanning serially */
+  serial_list = peas_engine_get_plugin_list (engine);
+  parallel_list = peas_engine_get_plugin_list (parallel_engine);
+
+  while (serial_list != NULL && parallel_list != NULL)
+    {
+      PeasPluginInfo *serial_info = serial_list->data;
+      PeasPluginInfo *parallel_info = parallel_list->data;
+
+      g_assert_cmpstr (peas_plugin_info_get_module_name (serial_info), ==,
+                       peas_plugin_info_get_module_name (parallel_info));
+      g_assert_cmpstr (peas_plugin_info_get_module_dir (serial_info), ==,
+                       peas_plugin_info_get_module_dir (parallel_info));
+
+      serial_list = serial_list->next;
+      parallel_list = parallel_list->next;
+    }
+
+  g_assert (serial_list == NULL);
+  g_assert (parallel_list == NULL);
+
+  /* Rescanning does not duplicate plugins */
+  peas_engine_rescan_plugins (parallel_engine);
+  g_assert_cmpuint (g_list_length ((GList *) peas_engine_get_plugin_list (engine)), ==,
+                    g_list_length ((GList *) peas_engine_get_plugin_list (parallel_engine)));
+
+  g_object_unref (parallel_engine);
+}
+
+static void
+async_ready_cb (GObject      *object,
+                GAsyncResult *result,
+                GAsyncResult **result_out)
+{
+  *result_out = g_object_ref (result);
+}
+
+static GAsyncResult *
+wait_for_result (GAsyncResult **result)
+{
+  while (*result == NULL)
+    g_main_context_iteration (NULL, TRUE);
+
+  return *result;
+}
+
+static void
+test_engine_add_search_path_async (PeasEngine *engine)
+{
+  PeasEngine *async_engine;
+  GAsyncResult *result = NULL;
+  GError *error = NULL;
+  gint count = 0;
+
+  async_engine = peas_engine_new ();
+  g_signal_connect (async_engine, "notify::plugin-list",
+                    G_CALLBACK (notify_count_cb), &count);
+
+  peas_engine_add_search_path_async (async_engine,
+                                     BUILDDIR "/tests/plugins",
+                                     SRCDIR   "/tests/plugins",
+                                     NULL,
+                                     (GAsyncReadyCallback) async_ready_cb,
+                                     &result);
+
+  /* Nothing is added before returning to the main loop */
+  g_assert (peas_engine_get_plugin_info (async_engine, "loadable") == NULL);
+
+  g_assert (peas_engine_add_search_path_finish (async_engine,
+                                                wait_for_result (&result),
+                                                &error));
+  g_assert_no_error (error);
+  g_object_unref (result);
+
+  /* All of the plugins were added with a single notify */
+  g_assert_cmpint (count, ==, 1);
+  g_assert (peas_engine_get_plugin_info (async_engine, "loadable") != NULL);
+
+  g_object_unref (async_engine);
+}
+
+static void
+test_engine_rescan_plugins_async (PeasEngine *engine)
+{
+  GCancellable *cancellable;
+  GAsyncResult *result = NULL;
+  GError *error = NULL;
+  gint count = 0;
+  guint n_plugins;
+
+  n_plugins = g_list_length ((GList *) peas_engine_get_plugin_list (engine));
+
+  g_signal_connect (engine, "notify::plugin-list",
+                    G_CALLBACK (notify_count_cb), &count);
+
+  peas_engine_rescan_plugins_async (engine, NULL,
+                                    (GAsyncReadyCallback) async_ready_cb,
+                                    &result);
+  g_assert (peas_engine_rescan_plugins_finish (engine,
+                                               wait_for_result (&result),
+                                               &error));
+  g_assert_no_error (error);
+  g_object_unref (result);
+  result = NULL;
+
+  /* Nothing new was found */
+  g_assert_cmpint (count, ==, 0);
+  g_assert_cmpuint (g_list_length ((GList *) peas_engine_get_plugin_list (engine)),
+                    ==, n_plugins);
+
+  /* A cancelled rescan fails */
+  cancellable = g_cancellable_new ();
+  g_cancellable_cancel (cancellable);
+
+  peas_engine_rescan_plugins_async (engine, cancellable,
+                                    (GAsyncReadyCallback) async_ready_cb,
+                                    &result);
+  g_assert (!peas_engine_rescan_plugins_finish (engine,
+                                                wait_for_result (&result),
+                                                &error));
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+  g_error_free (error);
+  g_object_unref (result);
+
+  g_object_unref (cancellable);
+}
+
+static void
+test_engine_load_plugin_async (PeasEngine *engine)
+{
+  PeasPluginInfo *info, *dep_info;
+  GCancellable *cancellable;
+  GAsyncResult *result = NULL;
+  GError *error = NULL;
+  GPtrArray *order;
+
+  info = peas_engine_get_plugin_info (engine, "has-dep");
+  dep_info = peas_engine_get_plugin_info (engine, "loadable");
+
+  /* A cancelled load does not load anything */
+  cancellable = g_cancellable_new ();
+  g_cancellable_cancel (cancellable);
+
+  peas_engine_load_plugin_async (engine, info, cancellable,
+                                 (GAsyncReadyCallback) async_ready_cb,
+                                 &result);
+  g_assert (!peas_engine_load_plugin_finish (engine,
+                                             wait_for_result (&result),
+                                             &error));
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+  g_clear_error (&error);
+  g_object_unref (result);
+  result = NULL;
+
+  g_assert (!peas_plugin_info_is_loaded (info));
+  g_assert (!peas_plugin_info_is_loaded (dep_info));
+
+  g_object_unref (cancellable);
+
+  order = g_ptr_array_new ();
+  g_signal_connect (engine, "load-plugin",
+                    G_CALLBACK (record_load_order_cb), order);
+
+  peas_engine_load_plugin_async (engine, info, NULL,
+                                 (GAsyncReadyCallback) async_ready_cb,
+                                 &result);
+
+  /* Nothing is loaded before returning to the main loop */
+  g_assert (!peas_plugin_info_is_loaded (dep_info));
+
+  g_assert (peas_engine_load_plugin_finish (engine,
+                                            wait_for_result (&result),
+                                            &error));
+  g_assert_no_error (error);
+  g_object_unref (result);
+  result = NULL;
+
+  /* The dependency is loaded first */
+  g_assert (peas_plugin_info_is_loaded (info));
+  g_assert (peas_plugin_info_is_loaded (dep_info));
+  g_assert_cmpuint (order->len, ==, 2);
+  g_assert (g_ptr_array_index (order, 0) == dep_info);
+  g_assert (g_ptr_array_index (order, 1) == info);
+
+  g_signal_handlers_disconnect_by_func (engine, record_load_order_cb, order);
+  g_ptr_array_unref (order);
+
+  /* A plugin prepared on a worker thread
+   * can be unloaded and loaded again
+   */
+  info = peas_engine_get_plugin_info (engine, "prepare");
+
+  peas_engine_load_plugin_async (engine, info, NULL,
+                                 (GAsyncReadyCallback) async_ready_cb,
+                                 &result);
+  g_assert (peas_engine_load_plugin_finish (engine,
+                                            wait_for_result (&result),
+                                            &error));
+  g_assert_no_error (error);
+  g_object_unref (result);
+  result = NULL;
+
+  g_assert (peas_plugin_info_is_loaded (info));
+  g_assert (peas_engine_unload_plugin (engine, info));
+  g_assert (!peas_plugin_info_is_loaded (info));
+
+  peas_engine_load_plugin_async (engine, info, NULL,
+                                 (GAsyncReadyCallback) async_ready_cb,
+                                 &result);
+  g_assert (peas_engine_load_plugin_finish (engine,
+                                            wait_for_result (&result),
+                                            &error));
+  g_assert_no_error (error);
+  g_object_unref (result);
+  result = NULL;
+
+  g_assert (peas_plugin_info_is_loaded (info));
+
+  /* A failure is reported with the error of the plugin */
+  testing_util_push_log_hook ("*libnot-loadable.so: cannot open shared "
+                              "object file: No such file or directory");
+  testing_util_push_log_hook ("Error loading plugin 'not-loadable'");
+
+  info = peas_engine_get_plugin_info (engine, "not-loadable");
+
+  peas_engine_load_plugin_async (engine, info, NULL,
+                                 (GAsyncReadyCallback) async_ready_cb,
+                                 &result);
+  g_assert (!peas_engine_load_plugin_finish (engine,
+                                             wait_for_result (&result),
+                                             &error));
+  g_assert_error (error, PEAS_PLUGIN_INFO_ERROR,
+                  PEAS_PLUGIN_INFO_ERROR_LOADING_FAILED);
+  g_error_free (error);
+  g_object_unref (result);
+}
+
+static gboolean
+timeout_cb (gboolean *timed_out)
+{
+  *timed_out = TRUE;
+  return FALSE;
+}
+
+static gboolean
+wait_for_plugin_info (PeasEngine  *engine,
+                      const gchar *module_name,
+                      gboolean     exists)
+{
+  gboolean timed_out = FALSE;
+  guint timeout_id;
+
+  timeout_id = g_timeout_add_seconds (5, (GSourceFunc) timeout_cb,
+                                      &timed_out);
+
+  while (!timed_out &&
+         (peas_engine_get_plugin_info (engine, module_name) != NULL) != exists)
+    g_main_context_iteration (NULL, TRUE);
+
+  if (!timed_out)
+    g_source_remove (timeout_id);
+
+  return !timed_out;
+}
+
+static void
+test_engine_monitor_search_paths (PeasEngine *engine)
+{
+  PeasEngine *monitor_engine;
+  gchar *module_dir;
+  gchar *filename;
+  GError *error = NULL;
+
+  module_dir = g_build_filename (g_get_tmp_dir (), "libpeas-XXXXXX", NULL);
+  g_assert (g_mkdtemp (module_dir) != NULL);
+  filename = g_build_filename (module_dir, "monitored.plugin", NULL);
+
+  monitor_engine = peas_engine_new ();
+  peas_engine_set_monitor_search_paths (monitor_engine, TRUE);
+  g_assert (peas_engine_get_monitor_search_paths (monitor_engine));
+
+  peas_engine_add_search_path (monitor_engine, module_dir, NULL);
+  g_assert (peas_engine_get_plugin_info (monitor_engine, "monitored") == NULL);
+
+  /* A new plugin is found without rescanning */
+  g_file_set_contents (filename,
+                       "[Plugin]\nModule=monitored\nName=Monitored\n",
+                       -1, &error);
+  g_assert_no_error (error);
+  g_assert (wait_for_plugin_info (monitor_engine, "monitored", TRUE));
+
+  /* And removed once it is deleted */
+  g_assert_cmpint (g_unlink (filename), ==, 0);
+  g_assert (wait_for_plugin_info (monitor_engine, "monitored", FALSE));
+
+  g_object_unref (monitor_engine);
+
+  g_rmdir (module_dir);
+  g_free (filename);
+  g_free (module_dir);
+}
+
+static gboolean
+wait_for_plugin_name (PeasEngine  *engine,
+                      const gchar *module_name,
+                      const gchar *name)
+{
+  gboolean timed_out = FALSE;
+  guint timeout_id;
+  PeasPluginInfo *info;
+
+  timeout_id = g_timeout_add_seconds (5, (GSourceFunc) timeout_cb,
+                                      &timed_out);
+
+  while (!timed_out &&
+         ((info = peas_engine_get_plugin_info (engine, module_name)) == NULL ||
+          g_strcmp0 (peas_plugin_info_get_name (info), name) != 0))
+    g_main_context_iteration (NULL, TRUE);
+
+  if (!timed_out)
+    g_source_remove (timeout_id);
+
+  return !timed_out;
+}
+
+static void
+test_engine_monitor_search_paths_override (PeasEngine *engine)
+{
+  PeasEngine *monitor_engine;
+  gchar *user_dir, *system_dir;
+  gchar *user_filename, *system_filename;
+  GError *error = NULL;
+
+  user_dir = g_build_filename (g_get_tmp_dir (), "libpeas-XXXXXX", NULL);
+  g_assert (g_mkdtemp (user_dir) != NULL);
+  system_dir = g_build_filename (g_get_tmp_dir (), "libpeas-XXXXXX", NULL);
+  g_assert (g_mkdtemp (system_dir) != NULL);
+
+  user_filename = g_build_filename (user_dir, "monitored.plugin", NULL);
+  system_filename = g_build_filename (system_dir, "monitored.plugin", NULL);
+
+  g_file_set_contents (user_filename,
+                       "[Plugin]\nModule=monitored\nName=User\n",
+                       -1, &error);
+  g_assert_no_error (error);
+  g_file_set_contents (system_filename,
+                       "[Plugin]\nModule=monitored\nName=System\n",
+                       -1, &error);
+  g_assert_no_error (error);
+
+  monitor_engine = peas_engine_new ();
+  peas_engine_set_monitor_search_paths (monitor_engine, TRUE);
+
+  /* The first search path overrides the second one */
+  peas_engine_add_search_path (monitor_engine, user_dir, NULL);
+  peas_engine_add_search_path (monitor_engine, system_dir, NULL);
+  g_assert (wait_for_plugin_name (monitor_engine, "monitored", "User"));
+
+  /* Deleting the overriding plugin exposes the other one again */
+  g_assert_cmpint (g_unlink (user_filename), ==, 0);
+  g_assert (wait_for_plugin_name (monitor_engine, "monitored", "System"));
+
+  g_object_unref (monitor_engine);
+
+  g_unlink (system_filename);
+  g_rmdir (system_dir);
+  g_rmdir (user_dir);
+  g_free (system_filename);
+  g_free (user_filename);
+  g_free (system_dir);
+  g_free (user_dir);
+}
 
 static void
 test_engine_shutdown (void)
@@ -475,10 +1423,19 @@ main (int    argc,
   TEST ("unload-plugin-with-dep", unload_plugin_with_dep);
   TEST ("unload-plugin-with-self-dep", unload_plugin_with_self_dep);
 
+  TEST ("get-dependants", get_dependants);
+
   TEST ("unavailable-plugin", unavailable_plugin);
   TEST ("not-loadable-plugin", not_loadable_plugin);
 
   TEST ("loaded-plugins", loaded_plugins);
+  TEST ("loaded-plugins-batch", loaded_plugins_batch);
+  TEST ("parallel-load", parallel_load);
+  TEST ("parallel-load-prepare-thread", parallel_load_prepare_thread);
+  TEST ("lazy-load", lazy_load);
+  TEST ("lazy-load-failure", lazy_load_failure);
+  TEST ("declared-extensions", declared_extensions);
+  TEST ("plugin-timing", plugin_timing);
 
   TEST ("nonexistent-loader", nonexistent_loader);
   TEST ("disabled-loader", disabled_loader);
@@ -486,6 +1443,21 @@ main (int    argc,
 
   TEST ("nonexistent-search-path", nonexistent_search_path);
 
+  TEST ("plugin-cache", plugin_cache);
+  TEST ("plugin-cache-same-second", plugin_cache_same_second);
+  TEST ("parallel-scan", parallel_scan);
+  TEST ("add-search-path-async", add_search_path_async);
+  TEST ("rescan-plugins-async", rescan_plugins_async);
+  TEST ("load-plugin-async", load_plugin_async);
+  TEST ("monitor-search-paths", monitor_search_paths);
+  TEST ("monitor-search-paths-override", monitor_search_paths_override);
+
+  /* Only run with -m perf, the caches are only dropped where
+   * posix_fadvise() is available
+   */
+  if (g_test_perf ())
+    TEST ("parallel-load-benchmark", parallel_load_benchmark);
+
   /* MUST be last */
   TEST_FUNC ("shutdown", shutdown);
 
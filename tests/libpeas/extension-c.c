@@ -23,10 +23,20 @@
 #include <config.h>
 #endif
 
+#include <stdlib.h>
+
 #include "libpeas/peas.h"
+#include "libpeas/peas-introspection.h"
+#include "libpeas/peas-extension-subclasses.h"
+#include "libpeas/peas-extension-wrapper.h"
+#include "libpeas/peas-debug.h"
 
 #include "testing/testing-extension.h"
 #include "introspection/introspection-base.h"
+#include "introspection/introspection-callable.h"
+#include "introspection/introspection-calls.h"
+
+#define N_BENCHMARK_CALLS 100000
 
 static void
 test_extension_c_instance_refcount (PeasEngine     *engine,
@@ -61,6 +71,377 @@ test_extension_c_nonexistent (PeasEngine *engine)
   g_assert (!peas_engine_load_plugin (engine, info));
 }
 
+static void
+test_extension_c_method_info_cache (PeasEngine     *engine,
+                                    PeasPluginInfo *info)
+{
+  GICallableInfo *method_info1, *method_info2;
+
+  method_info1 = peas_gi_get_method_info (INTROSPECTION_TYPE_CALLABLE,
+                                          "call_no_args");
+  method_info2 = peas_gi_get_method_info (INTROSPECTION_TYPE_CALLABLE,
+                                          "call_no_args");
+
+  g_assert (method_info1 != NULL);
+  g_assert (method_info1 == method_info2);
+  g_assert_cmpstr (g_base_info_get_name (method_info1), ==, "call_no_args");
+
+  g_base_info_unref (method_info1);
+  g_base_info_unref (method_info2);
+
+  /* Missing methods are cached too */
+  g_assert (peas_gi_get_method_info (INTROSPECTION_TYPE_CALLABLE,
+                                     "does_not_exist") == NULL);
+  g_assert (peas_gi_get_method_info (INTROSPECTION_TYPE_CALLABLE,
+                                     "does_not_exist") == NULL);
+}
+
+static void
+test_extension_c_instance_method_cache (PeasEngine     *engine,
+                                        PeasPluginInfo *info)
+{
+  PeasExtension *extension;
+  const PeasPluginInfo *plugin_info = NULL;
+  GType interface = G_TYPE_INVALID;
+
+  extension = peas_engine_create_extension (engine, info,
+                                            INTROSPECTION_TYPE_CALLABLE,
+                                            NULL);
+
+  g_assert (peas_gi_lookup_instance_method (G_TYPE_FROM_INSTANCE (extension),
+                                            "get_plugin_info",
+                                            &interface) == NULL);
+
+  /* Not a method of the extension type, it is
+   * found in the other interfaces of the instance
+   */
+  g_assert (peas_extension_call (extension, "get_plugin_info", &plugin_info));
+  g_assert (plugin_info == info);
+
+  g_assert (peas_gi_lookup_instance_method (G_TYPE_FROM_INSTANCE (extension),
+                                            "get_plugin_info",
+                                            &interface) ==
+            peas_gi_get_method_signature (INTROSPECTION_TYPE_BASE,
+                                          "get_plugin_info"));
+  g_assert (interface == INTROSPECTION_TYPE_BASE);
+
+  /* The next call uses the cached interface */
+  plugin_info = NULL;
+  g_assert (peas_extension_call (extension, "get_plugin_info", &plugin_info));
+  g_assert (plugin_info == info);
+
+  g_object_unref (extension);
+}
+
+static void
+test_extension_c_direct_call (PeasEngine     *engine,
+                              PeasPluginInfo *info)
+{
+  PeasExtension *extension;
+  const gchar *return_val = NULL;
+  gboolean called = FALSE;
+  gint in = 1, out = 2, inout = 3;
+
+#define GET_SIGNATURE(method_name) \
+  peas_gi_get_method_signature (INTROSPECTION_TYPE_CALLABLE, method_name)
+
+  g_assert (GET_SIGNATURE ("call_no_args")->direct_call != NULL);
+  g_assert (GET_SIGNATURE ("call_with_return")->direct_call != NULL);
+  g_assert (GET_SIGNATURE ("call_single_arg")->direct_call != NULL);
+
+  /* Too many arguments, these go through libffi */
+  g_assert (GET_SIGNATURE ("call_multi_args")->direct_call == NULL);
+  g_assert (GET_SIGNATURE ("call_many_args")->direct_call == NULL);
+
+#undef GET_SIGNATURE
+
+  extension = peas_engine_create_extension (engine, info,
+                                            INTROSPECTION_TYPE_CALLABLE,
+                                            NULL);
+
+  introspection_reset_calls ();
+
+  /* The trampolines call the vfuncs without the invokers */
+  g_assert (peas_extension_call (extension, "call_with_return", &return_val));
+  g_assert_cmpstr (return_val, ==, "Hello, World!");
+  g_assert_cmpuint (introspection_get_n_calls ("extension-c"), ==, 1);
+  g_assert_cmpuint (introspection_get_n_calls ("invoker"), ==, 0);
+
+  g_assert (peas_extension_call (extension, "call_single_arg", &called));
+  g_assert (called);
+  g_assert_cmpuint (introspection_get_n_calls ("extension-c"), ==, 2);
+  g_assert_cmpuint (introspection_get_n_calls ("invoker"), ==, 0);
+
+  /* While the other methods still go through them */
+  g_assert (peas_extension_call (extension, "call_multi_args",
+                                 in, &out, &inout));
+  g_assert_cmpint (out, ==, 3);
+  g_assert_cmpint (inout, ==, 1);
+  g_assert_cmpuint (introspection_get_n_calls ("extension-c"), ==, 3);
+  g_assert_cmpuint (introspection_get_n_calls ("invoker"), ==, 1);
+
+  g_object_unref (extension);
+}
+
+static void
+valist_to_arguments (PeasGISignature *signature,
+                     gboolean         use_signature,
+                     GIArgument      *arguments,
+                     ...)
+{
+  va_list va_args;
+
+  va_start (va_args, arguments);
+
+  if (use_signature)
+    peas_gi_signature_valist_to_arguments (signature, va_args,
+                                           arguments, NULL);
+  else
+    peas_gi_valist_to_arguments (signature->callable_info, va_args,
+                                 arguments, NULL);
+
+  va_end (va_args);
+}
+
+static void
+test_extension_c_valist_signature (PeasEngine     *engine,
+                                   PeasPluginInfo *info)
+{
+  PeasGISignature *signature;
+  GIArgument arguments[2][8];
+  gint out, inout;
+  guint i;
+
+  signature = peas_gi_get_method_signature (INTROSPECTION_TYPE_CALLABLE,
+                                            "call_many_args");
+
+  g_assert (signature != NULL);
+  g_assert_cmpuint (signature->n_args, ==, 8);
+  g_assert_cmpuint (signature->n_in_args, ==, 7);
+  g_assert_cmpuint (signature->n_out_args, ==, 2);
+
+  for (i = 0; i < 2; ++i)
+    {
+      valist_to_arguments (signature, i == 1, arguments[i],
+                           42, &out, &inout, TRUE, 0.5, "a-string",
+                           G_TYPE_OBJECT, G_GINT64_CONSTANT (1) << 40);
+    }
+
+  /* Both paths must agree */
+  for (i = 0; i < 2; ++i)
+    {
+      g_assert_cmpint (arguments[i][0].v_int32, ==, 42);
+      g_assert (arguments[i][1].v_pointer == &out);
+      g_assert (arguments[i][2].v_pointer == &inout);
+      g_assert (arguments[i][3].v_boolean);
+      g_assert_cmpfloat (arguments[i][4].v_double, ==, 0.5);
+      g_assert_cmpstr (arguments[i][5].v_string, ==, "a-string");
+      g_assert_cmpuint (arguments[i][6].v_size, ==, G_TYPE_OBJECT);
+      g_assert_cmpint (arguments[i][7].v_int64, ==, G_GINT64_CONSTANT (1) << 40);
+    }
+}
+
+static gpointer
+ref_proxy_class (GType *interfaces)
+{
+  GType proxy_type;
+  guint i;
+
+  /* The proxy class overrides the properties of the interfaces */
+  for (i = 0; interfaces[i] != G_TYPE_INVALID; ++i)
+    g_type_default_interface_ref (interfaces[i]);
+
+  proxy_type = peas_extension_register_subclass (PEAS_TYPE_EXTENSION_WRAPPER,
+                                                 interfaces);
+
+  return g_type_class_ref (proxy_type);
+}
+
+static void
+test_extension_c_trampoline_slots (PeasEngine *engine)
+{
+  GType activatable_types[] = { PEAS_TYPE_ACTIVATABLE, G_TYPE_INVALID };
+  GType both_types[] = {
+    PEAS_TYPE_ACTIVATABLE, INTROSPECTION_TYPE_CALLABLE, G_TYPE_INVALID
+  };
+  gpointer klass;
+  PeasActivatableInterface *activatable_iface;
+  IntrospectionCallableInterface *callable_iface;
+
+  klass = ref_proxy_class (activatable_types);
+  activatable_iface = g_type_interface_peek (klass, PEAS_TYPE_ACTIVATABLE);
+
+  /* void (*) (Self *) methods get a trampoline, one per slot */
+  g_assert (peas_extension_subclass_is_trampoline (activatable_iface->activate));
+  g_assert (peas_extension_subclass_is_trampoline (activatable_iface->deactivate));
+  g_assert (peas_extension_subclass_is_trampoline (activatable_iface->update_state));
+  g_assert (activatable_iface->activate != activatable_iface->deactivate);
+  g_assert (activatable_iface->deactivate != activatable_iface->update_state);
+
+  g_type_class_unref (klass);
+
+  klass = ref_proxy_class (both_types);
+  activatable_iface = g_type_interface_peek (klass, PEAS_TYPE_ACTIVATABLE);
+  callable_iface = g_type_interface_peek (klass, INTROSPECTION_TYPE_CALLABLE);
+
+  /* Too many arguments for any trampoline */
+  g_assert (callable_iface->call_many_args != NULL);
+  g_assert (!peas_extension_subclass_is_trampoline (callable_iface->call_many_args));
+
+  /* update_state() and call_no_args() are both the third vfunc
+   * and take no arguments, only the interface initialized first
+   * gets the trampoline, the other one uses its libffi closure
+   */
+  g_assert (activatable_iface->update_state != NULL);
+  g_assert (callable_iface->call_no_args != NULL);
+  g_assert ((gpointer) activatable_iface->update_state !=
+            (gpointer) callable_iface->call_no_args);
+  g_assert (peas_extension_subclass_is_trampoline (activatable_iface->update_state) !=
+            peas_extension_subclass_is_trampoline (callable_iface->call_no_args));
+
+  g_type_class_unref (klass);
+}
+
+static gdouble
+time_valist_to_arguments (PeasGISignature *signature,
+                          gboolean         use_signature)
+{
+  GIArgument arguments[8];
+  gint out, inout;
+  guint i;
+
+  g_test_timer_start ();
+
+  /* Methods with fewer arguments only read the first ones */
+  for (i = 0; i < N_BENCHMARK_CALLS; ++i)
+    {
+      valist_to_arguments (signature, use_signature, arguments,
+                           42, &out, &inout, TRUE, 0.5, "a-string",
+                           G_TYPE_OBJECT, G_GINT64_CONSTANT (1) << 40);
+    }
+
+  return g_test_timer_elapsed () * G_USEC_PER_SEC / N_BENCHMARK_CALLS;
+}
+
+static void
+test_extension_c_valist_benchmark (PeasEngine     *engine,
+                                   PeasPluginInfo *info)
+{
+  static const gchar *method_names[] = {
+    "call_no_args", "call_multi_args", "call_many_args"
+  };
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (method_names); ++i)
+    {
+      PeasGISignature *signature;
+      gdouble uncached, with_signature;
+
+      signature = peas_gi_get_method_signature (INTROSPECTION_TYPE_CALLABLE,
+                                                method_names[i]);
+
+      uncached = time_valist_to_arguments (signature, FALSE);
+      with_signature = time_valist_to_arguments (signature, TRUE);
+
+      g_test_minimized_result (with_signature,
+                               "%s (%u args): %.3f us from the typelib, "
+                               "%.3f us with the signature",
+                               method_names[i], signature->n_args,
+                               uncached, with_signature);
+    }
+}
+
+static void
+test_extension_c_call_benchmark (PeasEngine     *engine,
+                                 PeasPluginInfo *info)
+{
+  PeasExtension *extension;
+  gdouble elapsed;
+  guint i;
+
+  extension = peas_engine_create_extension (engine, info,
+                                            INTROSPECTION_TYPE_CALLABLE,
+                                            NULL);
+
+  /* Warm up the method lookup */
+  g_assert (peas_extension_call (extension, "call_no_args"));
+
+  g_test_timer_start ();
+
+  for (i = 0; i < N_BENCHMARK_CALLS; ++i)
+    peas_extension_call (extension, "call_no_args");
+
+  elapsed = g_test_timer_elapsed ();
+
+  g_test_minimized_result (elapsed * G_USEC_PER_SEC / N_BENCHMARK_CALLS,
+                           "peas_extension_call(): %.3f us per call",
+                           elapsed * G_USEC_PER_SEC / N_BENCHMARK_CALLS);
+
+  g_object_unref (extension);
+}
+
+static void
+test_extension_c_debug_benchmark (PeasEngine     *engine,
+                                  PeasPluginInfo *info)
+{
+  guint i;
+
+  /* The engine already enabled the messages for the whole process */
+  if (g_getenv ("PEAS_DEBUG") != NULL)
+    {
+      g_test_message ("Unset PEAS_DEBUG to compare with the messages enabled");
+      return;
+    }
+
+  /* peas_debug_init() can only enable the messages, so each
+   * measurement runs in its own process. The messages still go to
+   * the handler installed by the engine, which drops them, so only
+   * their cost in peas_extension_call() is measured.
+   */
+  for (i = 0; i < 2; ++i)
+    {
+      gboolean debug = i == 1;
+
+      if (g_test_trap_fork (0, 0))
+        {
+          PeasExtension *extension;
+          gdouble elapsed;
+          guint j;
+
+          if (debug)
+            {
+              g_setenv ("PEAS_DEBUG", "1", TRUE);
+              peas_debug_init ();
+            }
+
+          extension = peas_engine_create_extension (engine, info,
+                                                    INTROSPECTION_TYPE_CALLABLE,
+                                                    NULL);
+
+          /* Warm up the method lookup */
+          g_assert (peas_extension_call (extension, "call_no_args"));
+
+          g_test_timer_start ();
+
+          for (j = 0; j < N_BENCHMARK_CALLS; ++j)
+            peas_extension_call (extension, "call_no_args");
+
+          elapsed = g_test_timer_elapsed ();
+
+          g_test_minimized_result (elapsed * G_USEC_PER_SEC / N_BENCHMARK_CALLS,
+                                   "peas_extension_call() with PEAS_DEBUG %s: "
+                                   "%.3f us per call",
+                                   debug ? "set" : "unset",
+                                   elapsed * G_USEC_PER_SEC / N_BENCHMARK_CALLS);
+
+          g_object_unref (extension);
+          exit (0);
+        }
+
+      g_test_trap_assert_passed ();
+    }
+}
+
 int
 main (int   argc,
       char *argv[])
@@ -78,6 +459,19 @@ main (int   argc,
 
   EXTENSION_TEST (c, "instance-refcount", instance_refcount);
   EXTENSION_TEST (c, "nonexistent", nonexistent);
+  EXTENSION_TEST (c, "method-info-cache", method_info_cache);
+  EXTENSION_TEST (c, "instance-method-cache", instance_method_cache);
+  EXTENSION_TEST (c, "valist-signature", valist_signature);
+  EXTENSION_TEST (c, "direct-call", direct_call);
+  EXTENSION_TEST (c, "trampoline-slots", trampoline_slots);
+
+  /* Only run with -m perf */
+  if (g_test_perf ())
+    {
+      EXTENSION_TEST (c, "call-benchmark", call_benchmark);
+      EXTENSION_TEST (c, "debug-benchmark", debug_benchmark);
+      EXTENSION_TEST (c, "valist-benchmark", valist_benchmark);
+    }
 
   return testing_extension_run_tests ();
 }
@@ -29,6 +29,8 @@
 #include <libpeas/peas.h>
 
 #include "testing/testing.h"
+#include "introspection/introspection-callable.h"
+#include "introspection/introspection-calls.h"
 
 typedef struct _TestFixture TestFixture;
 
@@ -169,6 +171,49 @@ test_extension_set_activate (PeasEngine *engine)
   g_assert_cmpint (active, ==, 0);
 }
 
+static void
+test_extension_set_lazy_load (PeasEngine *engine)
+{
+  PeasPluginInfo *info, *dep_info;
+  PeasExtensionSet *extension_set, *callable_set;
+  const gchar *load_plugins[] = { "loadable", NULL };
+  const gchar *load_more_plugins[] = { "loadable", "has-dep", NULL };
+
+  peas_engine_set_lazy_load (engine, TRUE);
+  peas_engine_set_loaded_plugins (engine, load_plugins);
+
+  info = peas_engine_get_plugin_info (engine, "loadable");
+  g_assert (!peas_plugin_info_is_loaded (info));
+
+  /* The plugin declares its types, a set for another type loads nothing */
+  callable_set = peas_extension_set_new (engine,
+                                         INTROSPECTION_TYPE_CALLABLE,
+                                         NULL);
+
+  g_assert (!peas_plugin_info_is_loaded (info));
+  g_assert (peas_engine_is_plugin_deferred (engine, info));
+
+  /* Creating the set loads the deferred plugins */
+  extension_set = peas_extension_set_new (engine,
+                                          PEAS_TYPE_ACTIVATABLE,
+                                          "object", NULL,
+                                          NULL);
+
+  g_assert (peas_plugin_info_is_loaded (info));
+  g_assert (peas_extension_set_get_extension (extension_set, info) != NULL);
+
+  /* And so does enabling more plugins while the set exists */
+  peas_engine_set_loaded_plugins (engine, load_more_plugins);
+
+  dep_info = peas_engine_get_plugin_info (engine, "has-dep");
+  g_assert (peas_plugin_info_is_loaded (dep_info));
+  g_assert (peas_extension_set_get_extension (extension_set,
+                                              dep_info) != NULL);
+
+  g_object_unref (extension_set);
+  g_object_unref (callable_set);
+}
+
 static void
 test_extension_set_deactivate (PeasEngine *engine)
 {
@@ -245,6 +290,165 @@ test_extension_set_call_valid (PeasEngine *engine)
   g_object_unref (extension_set);
 }
 
+static void
+test_extension_set_call_method (PeasEngine *engine)
+{
+  PeasExtensionSet *extension_set;
+  PeasExtensionMethod *method;
+
+  test_extension_set_activate (engine);
+
+  extension_set = peas_extension_set_new (engine,
+                                          PEAS_TYPE_ACTIVATABLE,
+                                          "object", NULL,
+                                          NULL);
+
+  method = peas_extension_method_new (PEAS_TYPE_ACTIVATABLE, "activate");
+
+  g_assert (peas_extension_set_call_method (extension_set, method));
+  g_assert (peas_extension_set_call_method (extension_set, method));
+
+  peas_extension_method_unref (method);
+  g_object_unref (extension_set);
+}
+
+/* Loaded in this order, so that extension-c comes first */
+static const gchar *callable_plugins[] = {
+  "callable", "extension-c"
+};
+
+static void
+load_callable_plugins (PeasEngine *engine)
+{
+  gint i;
+
+  for (i = 0; i < G_N_ELEMENTS (callable_plugins); ++i)
+    {
+      PeasPluginInfo *info;
+
+      info = peas_engine_get_plugin_info (engine, callable_plugins[i]);
+      g_assert (peas_engine_load_plugin (engine, info));
+    }
+}
+
+static void
+test_extension_set_call_collect (PeasEngine *engine)
+{
+  PeasExtensionSet *extension_set;
+  PeasExtensionMethod *method;
+  PeasExtensionSetResult *result;
+  GArray *results;
+
+  load_callable_plugins (engine);
+
+  extension_set = peas_extension_set_new (engine,
+                                          INTROSPECTION_TYPE_CALLABLE,
+                                          NULL);
+
+  method = peas_extension_method_new (INTROSPECTION_TYPE_CALLABLE,
+                                      "call_with_return");
+
+  introspection_reset_calls ();
+
+  results = peas_extension_set_call_collect (extension_set, method);
+  g_assert_cmpuint (results->len, ==, 2);
+
+  /* In the same order as peas_extension_set_foreach() */
+  result = &g_array_index (results, PeasExtensionSetResult, 0);
+  g_assert (result->success);
+  g_assert (result->info == peas_engine_get_plugin_info (engine, "extension-c"));
+  g_assert (result->exten ==
+            peas_extension_set_get_extension (extension_set, result->info));
+  g_assert_cmpstr (result->return_value.v_string, ==, "Hello, World!");
+
+  result = &g_array_index (results, PeasExtensionSetResult, 1);
+  g_assert (result->success);
+  g_assert (result->info == peas_engine_get_plugin_info (engine, "callable"));
+  g_assert (result->exten ==
+            peas_extension_set_get_extension (extension_set, result->info));
+  g_assert_cmpstr (result->return_value.v_string, ==, "Hello, Callable!");
+
+  g_assert_cmpuint (introspection_get_n_calls ("extension-c"), ==, 1);
+  g_assert_cmpuint (introspection_get_n_calls ("callable"), ==, 1);
+
+  g_array_unref (results);
+  peas_extension_method_unref (method);
+  g_object_unref (extension_set);
+}
+
+static void
+test_extension_set_call_short_circuit (PeasEngine *engine)
+{
+  PeasPluginInfo *info;
+  PeasExtensionSet *extension_set;
+  PeasExtensionMethod *method;
+  const gchar *str = NULL;
+
+  load_callable_plugins (engine);
+
+  extension_set = peas_extension_set_new (engine,
+                                          INTROSPECTION_TYPE_CALLABLE,
+                                          NULL);
+
+  method = peas_extension_method_new (INTROSPECTION_TYPE_CALLABLE,
+                                      "call_with_return");
+
+  /* The first extension returns a value, the second one is skipped */
+  introspection_reset_calls ();
+  g_assert (peas_extension_set_call_first_non_null (extension_set, method,
+                                                    &str));
+  g_assert_cmpstr (str, ==, "Hello, World!");
+  g_assert_cmpuint (introspection_get_n_calls ("extension-c"), ==, 1);
+  g_assert_cmpuint (introspection_get_n_calls ("callable"), ==, 0);
+
+  peas_extension_method_unref (method);
+
+  method = peas_extension_method_new (INTROSPECTION_TYPE_CALLABLE,
+                                      "call_with_boolean_return");
+
+  introspection_reset_calls ();
+  g_assert (peas_extension_set_call_any_true (extension_set, method, TRUE));
+  g_assert_cmpuint (introspection_get_n_calls ("extension-c"), ==, 1);
+  g_assert_cmpuint (introspection_get_n_calls ("callable"), ==, 0);
+
+  introspection_reset_calls ();
+  g_assert (!peas_extension_set_call_any_true (extension_set, method, FALSE));
+  g_assert_cmpuint (introspection_get_n_calls ("extension-c"), ==, 1);
+  g_assert_cmpuint (introspection_get_n_calls ("callable"), ==, 1);
+
+  introspection_reset_calls ();
+  g_assert (!peas_extension_set_call_all_true (extension_set, method, FALSE));
+  g_assert_cmpuint (introspection_get_n_calls ("extension-c"), ==, 1);
+  g_assert_cmpuint (introspection_get_n_calls ("callable"), ==, 0);
+
+  introspection_reset_calls ();
+  g_assert (peas_extension_set_call_all_true (extension_set, method, TRUE));
+  g_assert_cmpuint (introspection_get_n_calls ("extension-c"), ==, 1);
+  g_assert_cmpuint (introspection_get_n_calls ("callable"), ==, 1);
+
+  peas_extension_method_unref (method);
+  g_object_unref (extension_set);
+
+  /* Without any extension nothing can be found, but all are TRUE */
+  extension_set = peas_extension_set_new (engine,
+                                          INTROSPECTION_TYPE_CALLABLE,
+                                          NULL);
+
+  info = peas_engine_get_plugin_info (engine, "callable");
+  g_assert (peas_engine_unload_plugin (engine, info));
+  info = peas_engine_get_plugin_info (engine, "extension-c");
+  g_assert (peas_engine_unload_plugin (engine, info));
+
+  method = peas_extension_method_new (INTROSPECTION_TYPE_CALLABLE,
+                                      "call_with_boolean_return");
+
+  g_assert (!peas_extension_set_call_any_true (extension_set, method, TRUE));
+  g_assert (peas_extension_set_call_all_true (extension_set, method, FALSE));
+
+  peas_extension_method_unref (method);
+  g_object_unref (extension_set);
+}
+
 static void
 test_extension_set_call_invalid (PeasEngine *engine)
 {
@@ -286,6 +490,274 @@ test_extension_set_foreach (PeasEngine *engine)
   g_object_unref (extension_set);
 }
 
+static void
+count_extensions_cb (PeasExtensionSet *extension_set,
+                     PeasPluginInfo   *info,
+                     PeasExtension    *extension,
+                     gint             *count)
+{
+  g_assert (peas_extension_set_get_extension (extension_set,
+                                              info) == extension);
+
+  g_atomic_int_inc (count);
+}
+
+static void
+test_extension_set_foreach_parallel (PeasEngine *engine)
+{
+  PeasExtensionSet *extension_set;
+  gint count = 0;
+
+  test_extension_set_activate (engine);
+
+  extension_set = peas_extension_set_new (engine,
+                                          PEAS_TYPE_ACTIVATABLE,
+                                          "object", NULL,
+                                          NULL);
+
+  peas_extension_set_foreach_parallel (extension_set,
+                                       (PeasExtensionSetForeachFunc) count_extensions_cb,
+                                       &count);
+
+  g_assert_cmpint (count, ==, G_N_ELEMENTS (loadable_plugins));
+
+  g_object_unref (extension_set);
+}
+
+static void
+collect_infos_cb (PeasExtensionSet *extension_set,
+                  PeasPluginInfo   *info,
+                  PeasExtension    *extension,
+                  GPtrArray        *infos)
+{
+  g_ptr_array_add (infos, info);
+}
+
+static void
+test_extension_set_foreach_order (PeasEngine *engine)
+{
+  gint i;
+  PeasPluginInfo *info;
+  PeasExtensionSet *extension_set;
+  GPtrArray *infos;
+
+  extension_set = peas_extension_set_new (engine,
+                                          PEAS_TYPE_ACTIVATABLE,
+                                          "object", NULL,
+                                          NULL);
+
+  for (i = 0; i < G_N_ELEMENTS (loadable_plugins); ++i)
+    {
+      info = peas_engine_get_plugin_info (engine, loadable_plugins[i]);
+      g_assert (peas_engine_load_plugin (engine, info));
+    }
+
+  /* The most recently added extension comes first */
+  infos = g_ptr_array_new ();
+  peas_extension_set_foreach (extension_set,
+                              (PeasExtensionSetForeachFunc) collect_infos_cb,
+                              infos);
+
+  g_assert_cmpuint (infos->len, ==, 3);
+  g_assert (g_ptr_array_index (infos, 0) ==
+            peas_engine_get_plugin_info (engine, "self-dep"));
+  g_assert (g_ptr_array_index (infos, 1) ==
+            peas_engine_get_plugin_info (engine, "has-dep"));
+  g_assert (g_ptr_array_index (infos, 2) ==
+            peas_engine_get_plugin_info (engine, "loadable"));
+
+  /* Removing an extension keeps the order of the others */
+  info = peas_engine_get_plugin_info (engine, "has-dep");
+  g_assert (peas_engine_unload_plugin (engine, info));
+  g_assert (peas_extension_set_get_extension (extension_set, info) == NULL);
+
+  g_ptr_array_set_size (infos, 0);
+  peas_extension_set_foreach (extension_set,
+                              (PeasExtensionSetForeachFunc) collect_infos_cb,
+                              infos);
+
+  g_assert_cmpuint (infos->len, ==, 2);
+  g_assert (g_ptr_array_index (infos, 0) ==
+            peas_engine_get_plugin_info (engine, "self-dep"));
+  g_assert (g_ptr_array_index (infos, 1) ==
+            peas_engine_get_plugin_info (engine, "loadable"));
+
+  for (i = 0; i < infos->len; ++i)
+    g_assert (peas_extension_set_get_extension (extension_set,
+                                                g_ptr_array_index (infos, i)) != NULL);
+
+  g_ptr_array_unref (infos);
+  g_object_unref (extension_set);
+}
+
+static void
+unload_loadable_cb (PeasExtensionSet *extension_set,
+                    PeasPluginInfo   *info,
+                    PeasExtension    *extension,
+                    GPtrArray        *infos)
+{
+  PeasEngine *engine;
+  PeasPluginInfo *loadable_info;
+
+  g_assert (PEAS_IS_ACTIVATABLE (extension));
+  g_ptr_array_add (infos, info);
+
+  if (infos->len != 1)
+    return;
+
+  g_object_get (extension_set, "engine", &engine, NULL);
+
+  /* Also unloads has-dep, which depends on it */
+  loadable_info = peas_engine_get_plugin_info (engine, "loadable");
+  g_assert (peas_engine_unload_plugin (engine, loadable_info));
+
+  g_object_unref (engine);
+}
+
+static void
+test_extension_set_foreach_unload (PeasEngine *engine)
+{
+  gint i;
+  PeasPluginInfo *info;
+  PeasExtensionSet *extension_set;
+  GPtrArray *infos;
+
+  extension_set = peas_extension_set_new (engine,
+                                          PEAS_TYPE_ACTIVATABLE,
+                                          "object", NULL,
+                                          NULL);
+
+  for (i = 0; i < G_N_ELEMENTS (loadable_plugins); ++i)
+    {
+      info = peas_engine_get_plugin_info (engine, loadable_plugins[i]);
+      g_assert (peas_engine_load_plugin (engine, info));
+    }
+
+  /* The extensions removed by the first call are still
+   * visited, and none of them is visited twice
+   */
+  infos = g_ptr_array_new ();
+  peas_extension_set_foreach (extension_set,
+                              (PeasExtensionSetForeachFunc) unload_loadable_cb,
+                              infos);
+
+  g_assert_cmpuint (infos->len, ==, 3);
+  g_assert (g_ptr_array_index (infos, 0) ==
+            peas_engine_get_plugin_info (engine, "self-dep"));
+  g_assert (g_ptr_array_index (infos, 1) ==
+            peas_engine_get_plugin_info (engine, "has-dep"));
+  g_assert (g_ptr_array_index (infos, 2) ==
+            peas_engine_get_plugin_info (engine, "loadable"));
+
+  g_assert (peas_extension_set_get_extension (extension_set,
+                                              g_ptr_array_index (infos, 0)) != NULL);
+  g_assert (peas_extension_set_get_extension (extension_set,
+                                              g_ptr_array_index (infos, 1)) == NULL);
+  g_assert (peas_extension_set_get_extension (extension_set,
+                                              g_ptr_array_index (infos, 2)) == NULL);
+
+  g_ptr_array_unref (infos);
+  g_object_unref (extension_set);
+}
+
+static void
+collect_info_cb (PeasExtensionSet *extension_set,
+                 PeasPluginInfo   *info,
+                 PeasExtension    *extension,
+                 GPtrArray        *infos)
+{
+  g_ptr_array_add (infos, info);
+}
+
+static void
+unload_nested_cb (PeasExtensionSet *extension_set,
+                  PeasPluginInfo   *info,
+                  PeasExtension    *extension,
+                  GPtrArray        *infos)
+{
+  PeasEngine *engine;
+  PeasPluginInfo *loadable_info;
+  GPtrArray *nested_infos;
+
+  g_ptr_array_add (infos, info);
+
+  if (infos->len != 1)
+    return;
+
+  g_object_get (extension_set, "engine", &engine, NULL);
+
+  /* Also unloads has-dep, which depends on it */
+  loadable_info = peas_engine_get_plugin_info (engine, "loadable");
+  g_assert (peas_engine_unload_plugin (engine, loadable_info));
+
+  /* The removed extensions are not visited by a new iteration */
+  nested_infos = g_ptr_array_new ();
+  peas_extension_set_foreach (extension_set,
+                              (PeasExtensionSetForeachFunc) collect_info_cb,
+                              nested_infos);
+
+  g_assert_cmpuint (nested_infos->len, ==, 1);
+  g_assert (g_ptr_array_index (nested_infos, 0) == info);
+  g_ptr_array_unref (nested_infos);
+
+  /* And the added ones are not visited by the running iterations */
+  g_assert (peas_engine_load_plugin (engine, loadable_info));
+
+  g_object_unref (engine);
+}
+
+static void
+test_extension_set_foreach_nested (PeasEngine *engine)
+{
+  gint i;
+  PeasPluginInfo *info;
+  PeasExtensionSet *extension_set;
+  GPtrArray *infos;
+
+  extension_set = peas_extension_set_new (engine,
+                                          PEAS_TYPE_ACTIVATABLE,
+                                          "object", NULL,
+                                          NULL);
+
+  for (i = 0; i < G_N_ELEMENTS (loadable_plugins); ++i)
+    {
+      info = peas_engine_get_plugin_info (engine, loadable_plugins[i]);
+      g_assert (peas_engine_load_plugin (engine, info));
+    }
+
+  infos = g_ptr_array_new ();
+  peas_extension_set_foreach (extension_set,
+                              (PeasExtensionSetForeachFunc) unload_nested_cb,
+                              infos);
+
+  g_assert_cmpuint (infos->len, ==, 3);
+  g_ptr_array_unref (infos);
+
+  /* The reloaded extension now comes first */
+  infos = g_ptr_array_new ();
+  peas_extension_set_foreach (extension_set,
+                              (PeasExtensionSetForeachFunc) collect_info_cb,
+                              infos);
+
+  g_assert_cmpuint (infos->len, ==, 2);
+  g_assert (g_ptr_array_index (infos, 0) ==
+            peas_engine_get_plugin_info (engine, "loadable"));
+  g_assert (g_ptr_array_index (infos, 1) ==
+            peas_engine_get_plugin_info (engine, "self-dep"));
+
+  for (i = 0; i < infos->len; ++i)
+    {
+      info = g_ptr_array_index (infos, i);
+      g_assert (peas_extension_set_get_extension (extension_set, info) != NULL);
+    }
+
+  info = peas_engine_get_plugin_info (engine, "has-dep");
+  g_assert (peas_extension_set_get_extension (extension_set, info) == NULL);
+
+  g_ptr_array_unref (infos);
+  g_object_unref (extension_set);
+}
+
 int
 main (int    argc,
       char **argv)
@@ -304,13 +776,21 @@ main (int    argc,
 
   TEST ("activate", activate);
   TEST ("deactivate", deactivate);
+  TEST ("lazy-load", lazy_load);
 
   TEST ("get-extension", get_extension);
 
   TEST ("call-valid", call_valid);
+  TEST ("call-method", call_method);
+  TEST ("call-collect", call_collect);
+  TEST ("call-short-circuit", call_short_circuit);
   TEST ("call-invalid", call_invalid);
 
   TEST ("foreach", foreach);
+  TEST ("foreach-order", foreach_order);
+  TEST ("foreach-unload", foreach_unload);
+  TEST ("foreach-nested", foreach_nested);
+  TEST ("foreach-parallel", foreach_parallel);
 
 #undef TEST
 
@@ -24,6 +24,7 @@
 #endif
 
 #include "introspection-callable.h"
+#include "introspection-calls.h"
 
 G_DEFINE_INTERFACE(IntrospectionCallable, introspection_callable, G_TYPE_OBJECT)
 
@@ -32,6 +33,10 @@ introspection_callable_default_init (IntrospectionCallableInterface *iface)
 {
 }
 
+/* libpeas calls the vfuncs of the C extensions directly, the
+ * calls made through the functions below are recorded as "invoker"
+ */
+
 /**
  * introspection_callable_call_with_return:
  * @callable:
@@ -45,6 +50,8 @@ introspection_callable_call_with_return (IntrospectionCallable *callable)
 
   g_return_val_if_fail (INTROSPECTION_IS_CALLABLE (callable), NULL);
 
+  introspection_record_call ("invoker");
+
   iface = INTROSPECTION_CALLABLE_GET_IFACE (callable);
   g_assert (iface->call_with_return != NULL);
 
@@ -62,6 +69,8 @@ introspection_callable_call_no_args (IntrospectionCallable *callable)
 
   g_return_if_fail (INTROSPECTION_IS_CALLABLE (callable));
 
+  introspection_record_call ("invoker");
+
   iface = INTROSPECTION_CALLABLE_GET_IFACE (callable);
   g_assert (iface->call_no_args != NULL);
 
@@ -81,6 +90,8 @@ introspection_callable_call_single_arg (IntrospectionCallable *callable,
 
   g_return_if_fail (INTROSPECTION_IS_CALLABLE (callable));
 
+  introspection_record_call ("invoker");
+
   iface = INTROSPECTION_CALLABLE_GET_IFACE (callable);
   g_assert (iface->call_single_arg != NULL);
 
@@ -104,8 +115,67 @@ introspection_callable_call_multi_args (IntrospectionCallable *callable,
 
   g_return_if_fail (INTROSPECTION_IS_CALLABLE (callable));
 
+  introspection_record_call ("invoker");
+
   iface = INTROSPECTION_CALLABLE_GET_IFACE (callable);
   g_assert (iface->call_multi_args != NULL);
 
   iface->call_multi_args (callable, in, out, inout);
 }
+
+/**
+ * introspection_callable_call_many_args:
+ * @callable:
+ * @in: (in):
+ * @out: (out):
+ * @inout: (inout):
+ * @a_boolean: (in):
+ * @a_double: (in):
+ * @a_string: (in):
+ * @a_gtype: (in):
+ * @an_int64: (in):
+ */
+void
+introspection_callable_call_many_args (IntrospectionCallable *callable,
+                                       gint                   in,
+                                       gint                  *out,
+                                       gint                  *inout,
+                                       gboolean               a_boolean,
+                                       gdouble                a_double,
+                                       const gchar           *a_string,
+                                       GType                  a_gtype,
+                                       gint64                 an_int64)
+{
+  IntrospectionCallableInterface *iface;
+
+  g_return_if_fail (INTROSPECTION_IS_CALLABLE (callable));
+
+  introspection_record_call ("invoker");
+
+  iface = INTROSPECTION_CALLABLE_GET_IFACE (callable);
+  g_assert (iface->call_many_args != NULL);
+
+  iface->call_many_args (callable, in, out, inout, a_boolean,
+                         a_double, a_string, a_gtype, an_int64);
+}
+
+/**
+ * introspection_callable_call_with_boolean_return:
+ * @callable:
+ * @in: (in):
+ */
+gboolean
+introspection_callable_call_with_boolean_return (IntrospectionCallable *callable,
+                                                 gboolean               in)
+{
+  IntrospectionCallableInterface *iface;
+
+  g_return_val_if_fail (INTROSPECTION_IS_CALLABLE (callable), FALSE);
+
+  introspection_record_call ("invoker");
+
+  iface = INTROSPECTION_CALLABLE_GET_IFACE (callable);
+  g_assert (iface->call_with_boolean_return != NULL);
+
+  return iface->call_with_boolean_return (callable, in);
+}
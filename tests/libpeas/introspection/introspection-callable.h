@@ -43,6 +43,9 @@ struct _IntrospectionCallableInterface {
 
   /* Virtual public methods */
   const gchar *(*call_with_return) (IntrospectionCallable *callable);
+  gboolean     (*call_with_boolean_return)
+                                   (IntrospectionCallable *callable,
+                                    gboolean               in);
   void         (*call_no_args)     (IntrospectionCallable *callable);
   void         (*call_single_arg)  (IntrospectionCallable *callable,
                                     gboolean              *called);
@@ -50,6 +53,15 @@ struct _IntrospectionCallableInterface {
                                     gint                   in,
                                     gint                  *out,
                                     gint                  *inout);
+  void         (*call_many_args)   (IntrospectionCallable *callable,
+                                    gint                   in,
+                                    gint                  *out,
+                                    gint                  *inout,
+                                    gboolean               a_boolean,
+                                    gdouble                a_double,
+                                    const gchar           *a_string,
+                                    GType                  a_gtype,
+                                    gint64                 an_int64);
 
   /* libpeas must have an invoker to implement an interface's vfunc */
   void         (*no_invoker_)      (IntrospectionCallable *callable);
@@ -69,6 +81,18 @@ void         introspection_callable_call_multi_args  (IntrospectionCallable *cal
                                                       gint                   in,
                                                       gint                  *out,
                                                       gint                  *inout);
+gboolean     introspection_callable_call_with_boolean_return
+                                                     (IntrospectionCallable *callable,
+                                                      gboolean               in);
+void         introspection_callable_call_many_args   (IntrospectionCallable *callable,
+                                                      gint                   in,
+                                                      gint                  *out,
+                                                      gint                  *inout,
+                                                      gboolean               a_boolean,
+                                                      gdouble                a_double,
+                                                      const gchar           *a_string,
+                                                      GType                  a_gtype,
+                                                      gint64                 an_int64);
 
 G_END_DECLS
 
@@ -0,0 +1,132 @@
+/*
+ * introspection-calls.c
+ * This file is part of libpeas
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Library General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "introspection-calls.h"
+
+/* The test plugins of every loader record their calls here,
+ * keyed by their module name, so the tests can check how many
+ * times and on which thread they were called
+ */
+typedef struct {
+  guint n_calls;
+  GThread *thread;
+} CallRecord;
+
+static GMutex calls_lock;
+static GHashTable *calls = NULL;
+
+static CallRecord *
+lookup_record (const gchar *name,
+               gboolean     create)
+{
+  CallRecord *record;
+
+  if (calls == NULL)
+    calls = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+
+  record = g_hash_table_lookup (calls, name);
+
+  if (record == NULL && create)
+    {
+      record = g_new0 (CallRecord, 1);
+      g_hash_table_insert (calls, g_strdup (name), record);
+    }
+
+  return record;
+}
+
+/**
+ * introspection_record_call:
+ * @name: the module name of the plugin being called.
+ */
+void
+introspection_record_call (const gchar *name)
+{
+  CallRecord *record;
+
+  g_mutex_lock (&calls_lock);
+
+  record = lookup_record (name, TRUE);
+  record->n_calls++;
+  record->thread = g_thread_self ();
+
+  g_mutex_unlock (&calls_lock);
+}
+
+/**
+ * introspection_get_n_calls:
+ * @name: the module name of a plugin.
+ *
+ * Returns: the number of calls recorded for @name.
+ */
+guint
+introspection_get_n_calls (const gchar *name)
+{
+  CallRecord *record;
+  guint n_calls;
+
+  g_mutex_lock (&calls_lock);
+
+  record = lookup_record (name, FALSE);
+  n_calls = record != NULL ? record->n_calls : 0;
+
+  g_mutex_unlock (&calls_lock);
+
+  return n_calls;
+}
+
+/**
+ * introspection_get_call_thread: (skip)
+ * @name: the module name of a plugin.
+ *
+ * Returns: the thread of the last call recorded for @name, or %NULL.
+ */
+GThread *
+introspection_get_call_thread (const gchar *name)
+{
+  CallRecord *record;
+  GThread *thread;
+
+  g_mutex_lock (&calls_lock);
+
+  record = lookup_record (name, FALSE);
+  thread = record != NULL ? record->thread : NULL;
+
+  g_mutex_unlock (&calls_lock);
+
+  return thread;
+}
+
+/**
+ * introspection_reset_calls:
+ */
+void
+introspection_reset_calls (void)
+{
+  g_mutex_lock (&calls_lock);
+
+  if (calls != NULL)
+    g_hash_table_remove_all (calls);
+
+  g_mutex_unlock (&calls_lock);
+}
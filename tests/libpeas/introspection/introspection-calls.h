@@ -0,0 +1,35 @@
+/*
+ * introspection-calls.h
+ * This file is part of libpeas
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Library General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __INTROSPECTION_CALLS_H__
+#define __INTROSPECTION_CALLS_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+void     introspection_record_call     (const gchar *name);
+
+guint    introspection_get_n_calls     (const gchar *name);
+GThread *introspection_get_call_thread (const gchar *name);
+void     introspection_reset_calls     (void);
+
+G_END_DECLS
+
+#endif /* __INTROSPECTION_CALLS_H__ */
@@ -79,6 +79,10 @@ test_plugin_info_verify_full_info (PeasEngine *engine)
   g_assert_cmpstr (peas_plugin_info_get_dependencies (info)[1], ==, "something-else");
   g_assert_cmpstr (peas_plugin_info_get_dependencies (info)[2], ==, NULL);
 
+  g_assert_cmpstr (peas_plugin_info_get_extensions (info)[0], ==, "PeasActivatable");
+  g_assert_cmpstr (peas_plugin_info_get_extensions (info)[1], ==, "IntrospectionCallable");
+  g_assert_cmpstr (peas_plugin_info_get_extensions (info)[2], ==, NULL);
+
   g_assert_cmpstr (peas_plugin_info_get_name (info), ==, "Full Info");
   g_assert_cmpstr (peas_plugin_info_get_description (info), ==, "Has full info.");
   g_assert_cmpstr (peas_plugin_info_get_icon_name (info), ==, "gtk-ok");
@@ -95,6 +99,24 @@ test_plugin_info_verify_full_info (PeasEngine *engine)
   g_assert_cmpstr (peas_plugin_info_get_external_data (info, "X-External"), ==, "external data");
 }
 
+static void
+test_plugin_info_verify_full_info_cached (PeasEngine *engine)
+{
+  PeasEngine *cached_engine;
+
+  /* The fixture's engine wrote the plugin cache, so
+   * this engine reads the plugin infos from the cache
+   */
+  cached_engine = peas_engine_new ();
+  peas_engine_add_search_path (cached_engine,
+                               BUILDDIR "/tests/plugins",
+                               SRCDIR   "/tests/plugins");
+
+  test_plugin_info_verify_full_info (cached_engine);
+
+  g_object_unref (cached_engine);
+}
+
 static void
 test_plugin_info_verify_min_info (PeasEngine *engine)
 {
@@ -114,6 +136,7 @@ test_plugin_info_verify_min_info (PeasEngine *engine)
   g_assert (g_str_has_suffix (peas_plugin_info_get_data_dir (info), "/tests/plugins/min-info"));
 
   g_assert_cmpstr (peas_plugin_info_get_dependencies (info)[0], ==, NULL);
+  g_assert (peas_plugin_info_get_extensions (info) == NULL);
 
   g_assert_cmpstr (peas_plugin_info_get_name (info), ==, "Min Info");
   g_assert_cmpstr (peas_plugin_info_get_description (info), ==, NULL);
@@ -190,6 +213,7 @@ main (int    argc,
               test_setup, test_runner, test_teardown)
 
   TEST ("verify-full-info", verify_full_info);
+  TEST ("verify-full-info-cached", verify_full_info_cached);
   TEST ("verify-min-info", verify_min_info);
 
   TEST ("has-dep", has_dep);
@@ -0,0 +1,148 @@
+/*
+ * callable-plugin.c
+ * This file is part of libpeas
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Library General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <glib.h>
+#include <glib-object.h>
+#include <gmodule.h>
+
+#include <libpeas/peas.h>
+
+#include "introspection-callable.h"
+#include "introspection-calls.h"
+
+#include "callable-plugin.h"
+
+static void introspection_callable_iface_init (IntrospectionCallableInterface *iface);
+
+G_DEFINE_DYNAMIC_TYPE_EXTENDED (TestingCallablePlugin,
+                                testing_callable_plugin,
+                                PEAS_TYPE_EXTENSION_BASE,
+                                0,
+                                G_IMPLEMENT_INTERFACE_DYNAMIC (INTROSPECTION_TYPE_CALLABLE,
+                                                               introspection_callable_iface_init))
+
+static void
+testing_callable_plugin_init (TestingCallablePlugin *plugin)
+{
+}
+
+static void
+record_call (IntrospectionCallable *callable)
+{
+  PeasPluginInfo *info;
+
+  info = peas_extension_base_get_plugin_info (PEAS_EXTENSION_BASE (callable));
+  introspection_record_call (peas_plugin_info_get_module_name (info));
+}
+
+static void
+testing_callable_plugin_call_no_args (IntrospectionCallable *callable)
+{
+  record_call (callable);
+}
+
+static const gchar *
+testing_callable_plugin_call_with_return (IntrospectionCallable *callable)
+{
+  record_call (callable);
+
+  return "Hello, Callable!";
+}
+
+static gboolean
+testing_callable_plugin_call_with_boolean_return (IntrospectionCallable *callable,
+                                                  gboolean               in)
+{
+  record_call (callable);
+
+  return in;
+}
+
+static void
+testing_callable_plugin_call_single_arg (IntrospectionCallable *callable,
+                                         gboolean              *called)
+{
+  record_call (callable);
+
+  *called = TRUE;
+}
+
+static void
+testing_callable_plugin_call_multi_args (IntrospectionCallable *callable,
+                                         gint                   in,
+                                         gint                  *out,
+                                         gint                  *inout)
+{
+  record_call (callable);
+
+  *out = *inout;
+  *inout = in;
+}
+
+static void
+testing_callable_plugin_call_many_args (IntrospectionCallable *callable,
+                                        gint                   in,
+                                        gint                  *out,
+                                        gint                  *inout,
+                                        gboolean               a_boolean,
+                                        gdouble                a_double,
+                                        const gchar           *a_string,
+                                        GType                  a_gtype,
+                                        gint64                 an_int64)
+{
+  record_call (callable);
+
+  *out = *inout;
+  *inout = in;
+}
+
+static void
+testing_callable_plugin_class_init (TestingCallablePluginClass *klass)
+{
+}
+
+static void
+introspection_callable_iface_init (IntrospectionCallableInterface *iface)
+{
+  iface->call_no_args = testing_callable_plugin_call_no_args;
+  iface->call_with_return = testing_callable_plugin_call_with_return;
+  iface->call_with_boolean_return = testing_callable_plugin_call_with_boolean_return;
+  iface->call_single_arg = testing_callable_plugin_call_single_arg;
+  iface->call_multi_args = testing_callable_plugin_call_multi_args;
+  iface->call_many_args = testing_callable_plugin_call_many_args;
+}
+
+static void
+testing_callable_plugin_class_finalize (TestingCallablePluginClass *klass)
+{
+}
+
+G_MODULE_EXPORT void
+peas_register_types (PeasObjectModule *module)
+{
+  testing_callable_plugin_register_type (G_TYPE_MODULE (module));
+
+  peas_object_module_register_extension_type (module,
+                                              INTROSPECTION_TYPE_CALLABLE,
+                                              TESTING_TYPE_CALLABLE_PLUGIN);
+}
@@ -31,6 +31,7 @@
 
 #include "introspection-base.h"
 #include "introspection-callable.h"
+#include "introspection-calls.h"
 #include "introspection-has-prerequisite.h"
 
 #include "extension-c-plugin.h"
@@ -71,21 +72,44 @@ testing_extension_c_plugin_get_settings (IntrospectionBase *base)
   return peas_plugin_info_get_settings (info, NULL);
 }
 
+static void
+record_call (IntrospectionCallable *callable)
+{
+  PeasPluginInfo *info;
+
+  info = peas_extension_base_get_plugin_info (PEAS_EXTENSION_BASE (callable));
+  introspection_record_call (peas_plugin_info_get_module_name (info));
+}
+
 static void
 testing_extension_c_plugin_call_no_args (IntrospectionCallable *callable)
 {
+  record_call (callable);
 }
 
 static const gchar *
 testing_extension_c_plugin_call_with_return (IntrospectionCallable *callable)
 {
+  record_call (callable);
+
   return "Hello, World!";
 }
 
+static gboolean
+testing_extension_c_plugin_call_with_boolean_return (IntrospectionCallable *callable,
+                                                     gboolean               in)
+{
+  record_call (callable);
+
+  return in;
+}
+
 static void
 testing_extension_c_plugin_call_single_arg (IntrospectionCallable *callable,
                                             gboolean              *called)
 {
+  record_call (callable);
+
   *called = TRUE;
 }
 
@@ -95,6 +119,25 @@ testing_extension_c_plugin_call_multi_args (IntrospectionCallable *callable,
                                             gint                  *out,
                                             gint                  *inout)
 {
+  record_call (callable);
+
+  *out = *inout;
+  *inout = in;
+}
+
+static void
+testing_extension_c_plugin_call_many_args (IntrospectionCallable *callable,
+                                           gint                   in,
+                                           gint                  *out,
+                                           gint                  *inout,
+                                           gboolean               a_boolean,
+                                           gdouble                a_double,
+                                           const gchar           *a_string,
+                                           GType                  a_gtype,
+                                           gint64                 an_int64)
+{
+  record_call (callable);
+
   *out = *inout;
   *inout = in;
 }
@@ -116,8 +159,10 @@ introspection_extension_c_iface_init (IntrospectionCallableInterface *iface)
 {
   iface->call_no_args = testing_extension_c_plugin_call_no_args;
   iface->call_with_return = testing_extension_c_plugin_call_with_return;
+  iface->call_with_boolean_return = testing_extension_c_plugin_call_with_boolean_return;
   iface->call_single_arg = testing_extension_c_plugin_call_single_arg;
   iface->call_multi_args = testing_extension_c_plugin_call_multi_args;
+  iface->call_many_args = testing_extension_c_plugin_call_many_args;
 }
 
 static void
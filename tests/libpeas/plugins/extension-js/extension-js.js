@@ -22,13 +22,21 @@ extension_js_plugin.prototype = {
   call_with_return: function() {
     return "Hello, World!";
   },
+  call_with_boolean_return: function(in_) {
+    return in_;
+  },
   call_no_args: function() {
+    Introspection.record_call(this.plugin_info.get_module_name());
   },
   call_single_arg: function() {
     return true;
   },
   call_multi_args: function(in_, inout) {
     return [ inout, in_ ];
+  },
+  call_many_args: function(in_, inout, a_boolean, a_double, a_string,
+                           a_gtype, an_int64) {
+    return [ inout, in_ ];
   }
 };
 
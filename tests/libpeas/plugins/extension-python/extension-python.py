@@ -34,11 +34,18 @@ class ExtensionPythonPlugin(GObject.Object, Peas.Activatable,
     def do_call_with_return(self):
         return "Hello, World!";
 
+    def do_call_with_boolean_return(self, in_):
+        return in_
+
     def do_call_no_args(self):
-        pass
+        Introspection.record_call(self.plugin_info.get_module_name())
 
     def do_call_single_arg(self):
         return True
 
     def do_call_multi_args(self, in_, inout):
         return (inout, in_)
+
+    def do_call_many_args(self, in_, inout, a_boolean, a_double, a_string,
+                          a_gtype, an_int64):
+        return (inout, in_)
@@ -35,6 +35,7 @@
 
 #include "introspection-base.h"
 #include "introspection-callable.h"
+#include "introspection-calls.h"
 #include "introspection-has-missing-prerequisite.h"
 #include "introspection-has-prerequisite.h"
 #include "introspection-properties.h"
@@ -382,6 +383,128 @@ test_extension_call_multi_args (PeasEngine     *engine,
   g_object_unref (extension);
 }
 
+static void
+test_extension_call_method (PeasEngine     *engine,
+                            PeasPluginInfo *info)
+{
+  PeasExtension *extension;
+  PeasExtensionMethod *method;
+  const gchar *return_val = NULL;
+  gint in, out, inout;
+  gint inout_saved;
+
+  extension = peas_engine_create_extension (engine, info,
+                                            INTROSPECTION_TYPE_CALLABLE,
+                                            NULL);
+
+  method = peas_extension_method_new (INTROSPECTION_TYPE_CALLABLE,
+                                      "call_with_return");
+  g_assert_cmpstr (peas_extension_method_get_name (method), ==,
+                   "call_with_return");
+
+  g_assert (peas_extension_method_call (method, extension, &return_val));
+  g_assert_cmpstr (return_val, ==, "Hello, World!");
+
+  peas_extension_method_unref (method);
+
+  method = peas_extension_method_new (INTROSPECTION_TYPE_CALLABLE,
+                                      "call_multi_args");
+
+  /* The same method can be called any number of times */
+  in = g_random_int ();
+  inout = g_random_int ();
+  inout_saved = inout;
+
+  g_assert (peas_extension_method_call (method, extension, in, &out, &inout));
+
+  g_assert_cmpint (inout_saved, ==, out);
+  g_assert_cmpint (in, ==, inout);
+
+  in = g_random_int ();
+  inout = g_random_int ();
+  inout_saved = inout;
+
+  g_assert (peas_extension_method_call (method, extension, in, &out, &inout));
+
+  g_assert_cmpint (inout_saved, ==, out);
+  g_assert_cmpint (in, ==, inout);
+
+  peas_extension_method_unref (method);
+
+  testing_util_push_log_hook ("Method 'IntrospectionCallable.invalid'*");
+
+  g_assert (peas_extension_method_new (INTROSPECTION_TYPE_CALLABLE,
+                                       "invalid") == NULL);
+
+  g_object_unref (extension);
+}
+
+static void
+test_extension_call_parallel (PeasEngine     *engine,
+                              PeasPluginInfo *info)
+{
+  PeasExtensionSet *extension_set;
+  PeasExtensionMethod *method;
+  const gchar *module_name;
+  gboolean called = FALSE;
+  guint i;
+  /* The pool is only used for more than one C extension */
+  const gchar *native_plugins[] = { "extension-c", "callable" };
+
+  for (i = 0; i < G_N_ELEMENTS (native_plugins); ++i)
+    {
+      PeasPluginInfo *native_info;
+
+      native_info = peas_engine_get_plugin_info (engine, native_plugins[i]);
+      g_assert (peas_engine_load_plugin (engine, native_info));
+    }
+
+  extension_set = peas_extension_set_new (engine,
+                                          INTROSPECTION_TYPE_CALLABLE,
+                                          NULL);
+
+  method = peas_extension_method_new (INTROSPECTION_TYPE_CALLABLE,
+                                      "call_no_args");
+
+  introspection_reset_calls ();
+  g_assert (peas_extension_set_call_parallel (extension_set, method));
+
+  /* The C extensions are called on the pool */
+  for (i = 0; i < G_N_ELEMENTS (native_plugins); ++i)
+    {
+      g_assert_cmpuint (introspection_get_n_calls (native_plugins[i]), ==, 1);
+      g_assert (introspection_get_call_thread (native_plugins[i]) != NULL);
+      g_assert (introspection_get_call_thread (native_plugins[i]) !=
+                g_thread_self ());
+    }
+
+  /* And the others on the calling thread */
+  module_name = peas_plugin_info_get_module_name (info);
+  if (g_strcmp0 (extension_plugin, "extension-c") != 0)
+    {
+      g_assert_cmpuint (introspection_get_n_calls (module_name), ==, 1);
+      g_assert (introspection_get_call_thread (module_name) ==
+                g_thread_self ());
+    }
+
+  peas_extension_method_unref (method);
+
+  /* The arguments are shared, so out arguments are rejected */
+  testing_util_push_log_hook ("*assertion*n_out_args == 0*failed");
+
+  method = peas_extension_method_new (INTROSPECTION_TYPE_CALLABLE,
+                                      "call_single_arg");
+
+  introspection_reset_calls ();
+  g_assert (!peas_extension_set_call_parallel (extension_set, method,
+                                               &called));
+  g_assert (!called);
+  g_assert_cmpuint (introspection_get_n_calls (module_name), ==, 0);
+
+  peas_extension_method_unref (method);
+  g_object_unref (extension_set);
+}
+
 static void
 test_extension_properties_construct_only (PeasEngine     *engine,
                                           PeasPluginInfo *info)
@@ -505,6 +628,8 @@ testing_extension_callable (const gchar *loader)
   _EXTENSION_TEST (loader, "call-with-return", call_with_return);
   _EXTENSION_TEST (loader, "call-single-arg", call_single_arg);
   _EXTENSION_TEST (loader, "call-multi-args", call_multi_args);
+  _EXTENSION_TEST (loader, "call-method", call_method);
+  _EXTENSION_TEST (loader, "call-parallel", call_parallel);
 }
 
 void
@@ -0,0 +1,461 @@
+/*
+ * trace.c
+ * This file is part of libpeas
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Library General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <libpeas/peas.h>
+
+#include "testing/testing.h"
+#include "introspection/introspection-callable.h"
+
+/* Quotes, a backslash, a tab and a non-ASCII character
+ * all have to survive being written as JSON
+ */
+#define PLUGIN_BASENAME "trace \"quoted\" back\\slash\ttab \xc3\xa9.plugin"
+
+static const gchar *test_program = NULL;
+
+typedef struct {
+  const gchar *p;
+  GPtrArray *strings;
+
+  /* A GHashTable for each object, mapping its keys
+   * to their value when it is a string and to NULL otherwise
+   */
+  GPtrArray *objects;
+} JsonParser;
+
+static gboolean parse_value (JsonParser *parser);
+
+static void
+skip_whitespace (JsonParser *parser)
+{
+  while (*parser->p == ' ' || *parser->p == '\t' ||
+         *parser->p == '\n' || *parser->p == '\r')
+    ++parser->p;
+}
+
+/* Adds the unescaped string to parser->strings */
+static gboolean
+parse_string (JsonParser *parser)
+{
+  GString *str;
+
+  if (*parser->p != '"')
+    return FALSE;
+
+  str = g_string_new (NULL);
+
+  for (++parser->p; *parser->p != '"'; ++parser->p)
+    {
+      /* Includes the end of the text */
+      if ((guchar) *parser->p < 0x20)
+        goto error;
+
+      if (*parser->p != '\\')
+        {
+          g_string_append_c (str, *parser->p);
+          continue;
+        }
+
+      switch (*++parser->p)
+        {
+        case '"':
+        case '\\':
+        case '/':
+          g_string_append_c (str, *parser->p);
+          break;
+        case 'b':
+          g_string_append_c (str, '\b');
+          break;
+        case 'f':
+          g_string_append_c (str, '\f');
+          break;
+        case 'n':
+          g_string_append_c (str, '\n');
+          break;
+        case 'r':
+          g_string_append_c (str, '\r');
+          break;
+        case 't':
+          g_string_append_c (str, '\t');
+          break;
+        case 'u':
+          {
+            gunichar c = 0;
+            guint i;
+
+            for (i = 0; i < 4; ++i)
+              {
+                gint digit = g_ascii_xdigit_value (*++parser->p);
+
+                if (digit < 0)
+                  goto error;
+
+                c = c * 16 + digit;
+              }
+
+            g_string_append_unichar (str, c);
+          }
+          break;
+        default:
+          goto error;
+        }
+    }
+
+  ++parser->p;
+  g_ptr_array_add (parser->strings, g_string_free (str, FALSE));
+  return TRUE;
+
+error:
+  g_string_free (str, TRUE);
+  return FALSE;
+}
+
+static gboolean
+parse_number (JsonParser *parser)
+{
+  const gchar *start;
+
+  if (*parser->p == '-')
+    ++parser->p;
+
+  start = parser->p;
+  while (g_ascii_isdigit (*parser->p))
+    ++parser->p;
+
+  if (parser->p == start)
+    return FALSE;
+
+  if (*parser->p == '.')
+    {
+      start = ++parser->p;
+      while (g_ascii_isdigit (*parser->p))
+        ++parser->p;
+
+      if (parser->p == start)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static gboolean
+parse_container (JsonParser *parser,
+                 gchar       end,
+                 gboolean    has_keys)
+{
+  GHashTable *members = NULL;
+
+  if (has_keys)
+    members = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+
+  ++parser->p;
+  skip_whitespace (parser);
+
+  if (*parser->p == end)
+    {
+      ++parser->p;
+      goto done;
+    }
+
+  while (TRUE)
+    {
+      gchar *key = NULL;
+      gboolean is_string;
+
+      skip_whitespace (parser);
+
+      if (has_keys)
+        {
+          if (!parse_string (parser))
+            goto error;
+
+          key = g_strdup (g_ptr_array_index (parser->strings,
+                                             parser->strings->len - 1));
+
+          skip_whitespace (parser);
+
+          if (*parser->p++ != ':')
+            {
+              g_free (key);
+              goto error;
+            }
+
+          skip_whitespace (parser);
+        }
+
+      is_string = *parser->p == '"';
+
+      if (!parse_value (parser))
+        {
+          g_free (key);
+          goto error;
+        }
+
+      if (has_keys)
+        {
+          const gchar *value = NULL;
+
+          if (is_string)
+            value = g_ptr_array_index (parser->strings,
+                                       parser->strings->len - 1);
+
+          g_hash_table_insert (members, key, g_strdup (value));
+        }
+
+      skip_whitespace (parser);
+
+      if (*parser->p == end)
+        {
+          ++parser->p;
+          goto done;
+        }
+
+      if (*parser->p++ != ',')
+        goto error;
+    }
+
+done:
+  if (members != NULL)
+    g_ptr_array_add (parser->objects, members);
+
+  return TRUE;
+
+error:
+  if (members != NULL)
+    g_hash_table_unref (members);
+
+  return FALSE;
+}
+
+static gboolean
+parse_value (JsonParser *parser)
+{
+  skip_whitespace (parser);
+
+  switch (*parser->p)
+    {
+    case '{':
+      return parse_container (parser, '}', TRUE);
+    case '[':
+      return parse_container (parser, ']', FALSE);
+    case '"':
+      return parse_string (parser);
+    case 't':
+    case 'f':
+    case 'n':
+      {
+        const gchar *literals[] = { "true", "false", "null" };
+        guint i;
+
+        for (i = 0; i < G_N_ELEMENTS (literals); ++i)
+          {
+            if (g_str_has_prefix (parser->p, literals[i]))
+              {
+                parser->p += strlen (literals[i]);
+                return TRUE;
+              }
+          }
+
+        return FALSE;
+      }
+    default:
+      return parse_number (parser);
+    }
+}
+
+/* Run by test_trace_write() in a new process with PEAS_TRACE set,
+ * tracing is set up when the PeasEngine class is initialized
+ */
+static void
+test_trace_child (void)
+{
+  const gchar *plugin_dir;
+  PeasEngine *engine;
+  PeasPluginInfo *info;
+  PeasExtension *extension;
+
+  plugin_dir = g_getenv ("TESTING_TRACE_PLUGIN_DIR");
+
+  if (g_getenv ("PEAS_TRACE") == NULL || plugin_dir == NULL)
+    return;
+
+  engine = testing_engine_new ();
+  peas_engine_add_search_path (engine, plugin_dir, NULL);
+
+  g_assert (peas_engine_get_plugin_info (engine, "trace") != NULL);
+
+  /* Records the load, call, garbage-collect and unload events */
+  info = peas_engine_get_plugin_info (engine, "extension-c");
+  g_assert (peas_engine_load_plugin (engine, info));
+
+  extension = peas_engine_create_extension (engine, info,
+                                            INTROSPECTION_TYPE_CALLABLE,
+                                            NULL);
+  g_assert (peas_extension_call (extension, "call_no_args"));
+  g_object_unref (extension);
+
+  g_assert (peas_engine_unload_plugin (engine, info));
+
+  testing_engine_free (engine);
+}
+
+/* Also removes the plugin cache written in the directory */
+static void
+remove_tmp_dir (const gchar *path)
+{
+  GDir *dir;
+  const gchar *name;
+
+  dir = g_dir_open (path, 0, NULL);
+  g_assert (dir != NULL);
+
+  while ((name = g_dir_read_name (dir)) != NULL)
+    {
+      gchar *filename = g_build_filename (path, name, NULL);
+
+      g_unlink (filename);
+      g_free (filename);
+    }
+
+  g_dir_close (dir);
+  g_rmdir (path);
+}
+
+static void
+test_trace_write (void)
+{
+  gchar *tmp_dir, *plugin_filename, *trace_filename, *contents;
+  gchar **envp;
+  gchar *argv[] = { NULL, "-q", "-p", "/trace/child", NULL };
+  gint exit_status;
+  JsonParser parser;
+  gboolean found = FALSE;
+  GError *error = NULL;
+  guint i, j;
+  static const gchar *event_names[] = {
+    "scan", "parse", "load", "unload", "call", "garbage-collect"
+  };
+
+  tmp_dir = g_dir_make_tmp ("libpeas-trace-XXXXXX", &error);
+  g_assert_no_error (error);
+
+  plugin_filename = g_build_filename (tmp_dir, PLUGIN_BASENAME, NULL);
+  g_file_set_contents (plugin_filename,
+                       "[Plugin]\nModule=trace\nName=Trace\n", -1, &error);
+  g_assert_no_error (error);
+
+  trace_filename = g_build_filename (tmp_dir, "trace.json", NULL);
+
+  envp = g_get_environ ();
+  envp = g_environ_setenv (envp, "PEAS_TRACE", trace_filename, TRUE);
+  envp = g_environ_setenv (envp, "TESTING_TRACE_PLUGIN_DIR", tmp_dir, TRUE);
+
+  argv[0] = (gchar *) test_program;
+
+  g_spawn_sync (NULL, argv, envp, G_SPAWN_DEFAULT,
+                NULL, NULL, NULL, NULL, &exit_status, &error);
+  g_assert_no_error (error);
+  g_spawn_check_exit_status (exit_status, &error);
+  g_assert_no_error (error);
+
+  g_file_get_contents (trace_filename, &contents, NULL, &error);
+  g_assert_no_error (error);
+  g_assert (g_utf8_validate (contents, -1, NULL));
+
+  parser.p = contents;
+  parser.strings = g_ptr_array_new_with_free_func (g_free);
+  parser.objects = g_ptr_array_new_with_free_func ((GDestroyNotify) g_hash_table_unref);
+
+  g_assert (parse_value (&parser));
+  skip_whitespace (&parser);
+  g_assert_cmpint (*parser.p, ==, '\0');
+
+  /* The filename comes back unchanged from the parse event */
+  for (i = 0; i < parser.strings->len; ++i)
+    {
+      if (g_str_has_suffix (g_ptr_array_index (parser.strings, i),
+                            G_DIR_SEPARATOR_S PLUGIN_BASENAME))
+        found = TRUE;
+    }
+
+  g_assert (found);
+
+  /* Every kind of event is recorded as a complete event */
+  for (i = 0; i < G_N_ELEMENTS (event_names); ++i)
+    {
+      found = FALSE;
+
+      for (j = 0; j < parser.objects->len && !found; ++j)
+        {
+          GHashTable *event = g_ptr_array_index (parser.objects, j);
+
+          if (g_strcmp0 (g_hash_table_lookup (event, "name"),
+                         event_names[i]) != 0 ||
+              g_strcmp0 (g_hash_table_lookup (event, "ph"), "X") != 0)
+            continue;
+
+          /* Numbers, not strings */
+          g_assert (g_hash_table_contains (event, "ts"));
+          g_assert (g_hash_table_lookup (event, "ts") == NULL);
+          g_assert (g_hash_table_contains (event, "dur"));
+          g_assert (g_hash_table_lookup (event, "dur") == NULL);
+
+          found = TRUE;
+        }
+
+      g_assert_cmpstr (found ? event_names[i] : NULL, ==, event_names[i]);
+    }
+
+  g_ptr_array_unref (parser.objects);
+  g_ptr_array_unref (parser.strings);
+  g_free (contents);
+  g_strfreev (envp);
+
+  remove_tmp_dir (tmp_dir);
+
+  g_free (trace_filename);
+  g_free (plugin_filename);
+  g_free (tmp_dir);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  test_program = argv[0];
+
+  g_test_init (&argc, &argv, NULL);
+
+  g_type_init ();
+
+  testing_init ();
+
+  g_test_add_func ("/trace/write", test_trace_write);
+  g_test_add_func ("/trace/child", test_trace_child);
+
+  return testing_run_tests ();
+}
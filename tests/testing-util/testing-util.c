@@ -40,6 +40,9 @@ typedef struct {
 static PeasEngine *engine = NULL;
 static GPtrArray *log_hooks = NULL;
 
+/* Warnings can be logged from the worker threads of libpeas */
+static GMutex log_hooks_lock;
+
 /* These are warnings and criticals that just have to happen
  * for testing purposes and as such we don't want to abort on them.
  *
@@ -79,6 +82,8 @@ log_handler (const gchar    *log_domain,
       abort ();
     }
 
+  g_mutex_lock (&log_hooks_lock);
+
   for (i = 0; i < log_hooks->len; ++i)
     {
       LogHook *hook = g_ptr_array_index (log_hooks, i);
@@ -86,10 +91,13 @@ log_handler (const gchar    *log_domain,
       if (g_pattern_match_simple (hook->pattern, message))
         {
           hook->hit = TRUE;
+          g_mutex_unlock (&log_hooks_lock);
           return;
         }
     }
 
+  g_mutex_unlock (&log_hooks_lock);
+
   /* Check the allowed_patterns after the log hooks to
    * avoid issues when an allowed_pattern would match a hook
    */
@@ -135,6 +143,9 @@ testing_util_init (void)
 
   g_setenv ("PEAS_PLUGIN_LOADERS_DIR", BUILDDIR "/loaders", TRUE);
 
+  /* Don't write the plugin cache into the user's cache directory */
+  g_setenv ("PEAS_PLUGIN_CACHE_DIR", BUILDDIR "/tests/plugin-cache", TRUE);
+
   g_irepository_require (g_irepository_get_default (), "Peas", "1.0", 0, &error);
   g_assert_no_error (error);
 
@@ -213,7 +224,9 @@ testing_util_push_log_hook (const gchar *pattern)
   hook->pattern = pattern;
   hook->hit = FALSE;
 
+  g_mutex_lock (&log_hooks_lock);
   g_ptr_array_add (log_hooks, hook);
+  g_mutex_unlock (&log_hooks_lock);
 }
 
 /* Optional - see testing_util_engine_free() */
@@ -230,7 +243,9 @@ testing_util_pop_log_hook (void)
   if (!hook->hit)
     testing_util_pop_log_hooks ();
 
+  g_mutex_lock (&log_hooks_lock);
   g_ptr_array_remove_index (log_hooks, log_hooks->len - 1);
+  g_mutex_unlock (&log_hooks_lock);
 }
 
 void
@@ -285,5 +300,7 @@ testing_util_pop_log_hooks (void)
 
   g_ptr_array_unref (unhit_hooks);
 
+  g_mutex_lock (&log_hooks_lock);
   g_ptr_array_set_size (log_hooks, 0);
+  g_mutex_unlock (&log_hooks_lock);
 }